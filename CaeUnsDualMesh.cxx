@@ -8,47 +8,49 @@
  *
  ***************************************************************************/
 
-#include <cmath>
+#include <cstdio>
 #include <cstring>
+#include <string>
 
 #include "CaeUnsGridModel.h"
 #include "CaeUnsDualMesh.h"
-#include "FanSorter.h"
+#include "DualMeshBuilder.h"
+#include "DualPlacement.h"
+#include "DualMeshBvhWriter.h"
+#include "DualMeshChunkWriter.h"
+#include "DualMeshMemoryMonitor.h"
+#include "DualMeshPartWriter.h"
+#include "DualMeshShmWriter.h"
+#include "DualMeshTclWriter.h"
+#include "DualMeshVtuWriter.h"
+#include "DualRegion.h"
+#include "DualTrace.h"
+#include "DualVariant.h"
+#include "MemoryStats.h"
 #include "PluginTypes.h"
+#include "TriMesh.h"
 
 static const char *attrDebugDump    = "DebugDump";
 static const char *attrMaxTurnAngle = "MaxTurnAngle";
-
-
-//***************************************************************************
-//***************************************************************************
-//***************************************************************************
-
-static void
-projectPtToLineSeg(const Vec3 &pt, const Vec3 &v0, const Vec3 &v1, Vec3 &projPt)
-{
-    // project pt onto line segment (v0, v1)
-    const Vec3::value_type lenSq = (v1 - v0).length_squared();
-    if (lenSq < 1.0e-8) {
-        // v0 == v1
-        projPt = v0;
-    }
-    else {
-        // Given line parameterized as v0 + t (v1 - v0). Find projection of
-        // point pt onto the line.
-        //    t = [(pt-v0) dot (v1-v0)] / lenSq
-        const Vec3::value_type t = cml::dot(pt - v0, v1 - v0) / lenSq;
-        if (t < 0.0) {
-            projPt = v0; // Beyond the 'v0' end of the segment
-        }
-        else if (t > 1.0) {
-            projPt = v1;  // Beyond the 'v1' end of the segment
-        }
-        else {
-            projPt = v0 + t * (v1 - v0);  // Falls on the segment
-        }
-    }
-}
+static const char *attrPlacement    = "DualVertexPlacement";
+static const char *attrDualEdges    = "DualEdges";
+static const char *attrAggLevels    = "AggLevels";
+static const char *attrIncremental  = "IncrementalUpdate";
+static const char *attrTopoCache    = "TopologyCache";
+static const char *attrMemReport    = "MemoryReport";
+static const char *attrMemBudget    = "MemoryBudget";
+static const char *attrPartitions   = "Partitions";
+static const char *attrPolygonBvh   = "PolygonBvh";
+static const char *attrVariants     = "Variants";
+static const char *attrRegionBox    = "RegionBox";
+static const char *attrRegionBCs    = "RegionBCs";
+static const char *attrRegionBand   = "RegionBandLayers";
+static const char *attrSharedMemory = "SharedMemory";
+static const char *attrEstimateOnly = "EstimateOnly";
+static const char *attrSymmetryBC   = "SymmetryBC";
+
+// The fans of the previous export in this session
+static DualFanCache fanCache;
 
 
 //***************************************************************************
@@ -58,23 +60,33 @@ projectPtToLineSeg(const Vec3 &pt, const Vec3 &v0, const Vec3 &v1, Vec3 &projPt)
 CaeUnsDualMesh::CaeUnsDualMesh(CAEP_RTITEM *pRti, PWGM_HGRIDMODEL
         model, const CAEP_WRITEINFO *pWriteInfo) :
     CaeUnsPlugin(pRti, model, pWriteInfo),
-    cosMaxTurnAngle_(0.0),
-    dumpFile_(),
-    gceVertToGceCells_(),
-    gceVertToHardGceEdges_(),
-    hardGceVertToDualVert_(),
-    hardGceEdgeToDualVert_(),
-    hardGceVerts_(),
-    hardGceEdges_(),
-    numCentroids_(0),
-    numBndryMids_(0),
-    numCnxnMids_(0)
+    traceFile_(),
+    topoCacheFile_(),
+    keepFanCache_(false),
+    xyz_(),
+    tris_(),
+    builder_(),
+    region_(),
+    symVerts_(),
+    variants_(),
+    numParts_(1),
+    polygonBvh_(false),
+    estimateOnly_(false),
+    estimator_(),
+    estimateFormat_(DualCostEstimator::TclFormat),
+    numBndryFaces_(0),
+    numCnxnFaces_(0),
+    fileSink_(0),
+    bvhWriter_(*this),
+    mirror_(bvhWriter_),
+    memMonitor_(mirror_)
 {
 }
 
 
 CaeUnsDualMesh::~CaeUnsDualMesh()
 {
+    delete fileSink_;
 }
 
 
@@ -91,27 +103,266 @@ CaeUnsDualMesh::beginExport()
     PWP_BOOL doDump;
     model_.getAttribute(attrDebugDump, doDump);
 
-    const double Deg2Rad = 3.1415926535897932384626433832795 / 180.0;
     PWP_REAL maxTurnAngle;
     model_.getAttribute(attrMaxTurnAngle, maxTurnAngle);
-    cosMaxTurnAngle_ = cos(maxTurnAngle * Deg2Rad);
+    builder_.setMaxTurnAngle(maxTurnAngle);
+
+    const char *placementName = 0;
+    DualPlacement::Strategy placement = DualPlacement::Centroid;
+    if (model_.getAttribute(attrPlacement, placementName) &&
+            !DualPlacement::fromName(placementName, placement)) {
+        sendWarningMsg("unknown DualVertexPlacement. Using Centroid.", 0);
+    }
+    builder_.setPlacement(placement);
+
+    PWP_BOOL dualEdges;
+    model_.getAttribute(attrDualEdges, dualEdges);
+
+    PWP_UINT aggLevels;
+    model_.getAttribute(attrAggLevels, aggLevels);
+
+    symVerts_.clear();
+    mirror_.clearPlane();
+    const char *symmetryBC = 0;
+    if (model_.getAttribute(attrSymmetryBC, symmetryBC) &&
+            (0 != symmetryBC)) {
+        addBCVerts(attrSymmetryBC, symmetryBC, symVerts_);
+    }
+    if (!symVerts_.empty() && (dualEdges || (0 < aggLevels))) {
+        sendWarningMsg("SymmetryBC: dual edges and agglomeration levels can "
+            "not be mirrored. They are not written.", 0);
+        dualEdges = false;
+        aggLevels = 0;
+    }
+    builder_.setDualEdges(dualEdges ? true : false);
+    builder_.setAggLevels(aggLevels);
+
+    const char *variantList = 0;
+    variants_.clear();
+    std::string badToken;
+    if (model_.getAttribute(attrVariants, variantList) &&
+            !DualVariant::parseList(variantList,
+                DualVariant(maxTurnAngle, placement), variants_, badToken)) {
+        const std::string msg = "Variants: invalid option " + badToken +
+            ". No variants are written.";
+        sendWarningMsg(msg.c_str(), 0);
+        variants_.clear();
+    }
+
+    PWP_BOOL incremental;
+    model_.getAttribute(attrIncremental, incremental);
+    if (!incremental) {
+        fanCache.clear();
+    }
+    PWP_BOOL topoCache;
+    model_.getAttribute(attrTopoCache, topoCache);
+    topoCacheFile_.clear();
+    if (topoCache) {
+        topoCacheFile_ = std::string(writeInfo_.fileDest) + ".dtc";
+    }
+    // The variants reuse the fans of the previous run
+    builder_.setFanCache((incremental || topoCache || !variants_.empty()) ?
+        &fanCache : 0);
+    keepFanCache_ = incremental ? true : false;
+
+    PWP_BOOL memReport;
+    model_.getAttribute(attrMemReport, memReport);
+    memMonitor_.setReport(memReport ? true : false);
+
+    PWP_REAL memBudget;
+    model_.getAttribute(attrMemBudget, memBudget);
+    memMonitor_.setBudget((memBudget > 0.0) ?
+        size_t(memBudget * 1024.0 * 1024.0) : 0);
+    memMonitor_.begin();
+
+    region_.clear();
+    const char *regionBox = 0;
+    Vec3 boxLo;
+    Vec3 boxHi;
+    if (model_.getAttribute(attrRegionBox, regionBox) && (0 != regionBox) &&
+            ('\0' != regionBox[strspn(regionBox, " \t")])) {
+        if (DualRegion::parseBox(regionBox, boxLo, boxHi)) {
+            region_.setBox(boxLo, boxHi);
+        }
+        else {
+            sendWarningMsg("RegionBox is not 6 numbers. Ignored.", 0);
+        }
+    }
+    const char *regionBCs = 0;
+    UInt32Array1 regionVerts;
+    if (model_.getAttribute(attrRegionBCs, regionBCs) && (0 != regionBCs)) {
+        addBCVerts(attrRegionBCs, regionBCs, regionVerts);
+    }
+    if (!regionVerts.empty()) {
+        region_.addVerts(&regionVerts[0], UInt32(regionVerts.size()));
+    }
+    PWP_UINT regionBand;
+    model_.getAttribute(attrRegionBand, regionBand);
+    region_.setHardBand(regionBand);
+    const bool isRegion = region_.isSet();
+    builder_.setRegion(isRegion ? &region_ : 0);
+
+    PWP_UINT numParts;
+    model_.getAttribute(attrPartitions, numParts);
+    numParts_ = numParts;
+
+    PWP_BOOL polygonBvh;
+    model_.getAttribute(attrPolygonBvh, polygonBvh);
+    polygonBvh_ = polygonBvh ? true : false;
+    bvhWriter_.setFileName(polygonBvh_ ?
+        std::string(writeInfo_.fileDest) + ".bvh" : std::string());
+
+    const bool isVtu = DualMeshVtuWriter::isVtuFileName(writeInfo_.fileDest);
+    const bool isChunk =
+        DualMeshChunkWriter::isChunkFileName(writeInfo_.fileDest);
+    const char *shmName = 0;
+    const bool isShm = model_.getAttribute(attrSharedMemory, shmName) &&
+        (0 != shmName) && ('\0' != shmName[strspn(shmName, " \t")]);
+
+    PWP_BOOL estimateOnly;
+    model_.getAttribute(attrEstimateOnly, estimateOnly);
+    estimateOnly_ = estimateOnly ? true : false;
+    if (estimateOnly_) {
+        estimateFormat_ = DualCostEstimator::TclFormat;
+        if (isShm) {
+            estimateFormat_ = DualCostEstimator::ShmFormat;
+        }
+        else if (1 < numParts) {
+            estimateFormat_ = DualCostEstimator::PartFormat;
+        }
+        else if (isVtu) {
+            estimateFormat_ = DualCostEstimator::VtuFormat;
+        }
+        else if (isChunk) {
+            estimateFormat_ = DualCostEstimator::ChunkFormat;
+        }
+        estimator_.setSinglePrecision(PWP_PRECISION_SINGLE ==
+            writeInfo_.precision);
+        estimator_.setDualEdges(dualEdges ? true : false);
+        estimator_.setAggLevels(aggLevels);
+        estimator_.setFanCache(incremental || topoCache);
+        estimator_.setVariantCount(UInt32(variants_.size()));
+        // sample cells, stream faces
+        setProgressMajorSteps(2);
+        // The export file only records that no dual mesh was written
+        return rtFile_.write("# dual mesh cost estimate only\n");
+    }
+
+    if (isShm) {
+        // The export file only records where the dual mesh went
+        DualMeshShmWriter *shmWriter = new DualMeshShmWriter(shmName);
+        fileSink_ = shmWriter;
+        const std::string note = "# dual mesh published to the shared "
+            "memory segment " + shmWriter->name() + "\n";
+        if (!rtFile_.write(note.c_str())) {
+            return false;
+        }
+    }
+    else if (1 < numParts) {
+        // The export file is the text manifest of the binary part files
+        fileSink_ = new DualMeshPartWriter(rtFile_.fp(), writeInfo_.fileDest,
+            numParts);
+    }
+    else if (isVtu || isChunk) {
+        // The file was opened for ascii output. The VTU appended data and the
+        // chunk container are raw binary and must not be newline translated.
+        if (!rtFile_.close() ||
+                !rtFile_.open(writeInfo_.fileDest, pwpWrite | pwpBinary)) {
+            sendErrorMsg("could not open file for binary write!", 0);
+            return false;
+        }
+        if (isVtu) {
+            fileSink_ = new DualMeshVtuWriter(rtFile_.fp(),
+                PWP_PRECISION_SINGLE == writeInfo_.precision);
+        }
+        else {
+            fileSink_ = new DualMeshChunkWriter(rtFile_.fp());
+        }
+    }
 
-    char filename[512];
-    strcpy(filename, writeInfo_.fileDest);
-    strcat(filename, ".dump");
+    // Events are recorded into in-memory rings and only written to disk
+    // after the export. Decode the file with the dualtrace tool.
+    const std::string filename = std::string(writeInfo_.fileDest) + ".trace";
+    DualTrace::clear();
+    DualTrace::enable(doDump ? true : false);
     if (!doDump) {
-        // remove dump file if it exists from previous run
-        pwpFileDelete(filename);
+        // remove trace file if it exists from previous run
+        pwpFileDelete(filename.c_str());
     }
     else {
-        dumpFile_.open(filename, pwpWrite | pwpAscii);
-        sendInfoMsg("debug dump file:", 0);
-        sendInfoMsg(filename, 0);
-        if (!dumpFile_.isOpen()) {
-            sendErrorMsg("debug dump file open failed!", 0);
+        traceFile_ = filename;
+        sendInfoMsg("debug trace file:", 0);
+        sendInfoMsg(traceFile_.c_str(), 0);
+    }
+    // load vertices, load cells, stream faces + 5 builder steps
+    // + agglomeration for each run. A region is written in 4 builder steps.
+    UInt32 runSteps = (0 == aggLevels) ? 5 : 6;
+    if (isRegion) {
+        runSteps = 4;
+    }
+    setProgressMajorSteps(3 + runSteps * (1 + UInt32(variants_.size())));
+    return true;
+}
+
+
+void
+CaeUnsDualMesh::addBCVerts(const char *attrName, const char *names,
+    UInt32Array1 &verts)
+{
+    // names is a comma separated list. Spaces around a name are ignored.
+    const char *Spaces = " \t";
+    while ('\0' != *names) {
+        names += strspn(names, Spaces);
+        size_t len = strcspn(names, ",");
+        const char *next = names + len + ((',' == names[len]) ? 1 : 0);
+        while ((0 < len) && (0 != strchr(Spaces, names[len - 1]))) {
+            --len;
         }
+        if (0 < len) {
+            const std::string name(names, len);
+            bool found = false;
+            PWGM_CONDDATA cd;
+            CaeUnsPatch patch(model_);
+            for (; patch.isValid(); ++patch) {
+                if (!patch.condition(cd) || (0 == cd.name) ||
+                        (name != cd.name)) {
+                    continue;
+                }
+                found = true;
+                PWGM_ELEMDATA ed;
+                CaeUnsPatchElement elem(patch);
+                for (; elem.data(ed); ++elem) {
+                    verts.insert(verts.end(), ed.index,
+                        ed.index + ed.vertCnt);
+                }
+            }
+            if (!found) {
+                const std::string msg = std::string(attrName) +
+                    ": no boundary condition named " + name;
+                sendWarningMsg(msg.c_str(), 0);
+            }
+        }
+        names = next;
+    }
+}
+
+
+bool
+CaeUnsDualMesh::setSymmetryPlane()
+{
+    Vec3 normal;
+    double offset;
+    if (!DualMeshMirror::fitPlane(builder_.mesh(), symVerts_, normal,
+            offset)) {
+        sendErrorMsg("SymmetryBC: the boundary vertices are not on a plane",
+            0);
+        return false;
     }
-    setProgressMajorSteps(4);
+    mirror_.setPlane(normal, offset);
+    char msg[160];
+    sprintf(msg, "mirroring across the symmetry plane %.6g %.6g %.6g %.6g",
+        normal[0], normal[1], normal[2], offset);
+    sendInfoMsg(msg, 0);
     return true;
 }
 
@@ -119,161 +370,236 @@ CaeUnsDualMesh::beginExport()
 PWP_BOOL
 CaeUnsDualMesh::write()
 {
-    writeGceVertices();
-    numCentroids_ = model_.elementCount();
-    bool ret = progressBeginStep(numCentroids_);
+    if (estimateOnly_) {
+        return writeEstimate();
+    }
+    MemoryStats::Scope memScope(MemoryStats::Mesh);
+    bool ret = loadVertices() && loadElements();
     if (ret) {
-        rtFile_.write(numCentroids_, "\n", "# Element centroid points ");
-        PWGM_ELEMDATA ed;
-        PWP_UINT32 dualNdx = 0;
-        CaeUnsElement elem(model_);
-        while (elem.data(ed)) {
-            writeVertex(dualNdx++, centroid(ed), ElemVert);
-            addElement(elem.index(), ed);
-            if (!progressIncrement()) {
-                ret = false;
-                break;
+        builder_.setMesh(TriMesh(xyz_.empty() ? 0 : &xyz_[0],
+            UInt32(xyz_.size() / 3), tris_.empty() ? 0 : &tris_[0],
+            UInt32(tris_.size() / 3)));
+        ret = symVerts_.empty() || setSymmetryPlane();
+        // PWGM_FACEORDER_BOUNDARYONLY
+        ret = ret && model_.streamFaces(PWGM_FACEORDER_BOUNDARYFIRST, *this);
+        // A region export does not use the fans
+        const bool useTopoCache = !topoCacheFile_.empty() && !region_.isSet();
+        unsigned long long topoKey = 0;
+        if (ret && useTopoCache) {
+            MemoryStats::Scope fanScope(MemoryStats::Fans);
+            topoKey = DualFanCache::topologyKey(builder_.mesh(),
+                builder_.bndryMids(), builder_.cnxnMids(),
+                builder_.cosMaxTurnAngle());
+            if (fanCache.load(topoCacheFile_.c_str(), topoKey)) {
+                sendInfoMsg("using topology cache file:", 0);
+                sendInfoMsg(topoCacheFile_.c_str(), 0);
             }
-            ++elem;
         }
-        ret = progressEndStep() && ret;
+        mirror_.setCosMaxTurnAngle(builder_.cosMaxTurnAngle());
+        ret = ret && builder_.run(memMonitor_);
+        if (ret && (0 != fanCache.reusedVertexCount())) {
+            char msg[128];
+            sprintf(msg, "reused the polygons of %u vertices, rebuilt %u",
+                fanCache.reusedVertexCount(), fanCache.rebuiltVertexCount());
+            sendInfoMsg(msg, 0);
+        }
+        if (ret && useTopoCache &&
+                !fanCache.save(topoCacheFile_.c_str(), topoKey)) {
+            sendWarningMsg("topology cache file write failed!", 0);
+        }
+        ret = ret && writeVariants();
+        if (!keepFanCache_) {
+            fanCache.clear();
+        }
     }
-    if (ret) {
-        // PWGM_FACEORDER_BOUNDARYONLY
-        ret = model_.streamFaces(PWGM_FACEORDER_BOUNDARYFIRST, *this) &&
-                writePolys();
+    if (!traceFile_.empty()) {
+        // save trace even if export failed. That is when it is needed most.
+        DualTrace::enable(false);
+        if (!DualTrace::save(traceFile_.c_str())) {
+            sendErrorMsg("debug trace file write failed!", 0);
+        }
+        DualTrace::clear();
     }
     return ret;
 }
 
 
-void
-CaeUnsDualMesh::addElement(PWP_UINT32 elemNdx, const PWGM_ELEMDATA &ed)
+bool
+CaeUnsDualMesh::loadVertices()
 {
-    for (PWP_UINT32 ii = 0; ii < ed.vertCnt; ++ii) {
-        gceVertToGceCells_.insert(UInt32UInt32Array1MMap::value_type(
-            ed.index[ii], elemNdx));
+    const PWP_UINT32 numVerts = model_.vertexCount();
+    bool ret = memMonitor_.beginStep(numVerts);
+    if (ret) {
+        xyz_.resize(3 * size_t(numVerts));
+        PWGM_VERTDATA d;
+        CaeUnsVertex v(model_);
+        while (v.isValid()) {
+            if (!v.dataMod(d) || (d.i >= numVerts) ||
+                    !memMonitor_.incrementStep()) {
+                ret = false;
+                break;
+            }
+            double *p = &xyz_[3 * size_t(d.i)];
+            p[0] = d.x;
+            p[1] = d.y;
+            p[2] = d.z;
+            ++v;
+        }
     }
+    return memMonitor_.endStep() && ret;
 }
 
 
-void
-CaeUnsDualMesh::writeVertex(PWP_UINT32 dualNdx, const Vec3 &v, VertType vType)
+bool
+CaeUnsDualMesh::loadElements()
 {
-    static const char *vertTypeNames[] = {
-                            "Bndry ", // BndryVert,
-                            "Elem ",  // ElemVert,
-                            "Cnxn ",  // CnxnVert,
-                            "Gce "    // GceVert
-                        };
-    rtFile_.write("vertex ");
-    rtFile_.write(vertTypeNames[vType]);
-    rtFile_.write(dualNdx, " { ");
-    rtFile_.write(v[0], " ");
-    rtFile_.write(v[1], " ");
-    rtFile_.write(v[2], " }\n");
+    const PWP_UINT32 numCells = model_.elementCount();
+    bool ret = memMonitor_.beginStep(numCells);
+    if (ret) {
+        tris_.reserve(3 * size_t(numCells));
+        PWGM_ELEMDATA ed;
+        CaeUnsElement elem(model_);
+        while (elem.data(ed)) {
+            if (3 != ed.vertCnt) {
+                sendErrorMsg("only tri cells are supported!", 0);
+                ret = false;
+                break;
+            }
+            tris_.insert(tris_.end(), ed.index, ed.index + 3);
+            if (!memMonitor_.incrementStep()) {
+                ret = false;
+                break;
+            }
+            ++elem;
+        }
+    }
+    return memMonitor_.endStep() && ret;
 }
 
 
-void
-CaeUnsDualMesh::writeGceVertices()
+bool
+CaeUnsDualMesh::writeEstimate()
 {
-    PWGM_VERTDATA d;
-    CaeUnsVertex v(model_);
-    while (v.isValid()) {
-        v.dataMod(d);
-        rtFile_.write("gceVertex ");
-        rtFile_.write(d.i, " { ");
-        rtFile_.write(d.x, " ");
-        rtFile_.write(d.y, " ");
-        rtFile_.write(d.z, " }\n");
-        ++v;
+    // Only the counts are read. No coordinates are loaded.
+    estimator_.setMeshCounts(model_.vertexCount(), model_.elementCount());
+    numBndryFaces_ = 0;
+    numCnxnFaces_ = 0;
+    bool ret = sampleElements() &&
+        model_.streamFaces(PWGM_FACEORDER_BOUNDARYFIRST, *this);
+    if (ret) {
+        estimator_.setHardEdgeCounts(numBndryFaces_, numCnxnFaces_);
+        std::vector<std::string> lines;
+        estimator_.report(estimateFormat_, lines);
+        for (size_t ii = 0; ii < lines.size(); ++ii) {
+            sendInfoMsg(lines[ii].c_str(), 0);
+        }
     }
+    return ret;
 }
 
 
 bool
-CaeUnsDualMesh::writePolys()
-{
-    bool ret = progressBeginStep(model_.vertexCount());
-    if (ret && !gceVertToGceCells_.empty()) {
-        std::pair<UInt32UInt32Array1MMap::iterator,
-            UInt32UInt32Array1MMap::iterator> rng;
-        UInt32Array1 fanCells;
-        // The do/while loop expects rng.second to be the "end" of the previous
-        // loop. Must set rng.second for first pass.
-        rng.second = gceVertToGceCells_.begin();
-        do {
-            // Grab range using key from rng.second. After call, rng.first is
-            // the FIRST multimap item with key. rng.second is item just after
-            // LAST multimap item with key (first item in next range).
-            rng = gceVertToGceCells_.equal_range(rng.second->first);
-            // Presize the fanCells vector.
-            fanCells.resize(std::distance(rng.first, rng.second));
-            // Load the fanCells vector with subrange's cell indices. These
-            // cells surround gce vertex with index == rng.first->first.
-            UInt32UInt32Array1MMap::iterator it = rng.first;
-            for (size_t ii = 0; it != rng.second; ++it, ++ii) {
-                // cache gce cell index
-                fanCells[ii] = it->second;
-            }
-            // Sort cell indices in radial order around gce vertex. Multiple
-            // fans are possible if hard edges are encountered.
-            FanSorter sorter(dumpFile_, hardGceEdgeToDualVert_,
-                hardGceVertToDualVert_);
-            UInt32Array2 fans;
-            sorter.run(model_, rng.first->first, fanCells, fans);
-            UInt32Array2::const_iterator itFan = fans.begin();
-            for (; itFan != fans.end(); ++itFan) {
-                writePoly(rng.first->first, *itFan);
-            }
-            if (!progressIncrement()) {
+CaeUnsDualMesh::sampleElements()
+{
+    const PWP_UINT32 numCells = model_.elementCount();
+    bool ret = memMonitor_.beginStep(numCells);
+    if (ret) {
+        estimator_.beginValences();
+        PWGM_ELEMDATA ed;
+        CaeUnsElement elem(model_);
+        while (elem.data(ed)) {
+            if (3 != ed.vertCnt) {
+                sendErrorMsg("only tri cells are supported!", 0);
                 ret = false;
                 break;
             }
-        } while (gceVertToGceCells_.end() != rng.second);
-        // Debug dump hardGceEdgeToDualVert_ info
-        if (dumpFile_.isOpen()) {
-            dumpFile_.write("# hardGceEdgeToDualVert_\n");
-            EdgeToUInt32Map::const_iterator it =
-                hardGceEdgeToDualVert_.begin();
-            for (; it != hardGceEdgeToDualVert_.end(); ++it) {
-                dumpFile_.write(it->first[0], " ", "#    edge { ");
-                dumpFile_.write(it->first[1], " } ");
-                dumpFile_.write(it->second, "\n", "vert=");
+            estimator_.addTri(ed.index);
+            if (!memMonitor_.incrementStep()) {
+                ret = false;
+                break;
             }
+            ++elem;
         }
+        estimator_.endValences();
     }
-    return progressEndStep() && ret;
+    return memMonitor_.endStep() && ret;
 }
 
 
-void
-CaeUnsDualMesh::writePoly(PWP_UINT32 gceVertNdx, const UInt32Array1 &fanCells)
+bool
+CaeUnsDualMesh::writeVariants()
 {
-    if (hardGceVerts_.end() == hardGceVerts_.find(gceVertNdx)) {
-        // interior vertex. Cells form a full, 360 deg polygon
-        rtFile_.write("poly I { ");
+    // The loaded grid and hard edges are shared. Only the angle and
+    // placement dependent work is repeated.
+    bool ret = true;
+    for (UInt32 ii = 0; ret && (ii < UInt32(variants_.size())); ++ii) {
+        const DualVariant &variant = variants_[ii];
+        const std::string fileName = DualVariant::fileName(writeInfo_.fileDest,
+            ii + 1);
+        builder_.setMaxTurnAngle(variant.maxTurnAngle_);
+        builder_.setPlacement(variant.placement_);
+        bvhWriter_.setFileName(polygonBvh_ ? fileName + ".bvh" :
+            std::string());
+        PwpFile file;
+        DualMeshSink *sink = newVariantSink(file, fileName);
+        if (0 == sink) {
+            sendErrorMsg("could not open variant file for write!", 0);
+            ret = false;
+            break;
+        }
+        // The sink methods of this class forward to fileSink_
+        DualMeshSink *mainSink = fileSink_;
+        fileSink_ = sink;
+        memMonitor_.begin();
+        mirror_.setCosMaxTurnAngle(builder_.cosMaxTurnAngle());
+        ret = builder_.run(memMonitor_);
+        fileSink_ = mainSink;
+        delete sink;
+        ret = file.close() && ret;
+        if (ret) {
+            char msg[128];
+            sprintf(msg, "variant %u: reused the polygons of %u vertices, "
+                "rebuilt %u", ii + 1, fanCache.reusedVertexCount(),
+                fanCache.rebuiltVertexCount());
+            sendInfoMsg(msg, 0);
+            sendInfoMsg(fileName.c_str(), 0);
+        }
     }
-    else {
-        // boundary vertex. Cells form a partial, <360 deg polygon
-        rtFile_.write("poly B { ");
+    return ret;
+}
+
+
+DualMeshSink *
+CaeUnsDualMesh::newVariantSink(PwpFile &file, const std::string &fileName)
+{
+    const bool singlePrecision = (PWP_PRECISION_SINGLE ==
+        writeInfo_.precision);
+    const bool isParts = (1 < numParts_);
+    const bool isVtu = !isParts &&
+        DualMeshVtuWriter::isVtuFileName(fileName.c_str());
+    const bool isChunk = !isParts &&
+        DualMeshChunkWriter::isChunkFileName(fileName.c_str());
+    if (!file.open(fileName.c_str(),
+            pwpWrite | ((isVtu || isChunk) ? pwpBinary : pwpAscii))) {
+        return 0;
+    }
+    if (isParts) {
+        return new DualMeshPartWriter(file.fp(), fileName.c_str(), numParts_);
     }
-    UInt32Array1::const_iterator it = fanCells.begin();
-    for (; it != fanCells.end(); ++it) {
-        rtFile_.write(*it, " ");
+    else if (isVtu) {
+        return new DualMeshVtuWriter(file.fp(), singlePrecision);
     }
-    rtFile_.write("}\n");
+    else if (isChunk) {
+        return new DualMeshChunkWriter(file.fp());
+    }
+    return new DualMeshTclWriter(file.fp(), singlePrecision);
 }
 
 
 PWP_UINT32
 CaeUnsDualMesh::streamBegin(const PWGM_BEGINSTREAM_DATA &data)
 {
-    numBndryMids_ = data.numBoundaryFaces;
-    hardGceEdges_.reserve(numBndryMids_);
-    return rtFile_.write(data.numBoundaryFaces, "\n",
-        "# boundary mid points ") && progressBeginStep(numBndryMids_);
+    return memMonitor_.beginStep(data.totalNumFaces);
 }
 
 
@@ -283,208 +609,224 @@ CaeUnsDualMesh::streamFace(const PWGM_FACESTREAM_DATA &data)
     bool ret = false;
     switch (data.type) {
     case PWGM_FACETYPE_BOUNDARY:
-        ret = handleBndryFace(data);
+        if (estimateOnly_) {
+            ++numBndryFaces_;
+            ret = true;
+            break;
+        }
+        builder_.addBndryEdge(data.elemData.index[0], data.elemData.index[1],
+            data.owner.cellIndex);
+        ret = true;
         break;
     case PWGM_FACETYPE_INTERIOR:
         ret = true; // ignore interior faces
         break;
     case PWGM_FACETYPE_CONNECTION:
-        ret = handleCnxnFace(data);
+        if (estimateOnly_) {
+            ++numCnxnFaces_;
+            ret = true;
+            break;
+        }
+        builder_.addCnxnEdge(data.elemData.index[0], data.elemData.index[1],
+            data.owner.cellIndex, data.neighborCellIndex);
+        ret = true;
         break;
     }
-    return progressIncrement() && ret;
+    return memMonitor_.incrementStep() && ret;
 }
 
 
 PWP_UINT32
 CaeUnsDualMesh::streamEnd(const PWGM_ENDSTREAM_DATA &data)
 {
-    PWP_UINT32 ret = progressEndStep() && data.ok &&
-        progressBeginStep(PWP_UINT32(hardGceVerts_.size()));
-    if (ret) {
-        // capture starting dual index for any exported GCE points
-        PWP_UINT32 dualNdx = numCnxnMids_ + numBndryMids_ + numCentroids_;
-        std::pair<UInt32UInt32Array1MMap::iterator,
-            UInt32UInt32Array1MMap::iterator> rng;
-        // The do/while loop expects rng.second to be the "end" of the previous
-        // loop. Must set rng.second for first pass.
-        rng.second = gceVertToHardGceEdges_.begin();
-        do {
-            PWP_UINT32 gceVertNdx = rng.second->first;
-            // Grab range using key from rng.second. After call, rng.first is
-            // the FIRST multimap item with key. rng.second is item just after
-            // LAST multimap item with key (first item in next range).
-            rng = gceVertToHardGceEdges_.equal_range(gceVertNdx);
-            // assume we are not exporting this GCE point
-            bool exportGceVertex = false;
-            if (2 == std::distance(rng.first, rng.second)) {
-                // Get the 2 hard edges radiating from gceVertNdx and force
-                // gceVertNdx to be first
-                Edge e0(hardGceEdges_.at(rng.first->second));
-                if (e0[0] != gceVertNdx) {
-                    std::swap(e0[0], e0[1]);
-                }
-                ++rng.first;
-                Edge e1(hardGceEdges_.at(rng.first->second));
-                if (e1[0] != gceVertNdx) {
-                    std::swap(e1[0], e1[1]);
-                }
-                if ((e0[0] != gceVertNdx) || (e1[0] != gceVertNdx)) {
-                    // should never get here
-                    ret = 0;
-                    break;
-                }
-                // if angle between hard edges e0/e1 > limit, export the gce vertex
-                Vec3 v0;
-                Vec3 v1;
-                Vec3 v2;
-                if (!getCoord(gceVertNdx, v0) || !getCoord(e0[1], v1) ||
-                        !getCoord(e1[1], v2)) {
-                    ret = 0;
-                    break;
-                }
-                double d = cml::dot((v1 - v0).normalize(),
-                                    (v0 - v2).normalize());
-                if (d < cosMaxTurnAngle_) {
-                    exportGceVertex = true;
-                }
-            }
-            else if (2 < std::distance(rng.first, rng.second)) {
-                // Always export when more than 2 hard egdes touch gceVertNdx
-                exportGceVertex = true;
-            }
-            else {
-                // should never get here
-                ret = 0;
-                break;
-            }
-            if (exportGceVertex) {
-                Vec3 v;
-                if (!getCoord(gceVertNdx, v)) {
-                    ret = 0;
-                    break;
-                }
-                // add gce to dual vertex mapping
-                hardGceVertToDualVert_.insert(
-                    UInt32ToUInt32Map::value_type(gceVertNdx, dualNdx));
-                writeVertex(dualNdx++, v, GceVert);
-            }
-            if (!progressIncrement()) {
-                ret = 0;
-                break;
-            }
-        } while (gceVertToHardGceEdges_.end() != rng.second);
-    }
-    return progressEndStep() && ret;
+    return memMonitor_.endStep() && data.ok;
 }
 
 
 bool
-CaeUnsDualMesh::handleBndryFace(const PWGM_FACESTREAM_DATA &data)
+CaeUnsDualMesh::writeGceVertex(UInt32 gceVertNdx, const Vec3 &v)
 {
-    PWP_UINT32 dualNdx = data.face + numCentroids_;
-    addHardEdge(dualNdx, data.elemData);
-    // Project the boundary cell's centroid onto the edge.
-    bool ret = false;
-    Vec3 pt;
-    if (projectCellCentroidToEdge(data.owner.cellIndex, data.elemData, pt)) {
-        writeVertex(dualNdx, pt, BndryVert);
-        ret = true;
+    if (0 != fileSink_) {
+        return fileSink_->writeGceVertex(gceVertNdx, v);
     }
-    return ret;
+    return rtFile_.write("gceVertex ") &&
+        rtFile_.write(gceVertNdx, " { ") &&
+        rtFile_.write(v[0], " ") &&
+        rtFile_.write(v[1], " ") &&
+        rtFile_.write(v[2], " }\n");
 }
 
 
 bool
-CaeUnsDualMesh::handleCnxnFace(const PWGM_FACESTREAM_DATA &data)
+CaeUnsDualMesh::beginCentroids(UInt32 count)
 {
-    PWP_UINT32 dualNdx = numCnxnMids_ + numBndryMids_ + numCentroids_;
-    addHardEdge(dualNdx, data.elemData);
-    // Project the connection owner/neighbor cell centroids onto the edge and
-    // average them. If the cells are highly skewed, this will produce poor
-    // results becasue the projection is clipped to the edge endpoints.
-    bool ret = false;
-    Vec3 pt0;
-    Vec3 pt1;
-    if (projectCellCentroidToEdge(data.owner.cellIndex, data.elemData, pt0) &&
-            projectCellCentroidToEdge(data.neighborCellIndex, data.elemData, pt1)) {
-        writeVertex(dualNdx, (pt0 += pt1) /= 2.0, CnxnVert);
-        ret = true;
+    if (0 != fileSink_) {
+        return fileSink_->beginCentroids(count);
     }
-    ++numCnxnMids_;
-    return ret;
+    return rtFile_.write(count, "\n", "# Element centroid points ");
 }
 
 
-void
-CaeUnsDualMesh::addHardEdge(PWP_UINT32 dualNdx, const PWGM_ELEMDATA &elemData)
+bool
+CaeUnsDualMesh::beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids)
 {
-    Edge edge(elemData.index[0], elemData.index[1]);
-    hardGceEdgeToDualVert_.insert(EdgeToUInt32Map::value_type(edge, dualNdx));
-    hardGceVerts_.insert(elemData.index[0]);
-    hardGceVerts_.insert(elemData.index[1]);
-    gceVertToHardGceEdges_.insert(UInt32UInt32Array1MMap::value_type(
-        elemData.index[0], PWP_UINT32(hardGceEdges_.size())));
-    gceVertToHardGceEdges_.insert(UInt32UInt32Array1MMap::value_type(
-        elemData.index[1], PWP_UINT32(hardGceEdges_.size())));
-    hardGceEdges_.push_back(edge);
+    if (0 != fileSink_) {
+        return fileSink_->beginHardMids(numBndryMids, numCnxnMids);
+    }
+    return rtFile_.write(numBndryMids, "\n", "# boundary mid points ");
 }
 
 
 bool
-CaeUnsDualMesh::projectCellCentroidToEdge(PWP_UINT32 cellNdx,
-    const PWGM_ELEMDATA &edgeElemData, Vec3 &edgePt)
+CaeUnsDualMesh::writeVertex(UInt32 dualNdx, const Vec3 &v, VertType vType)
 {
-    // Project the boundary cell's centroid onto the edge.
-    bool ret = false;
-    PWGM_ELEMDATA cellElemData;
-    Vec3 v0;
-    Vec3 v1;
-    if (CaeUnsElement(model_, cellNdx).data(cellElemData) &&
-            getCoord(edgeElemData.index[0], v0) &&
-            getCoord(edgeElemData.index[1], v1)) {
-        projectPtToLineSeg(centroid(cellElemData), v0, v1, edgePt);
-        ret = true;
+    if (0 != fileSink_) {
+        return fileSink_->writeVertex(dualNdx, v, vType);
     }
-    return ret;
+    static const char *vertTypeNames[] = {
+                            "Bndry ", // BndryVert,
+                            "Elem ",  // ElemVert,
+                            "Cnxn ",  // CnxnVert,
+                            "Gce "    // GceVert
+                        };
+    return rtFile_.write("vertex ") &&
+        rtFile_.write(vertTypeNames[vType]) &&
+        rtFile_.write(dualNdx, " { ") &&
+        rtFile_.write(v[0], " ") &&
+        rtFile_.write(v[1], " ") &&
+        rtFile_.write(v[2], " }\n");
 }
 
 
-const Vec3&
-CaeUnsDualMesh::centroid(const PWGM_ELEMDATA &ed) const
+bool
+CaeUnsDualMesh::writePoly(UInt32 gceVertNdx, bool isBndry,
+    const UInt32Array1 &dualVerts)
 {
-    static Vec3 ret;
-    CaeUnsVertex v(model_, ed.index[0]);
-    PWGM_VERTDATA vd;
-    if (v.dataMod(vd)) {
-        ret.set(vd.x, vd.y, vd.z);
-        for (PWP_UINT32 ii = 1; ii < ed.vertCnt; ++ii) {
-            if (v.moveTo(model_, ed.index[ii]).dataMod(vd)) {
-                ret += Vec3(vd.x, vd.y, vd.z);
-            }
-            else {
-                ret.zero();
-                break;
-            }
-        }
-        ret /= ed.vertCnt;
+    if (0 != fileSink_) {
+        return fileSink_->writePoly(gceVertNdx, isBndry, dualVerts);
+    }
+    bool ret;
+    if (!isBndry) {
+        // interior vertex. Cells form a full, 360 deg polygon
+        ret = rtFile_.write("poly I { ");
     }
     else {
-        ret.zero();
+        // boundary vertex. Cells form a partial, <360 deg polygon
+        ret = rtFile_.write("poly B { ");
     }
-    return ret;
+    UInt32Array1::const_iterator it = dualVerts.begin();
+    for (; ret && (it != dualVerts.end()); ++it) {
+        ret = rtFile_.write(*it, " ");
+    }
+    return ret && rtFile_.write("}\n");
 }
 
 
 bool
-CaeUnsDualMesh::getCoord(PWP_UINT32 ndx, Vec3& v) const
+CaeUnsDualMesh::writePolyEdges(UInt32 polyNdx, const UInt32Array1 &dualEdges)
 {
-    PWGM_VERTDATA vd;
-    bool ret = CaeUnsVertex(model_, ndx).dataMod(vd);
-    if (ret) {
-        v.set(vd.x, vd.y, vd.z);
+    if (0 != fileSink_) {
+        return fileSink_->writePolyEdges(polyNdx, dualEdges);
     }
-    return ret;
+    bool ret = rtFile_.write(polyNdx, " { ", "polyEdges ");
+    UInt32Array1::const_iterator it = dualEdges.begin();
+    for (; ret && (it != dualEdges.end()); ++it) {
+        ret = rtFile_.write(*it, " ");
+    }
+    return ret && rtFile_.write("}\n");
+}
+
+
+bool
+CaeUnsDualMesh::beginDualEdges(UInt32 count)
+{
+    if (0 != fileSink_) {
+        return fileSink_->beginDualEdges(count);
+    }
+    return rtFile_.write(count, "\n", "# dual edges ");
+}
+
+
+bool
+CaeUnsDualMesh::writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+    UInt32 leftPoly, UInt32 rightPoly)
+{
+    if (0 != fileSink_) {
+        return fileSink_->writeDualEdge(edgeNdx, dualVerts, leftPoly, rightPoly);
+    }
+    // boundary edges have no right polygon
+    return rtFile_.write(edgeNdx, " { ", "dualEdge ") &&
+        rtFile_.write(dualVerts[0], " ") &&
+        rtFile_.write(dualVerts[1], " } ") &&
+        rtFile_.write(leftPoly, " ") &&
+        rtFile_.write((UInt32Undef == rightPoly) ? PWP_INT32(-1) :
+            PWP_INT32(rightPoly), "\n");
+}
+
+
+bool
+CaeUnsDualMesh::writeAggLevel(UInt32 level, UInt32 numCoarse,
+    const UInt32Array1 &fineToCoarse)
+{
+    if (0 != fileSink_) {
+        return fileSink_->writeAggLevel(level, numCoarse, fineToCoarse);
+    }
+    bool ret = rtFile_.write(level, " ", "aggLevel ") &&
+        rtFile_.write(numCoarse, " { ");
+    UInt32Array1::const_iterator it = fineToCoarse.begin();
+    for (; ret && (it != fineToCoarse.end()); ++it) {
+        ret = rtFile_.write(*it, " ");
+    }
+    return ret && rtFile_.write("}\n");
+}
+
+
+bool
+CaeUnsDualMesh::endMesh()
+{
+    return (0 == fileSink_) || fileSink_->endMesh();
+}
+
+
+bool
+CaeUnsDualMesh::beginStep(UInt32 total)
+{
+    return progressBeginStep(total);
+}
+
+
+bool
+CaeUnsDualMesh::incrementStep()
+{
+    return progressIncrement();
+}
+
+
+bool
+CaeUnsDualMesh::endStep()
+{
+    return progressEndStep();
+}
+
+
+void
+CaeUnsDualMesh::errorMsg(const char *msg)
+{
+    sendErrorMsg(msg, 0);
+}
+
+
+void
+CaeUnsDualMesh::warningMsg(const char *msg)
+{
+    sendWarningMsg(msg, 0);
+}
+
+
+void
+CaeUnsDualMesh::infoMsg(const char *msg)
+{
+    sendInfoMsg(msg, 0);
 }
 
 
@@ -493,9 +835,53 @@ CaeUnsDualMesh::create(CAEP_RTITEM &rti)
 {
     (void)rti.BCCnt; // silence unused arg warning
     return publishBoolValueDef(rti, attrDebugDump, "no",
-        "Generate a debug dump file?", "no|yes") &&
+        "Generate a debug trace file?", "no|yes") &&
         publishRealValueDef(rti, attrMaxTurnAngle, 30.0,
-            "Hard edge max turning angle", 0.0, 180.0, 5.0, 90.0);
+            "Hard edge max turning angle", 0.0, 180.0, 5.0, 90.0) &&
+        publishEnumValueDef(rti, attrPlacement, "Centroid",
+            "Dual vertex placement strategy", DualPlacement::enumNames()) &&
+        publishBoolValueDef(rti, attrDualEdges, "no",
+            "Write the dual edges and their left/right polygons?", "no|yes") &&
+        publishUIntValueDef(rti, attrAggLevels, 0,
+            "Number of agglomeration multigrid levels to write", 0, 10) &&
+        publishBoolValueDef(rti, attrIncremental, "no",
+            "Reuse the polygons of unchanged vertices from the last export?",
+            "no|yes") &&
+        publishBoolValueDef(rti, attrTopoCache, "no",
+            "Save the sorted fans to <exportfile>.dtc and reuse them for "
+            "the same grid topology?", "no|yes") &&
+        publishBoolValueDef(rti, attrMemReport, "no",
+            "Report the memory use at the end of each step?", "no|yes") &&
+        publishRealValueDef(rti, attrMemBudget, 0.0,
+            "Warn if the projected peak memory exceeds this many MB (0 = off)",
+            0.0, 1.0e7, 0.0, 65536.0) &&
+        publishUIntValueDef(rti, attrPartitions, 1,
+            "Number of part files to split the dual polygons into", 1,
+            65536) &&
+        publishStringValueDef(rti, attrVariants, "",
+            "Also write <exportfile>.v<k> for each ';' separated set of "
+            "MaxTurnAngle and/or DualVertexPlacement values") &&
+        publishBoolValueDef(rti, attrPolygonBvh, "no",
+            "Write a bounding volume hierarchy of the polygons to "
+            "<exportfile>.bvh?", "no|yes") &&
+        publishStringValueDef(rti, attrRegionBox, "",
+            "Only write the polygons of the vertices in this box "
+            "(xmin ymin zmin xmax ymax zmax)") &&
+        publishStringValueDef(rti, attrRegionBCs, "",
+            "Only write the polygons of the vertices of these comma "
+            "separated boundary conditions") &&
+        publishUIntValueDef(rti, attrRegionBand, 0,
+            "Only write the polygons of this many vertex layers from the "
+            "hard edges (0 = off)", 0, 1000000) &&
+        publishStringValueDef(rti, attrSharedMemory, "",
+            "Publish the dual mesh in this POSIX shared memory segment "
+            "instead of the export file") &&
+        publishBoolValueDef(rti, attrEstimateOnly, "no",
+            "Only report the estimated run time, peak memory and output "
+            "size instead of writing the dual mesh?", "no|yes") &&
+        publishStringValueDef(rti, attrSymmetryBC, "",
+            "The grid is a half model. Also write its mirror image across "
+            "the plane of these comma separated boundary conditions");
 }
 
 
@@ -503,4 +889,5 @@ void
 CaeUnsDualMesh::destroy(CAEP_RTITEM &rti)
 {
     (void)rti.BCCnt; // silence unused arg warning
+    fanCache.clear();
 }
@@ -11,13 +11,18 @@
 #ifndef _CAEUNSDUALMESH_H_
 #define _CAEUNSDUALMESH_H_
 
-#include <map>
-#include <unordered_set>
-#include <utility>
-#include <vector>
+#include <string>
 
 #include "CaePlugin.h"
 #include "CaeUnsGridModel.h"
+#include "DualCostEstimator.h"
+#include "DualMeshBuilder.h"
+#include "DualMeshBvhWriter.h"
+#include "DualMeshMemoryMonitor.h"
+#include "DualMeshMirror.h"
+#include "DualMeshSink.h"
+#include "DualRegion.h"
+#include "DualVariant.h"
 #include "PluginTypes.h"
 
 
@@ -25,7 +30,23 @@
 //***************************************************************************
 //***************************************************************************
 
-class CaeUnsDualMesh : public CaeUnsPlugin, public CaeFaceStreamHandler {
+/*! Pointwise adapter for the host-independent DualMeshBuilder.
+
+    The grid model's vertices, tri cells and boundary/connection faces are
+    loaded into plain arrays and handed to the builder. The builder streams
+    the dual mesh back through the DualMeshSink methods which are written to
+    rtFile_. If the file name ends with .vtu or .dmc, the write methods are
+    forwarded to a DualMeshVtuWriter or DualMeshChunkWriter instead of
+    writing the Tcl script. If SharedMemory is set, they are forwarded to a
+    DualMeshShmWriter. If any Region attribute is set, only the polygons of
+    the selected vertices are written. If Variants are set, a file is written
+    for each variant after the main export. If EstimateOnly is set, only the
+    cheap counting passes are run and the predicted cost of the export is
+    reported. If SymmetryBC is set, the grid is a half model and mirror_
+    writes the dual of the full model.
+*/
+class CaeUnsDualMesh : public CaeUnsPlugin, public CaeFaceStreamHandler,
+        public DualMeshSink {
 public:
 
     CaeUnsDualMesh(CAEP_RTITEM *pRti, PWGM_HGRIDMODEL model,
@@ -39,66 +60,115 @@ public:
 
 private: // base class virtual methods
 
-    enum VertType {
-        BndryVert, ElemVert, CnxnVert, GceVert
-    };
-
     virtual bool        beginExport();
     virtual PWP_BOOL    write();
 
-    void    addElement(PWP_UINT32 elemNdx, const PWGM_ELEMDATA &ed);
-    void    writeVertex(PWP_UINT32 elemNdx, const Vec3 &v, VertType vType);
-    void    writeGceVertices();
-    bool    writePolys();
-    void    writePoly(PWP_UINT32 gceVertNdx, const UInt32Array1 &cellIndices);
+    bool        loadVertices();
+    bool        loadElements();
+
+    //! Reports the predicted cost of the export instead of writing it
+    bool        writeEstimate();
+
+    //! Adds the tri cells to estimator_'s valence sample
+    bool        sampleElements();
+
+    //! Appends the vertices of the comma separated boundary conditions
+    //! names to verts. attrName prefixes the warnings.
+    void        addBCVerts(const char *attrName, const char *names,
+                    UInt32Array1 &verts);
+
+    //! Fits the symmetry plane to symVerts_ and sets it on mirror_
+    bool        setSymmetryPlane();
+
+    //! Writes a file for each of variants_
+    bool        writeVariants();
+
+    //! Opens the file of a variant and returns its writer. 0 on failure.
+    DualMeshSink * newVariantSink(PwpFile &file, const std::string &fileName);
 
     // face streaming handlers
     virtual PWP_UINT32 streamBegin(const PWGM_BEGINSTREAM_DATA &data);
     virtual PWP_UINT32 streamFace(const PWGM_FACESTREAM_DATA &data);
     virtual PWP_UINT32 streamEnd(const PWGM_ENDSTREAM_DATA &data);
 
-    bool        handleBndryFace(const PWGM_FACESTREAM_DATA &data);
-    bool        handleCnxnFace(const PWGM_FACESTREAM_DATA &data);
-    void        addHardEdge(PWP_UINT32 dualNdx, const PWGM_ELEMDATA &elemData);
-    bool        projectCellCentroidToEdge(PWP_UINT32 cellNdx,
-                    const PWGM_ELEMDATA &edgeElemData, Vec3 &edgePt);
-    const Vec3& centroid(const PWGM_ELEMDATA &ed) const;
-    bool        getCoord(PWP_UINT32 ndx, Vec3& v) const;
+    // DualMeshSink handlers
+    virtual bool    writeGceVertex(UInt32 gceVertNdx, const Vec3 &v);
+    virtual bool    beginCentroids(UInt32 count);
+    virtual bool    beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids);
+    virtual bool    writeVertex(UInt32 dualNdx, const Vec3 &v,
+                        VertType vType);
+    virtual bool    writePoly(UInt32 gceVertNdx, bool isBndry,
+                        const UInt32Array1 &dualVerts);
+    virtual bool    writePolyEdges(UInt32 polyNdx,
+                        const UInt32Array1 &dualEdges);
+    virtual bool    beginDualEdges(UInt32 count);
+    virtual bool    writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+                        UInt32 leftPoly, UInt32 rightPoly);
+    virtual bool    writeAggLevel(UInt32 level, UInt32 numCoarse,
+                        const UInt32Array1 &fineToCoarse);
+    virtual bool    endMesh();
+    virtual bool    beginStep(UInt32 total);
+    virtual bool    incrementStep();
+    virtual bool    endStep();
+    virtual void    errorMsg(const char *msg);
+    virtual void    warningMsg(const char *msg);
+    virtual void    infoMsg(const char *msg);
 
 private:
 
-    //! Cosine of the max hard edge turning angle
-    PWP_REAL                cosMaxTurnAngle_;
+    //! The debug trace file name. Empty if not tracing.
+    std::string             traceFile_;
+
+    //! The topology cache file name. Empty if not caching.
+    std::string             topoCacheFile_;
+
+    //! If true, the fans are kept in memory for the next export
+    bool                    keepFanCache_;
+
+    //! The gce vertex xyz values. 3 per vertex.
+    DoubleArray1            xyz_;
+
+    //! The gce tri cell vertex indices. 3 per cell.
+    UInt32Array1            tris_;
+
+    //! Builds the dual from xyz_ and tris_
+    DualMeshBuilder         builder_;
 
-    //! The debug dump file
-    PwpFile                 dumpFile_;
+    //! The region of interest. Unset if writing the whole mesh.
+    DualRegion              region_;
 
-    //! Maps a gce vertNdx to the gce cells that touch it.
-    UInt32UInt32Array1MMap  gceVertToGceCells_;
+    //! The vertices of the SymmetryBC boundary conditions. Empty if the
+    //! grid is not mirrored.
+    UInt32Array1            symVerts_;
 
-    //! Maps a gce vertNdx to hardGceEdges_ indices that touch it
-    UInt32UInt32Array1MMap  gceVertToHardGceEdges_;
+    //! The extra exports written after the main export
+    DualVariant::Array1     variants_;
 
-    // Maps a hard gce vertex index to its dual index.
-    UInt32ToUInt32Map       hardGceVertToDualVert_;
+    //! The Partitions and PolygonBvh attributes
+    UInt32                  numParts_;
+    bool                    polygonBvh_;
 
-    // Maps a gce edge to its dual mesh vertex index.
-    EdgeToUInt32Map         hardGceEdgeToDualVert_;
+    //! If true, only the cost of the export is estimated
+    bool                    estimateOnly_;
+    DualCostEstimator       estimator_;
+    DualCostEstimator::Format estimateFormat_;
 
-    //! The set of boundary/connection gce vertex indices
-    UInt32Set               hardGceVerts_;
+    //! The streamed boundary and connection face counts
+    UInt32                  numBndryFaces_;
+    UInt32                  numCnxnFaces_;
 
-    //! Array of boundary/connection gce edges.
-    EdgeArray1              hardGceEdges_;
+    //! The binary output writer. 0 if writing the Tcl script.
+    DualMeshSink *          fileSink_;
 
-    //! Number of gce cell centroid vertices
-    PWP_UINT32              numCentroids_;
+    //! Writes the polygon BVH file if enabled and forwards to this sink
+    DualMeshBvhWriter       bvhWriter_;
 
-    //! Number of boundary gce edge mid point vertices
-    PWP_UINT32              numBndryMids_;
+    //! Adds the mirror image of a half model and forwards to bvhWriter_
+    DualMeshMirror          mirror_;
 
-    //! Number of connection gce edge mid point vertices
-    PWP_UINT32              numCnxnMids_;
+    //! Reports the memory use of the steps. The builder writes through it,
+    //! mirror_ and bvhWriter_ to this sink.
+    DualMeshMemoryMonitor   memMonitor_;
 };
 
 #endif // _CAEUNSDUALMESH_H_
@@ -0,0 +1,295 @@
+/****************************************************************************
+ *
+ * class DualAgglomerator
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+
+#include "DualAgglomerator.h"
+#include "ParallelFor.h"
+
+// Matching passes per level. Each pass about halves the node count.
+static const UInt32 PassesPerLevel = 2;
+
+// Proposal rounds per matching pass
+static const UInt32 MaxRounds = 4;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+struct DualAgglomerator::Link {
+    UInt32  node0_;
+    UInt32  node1_;
+    UInt32  weight_;
+    UInt8   blocked_;
+
+    bool operator<(const Link &rhs) const {
+        return (node0_ < rhs.node0_) ||
+            ((node0_ == rhs.node0_) && (node1_ < rhs.node1_));
+    }
+};
+
+
+// Returns true if agglomerates of class c0 and c1 may be merged
+static inline bool
+canMerge(UInt8 c0, UInt8 c1)
+{
+    return (DualAgglomerator::InteriorPoly == c0) ||
+        (DualAgglomerator::InteriorPoly == c1) ||
+        ((DualAgglomerator::HardPoly == c0) &&
+         (DualAgglomerator::HardPoly == c1));
+}
+
+
+// Pseudo random link priority. Same value for (n0, n1) and (n1, n0).
+static inline UInt32
+linkHash(UInt32 n0, UInt32 n1)
+{
+    UInt32 h = std::min(n0, n1) * 0x9E3779B1u ^ std::max(n0, n1);
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    return h ^ (h >> 16);
+}
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualAgglomerator::DualAgglomerator() :
+    classes_(),
+    adjOffsets_(),
+    adjNodes_(),
+    adjWeights_(),
+    adjBlocked_()
+{
+}
+
+
+DualAgglomerator::~DualAgglomerator()
+{
+}
+
+
+void
+DualAgglomerator::setPolys(const UInt8Array1 &polyClasses,
+    const DualEdgeBuilder &edges, UInt32 numTris)
+{
+    classes_ = polyClasses;
+    LinkArray1 links;
+    links.reserve(2 * size_t(edges.edgeCount()));
+    for (UInt32 ii = 0; ii < edges.edgeCount(); ++ii) {
+        const UInt32 right = edges.rightPoly(ii);
+        if (UInt32Undef == right) {
+            continue; // boundary edge
+        }
+        // An edge that does not touch a centroid lies on a connection edge
+        const Edge &verts = edges.edgeVerts(ii);
+        const UInt8 blocked = ((verts[0] >= numTris) && (verts[1] >= numTris))
+            ? 1 : 0;
+        const Link fwd = { edges.leftPoly(ii), right, 1, blocked };
+        const Link rev = { right, edges.leftPoly(ii), 1, blocked };
+        links.push_back(fwd);
+        links.push_back(rev);
+    }
+    setLinks(links, nodeCount());
+}
+
+
+UInt32
+DualAgglomerator::coarsen(UInt32Array1 &fineToCoarse)
+{
+    const UInt32 numFine = nodeCount();
+    fineToCoarse.resize(numFine);
+    for (UInt32 ii = 0; ii < numFine; ++ii) {
+        fineToCoarse[ii] = ii;
+    }
+    UInt32Array1 passMap;
+    for (UInt32 pass = 0; pass < PassesPerLevel; ++pass) {
+        const UInt32 numCoarse = match(passMap);
+        if (numCoarse == nodeCount()) {
+            break; // nothing more can be merged
+        }
+        contract(passMap, numCoarse);
+        for (UInt32 ii = 0; ii < numFine; ++ii) {
+            fineToCoarse[ii] = passMap[fineToCoarse[ii]];
+        }
+    }
+    return nodeCount();
+}
+
+
+UInt32
+DualAgglomerator::match(UInt32Array1 &fineToCoarse) const
+{
+    const UInt32 numNodes = nodeCount();
+    const UInt32 numWorkers = parallelWorkerCount(numNodes);
+    UInt32Array1 partners(numNodes, UInt32Undef);
+    UInt32Array1 proposals(numNodes, UInt32Undef);
+    UInt32Array1 workerMatches(numWorkers);
+    for (UInt32 round = 0; round < MaxRounds; ++round) {
+        // Every unmatched node proposes to its best unmatched neighbor.
+        parallelFor(numNodes, numWorkers,
+            [&](UInt32 begin, UInt32 end, UInt32 worker) {
+                (void)worker;
+                for (UInt32 node = begin; node < end; ++node) {
+                    proposals[node] = (UInt32Undef != partners[node]) ?
+                        UInt32Undef :
+                        bestNeighbor(node, classes_[node], partners, false);
+                }
+            });
+        // Mutual proposals are matched. Only proposals are read here.
+        parallelFor(numNodes, numWorkers,
+            [&](UInt32 begin, UInt32 end, UInt32 worker) {
+                UInt32 cnt = 0;
+                for (UInt32 node = begin; node < end; ++node) {
+                    const UInt32 other = proposals[node];
+                    if ((UInt32Undef != other) && (node == proposals[other])) {
+                        partners[node] = other;
+                        ++cnt;
+                    }
+                }
+                workerMatches[worker] = cnt;
+            });
+        UInt32 numMatched = 0;
+        for (UInt32 ii = 0; ii < numWorkers; ++ii) {
+            numMatched += workerMatches[ii];
+        }
+        if (0 == numMatched) {
+            break;
+        }
+    }
+
+    // Left over nodes join the best matched neighbor pair. Joined nodes are
+    // never joined to, so there are no chains.
+    parallelFor(numNodes, numWorkers,
+        [&](UInt32 begin, UInt32 end, UInt32 worker) {
+            (void)worker;
+            for (UInt32 node = begin; node < end; ++node) {
+                proposals[node] = (UInt32Undef != partners[node]) ?
+                    UInt32Undef :
+                    bestNeighbor(node, classes_[node], partners, true);
+            }
+        });
+
+    // Number the coarse nodes in fine node order
+    fineToCoarse.assign(numNodes, UInt32Undef);
+    UInt32 numCoarse = 0;
+    for (UInt32 node = 0; node < numNodes; ++node) {
+        const UInt32 partner = partners[node];
+        if (UInt32Undef != partner) {
+            if (node < partner) {
+                fineToCoarse[node] = fineToCoarse[partner] = numCoarse++;
+            }
+        }
+        else if (UInt32Undef == proposals[node]) {
+            fineToCoarse[node] = numCoarse++;
+        }
+    }
+    for (UInt32 node = 0; node < numNodes; ++node) {
+        if (UInt32Undef == fineToCoarse[node]) {
+            fineToCoarse[node] = fineToCoarse[proposals[node]];
+        }
+    }
+    return numCoarse;
+}
+
+
+UInt32
+DualAgglomerator::bestNeighbor(UInt32 node, UInt8 nodeClass,
+    const UInt32Array1 &partners, bool wantMatched) const
+{
+    // Prefers the heaviest link, then the higher class, then the link hash.
+    // Ties must not be broken by index. If all nodes prefer their lowest
+    // neighbor, few proposals are mutual.
+    UInt32 best = UInt32Undef;
+    UInt32 bestWeight = 0;
+    UInt8 bestClass = 0;
+    UInt32 bestHash = 0;
+    for (UInt32 ii = adjOffsets_[node]; ii < adjOffsets_[node + 1]; ++ii) {
+        const UInt32 other = adjNodes_[ii];
+        if (adjBlocked_[ii] ||
+                ((UInt32Undef != partners[other]) != wantMatched)) {
+            continue;
+        }
+        UInt8 otherClass = classes_[other];
+        if (wantMatched) {
+            otherClass = std::max(otherClass, classes_[partners[other]]);
+        }
+        if (!canMerge(nodeClass, otherClass)) {
+            continue;
+        }
+        const UInt32 weight = adjWeights_[ii];
+        const UInt32 hash = linkHash(node, other);
+        if ((UInt32Undef == best) || (weight > bestWeight) ||
+                ((weight == bestWeight) && ((otherClass > bestClass) ||
+                ((otherClass == bestClass) && (hash > bestHash))))) {
+            best = other;
+            bestWeight = weight;
+            bestClass = otherClass;
+            bestHash = hash;
+        }
+    }
+    return best;
+}
+
+
+void
+DualAgglomerator::contract(const UInt32Array1 &fineToCoarse,
+    UInt32 numCoarse)
+{
+    const UInt32 numFine = nodeCount();
+    UInt8Array1 classes(numCoarse, InteriorPoly);
+    LinkArray1 links;
+    links.reserve(adjNodes_.size());
+    for (UInt32 node = 0; node < numFine; ++node) {
+        const UInt32 coarse = fineToCoarse[node];
+        classes[coarse] = std::max(classes[coarse], classes_[node]);
+        for (UInt32 ii = adjOffsets_[node]; ii < adjOffsets_[node + 1]; ++ii) {
+            const UInt32 other = fineToCoarse[adjNodes_[ii]];
+            if (other != coarse) {
+                const Link link = { coarse, other, adjWeights_[ii],
+                    adjBlocked_[ii] };
+                links.push_back(link);
+            }
+        }
+    }
+    classes_.swap(classes);
+    setLinks(links, numCoarse);
+}
+
+
+void
+DualAgglomerator::setLinks(LinkArray1 &links, UInt32 numNodes)
+{
+    // Merge duplicate links. A link is blocked if any merged link was.
+    std::sort(links.begin(), links.end());
+    adjOffsets_.assign(size_t(numNodes) + 1, 0);
+    adjNodes_.clear();
+    adjWeights_.clear();
+    adjBlocked_.clear();
+    size_t ii = 0;
+    while (ii < links.size()) {
+        Link link = links[ii];
+        for (++ii; (ii < links.size()) && !(link < links[ii]); ++ii) {
+            link.weight_ += links[ii].weight_;
+            link.blocked_ |= links[ii].blocked_;
+        }
+        ++adjOffsets_[link.node0_ + 1];
+        adjNodes_.push_back(link.node1_);
+        adjWeights_.push_back(link.weight_);
+        adjBlocked_.push_back(link.blocked_);
+    }
+    for (UInt32 node = 0; node < numNodes; ++node) {
+        adjOffsets_[node + 1] += adjOffsets_[node];
+    }
+}
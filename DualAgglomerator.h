@@ -0,0 +1,95 @@
+/****************************************************************************
+ *
+ * class DualAgglomerator
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALAGGLOMERATOR_H_
+#define _DUALAGGLOMERATOR_H_
+
+#include "DualEdgeBuilder.h"
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Builds agglomeration multigrid levels from the dual polygons.
+
+    Each level is built with 2 parallel pairwise matching passes over the
+    polygon adjacency graph, so a level has about 1/4 of the nodes of the
+    level below it. In a pass, every unmatched node proposes to the
+    neighbor it shares the most dual edges with. Mutual proposals are
+    matched. Nodes left over after a few rounds join a matched neighbor.
+
+    Feature preserving rules:
+      - Nodes across a hard (connection) edge are never merged.
+      - Corner nodes (exported hard gce vertices) are the seeds of their own
+        agglomerates. They only absorb interior nodes.
+      - Hard (boundary/connection) nodes only merge with hard or interior
+        nodes. Interior nodes prefer to join hard or corner nodes.
+    An agglomerate takes the highest class of its members.
+*/
+class DualAgglomerator {
+public:
+
+    enum PolyClass {
+        InteriorPoly,
+        HardPoly,
+        CornerPoly
+    };
+
+    DualAgglomerator();
+    ~DualAgglomerator();
+
+    //! Loads the finest level from the dual polygons. polyClasses holds a
+    //! PolyClass for each polygon.
+    void        setPolys(const UInt8Array1 &polyClasses,
+                    const DualEdgeBuilder &edges, UInt32 numTris);
+
+    //! Builds the next coarser level. fineToCoarse is set to the coarse node
+    //! of every node in the current level. Returns the number of coarse
+    //! nodes.
+    UInt32      coarsen(UInt32Array1 &fineToCoarse);
+
+    inline UInt32
+    nodeCount() const
+    {
+        return UInt32(classes_.size());
+    }
+
+
+private:
+
+    struct Link;
+    typedef std::vector<Link>   LinkArray1;
+
+    UInt32      match(UInt32Array1 &fineToCoarse) const;
+    void        contract(const UInt32Array1 &fineToCoarse, UInt32 numCoarse);
+    void        setLinks(LinkArray1 &links, UInt32 numNodes);
+    UInt32      bestNeighbor(UInt32 node, UInt8 nodeClass,
+                    const UInt32Array1 &partners, bool wantMatched) const;
+
+private:
+
+    //! The PolyClass of each node
+    UInt8Array1     classes_;
+
+    //! CSR node adjacency. The neighbors of node n are
+    //! adjNodes_[adjOffsets_[n] .. adjOffsets_[n+1]).
+    UInt32Array1    adjOffsets_;
+    UInt32Array1    adjNodes_;
+
+    //! The number of dual edges shared with each neighbor
+    UInt32Array1    adjWeights_;
+
+    //! 1 if the neighbor is across a hard edge
+    UInt8Array1     adjBlocked_;
+};
+
+#endif // _DUALAGGLOMERATOR_H_
@@ -0,0 +1,282 @@
+/****************************************************************************
+ *
+ * class DualCellQuery
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+
+#include "DualCellQuery.h"
+#include "FanSorter.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualCellQuery::DualCellQuery(const DualMeshBuilder &builder) :
+    builder_(builder),
+    indexDone_(false),
+    vertCellOffsets_(),
+    vertCells_(),
+    hardEdgeIndex_(),
+    hardGceVertToDualVert_(),
+    elemSlots_(),
+    elemXyz_(),
+    midSlots_(),
+    midXyz_(),
+    vertPolys_(),
+    polys_(),
+    numCachedVerts_(0)
+{
+}
+
+
+DualCellQuery::~DualCellQuery()
+{
+}
+
+
+bool
+DualCellQuery::query(const UInt32 *gceVerts, UInt32 count,
+    DualCellArray1 &cells)
+{
+    bool ret = true;
+    for (UInt32 ii = 0; ret && (ii < count); ++ii) {
+        ret = query(gceVerts[ii], cells);
+    }
+    return ret;
+}
+
+
+bool
+DualCellQuery::query(UInt32 gceVert, DualCellArray1 &cells)
+{
+    const TriMesh &mesh = builder_.mesh();
+    if (!indexDone_) {
+        DualMeshBuilder::buildVertCells(mesh, vertCellOffsets_, vertCells_);
+        elemSlots_.assign(mesh.triCount(), UInt32Undef);
+        vertPolys_.assign(mesh.vertexCount(), UInt32Undef);
+        if (!buildHardIndex()) {
+            clear();
+            return false;
+        }
+        indexDone_ = true;
+    }
+    if (gceVert >= mesh.vertexCount()) {
+        return false;
+    }
+    if ((UInt32Undef == vertPolys_[gceVert]) && !buildPolys(gceVert)) {
+        return false;
+    }
+    for (UInt32 ii = vertPolys_[gceVert];
+            (ii < polys_.size()) && (gceVert == polys_[ii].gceVert_); ++ii) {
+        cells.push_back(polys_[ii]);
+    }
+    return true;
+}
+
+
+void
+DualCellQuery::clear()
+{
+    indexDone_ = false;
+    vertCellOffsets_.clear();
+    vertCells_.clear();
+    hardEdgeIndex_.clear();
+    hardGceVertToDualVert_.clear();
+    elemSlots_.clear();
+    elemXyz_.clear();
+    midSlots_.clear();
+    midXyz_.clear();
+    vertPolys_.clear();
+    polys_.clear();
+    numCachedVerts_ = 0;
+}
+
+
+bool
+DualCellQuery::buildHardIndex()
+{
+    // Same numbering as DualMeshBuilder: boundary mids, then connection
+    // mids, then the exported hard gce vertices in ascending order.
+    const TriMesh &mesh = builder_.mesh();
+    UInt8Array1 exportFlags;
+    if (!hardEdgeIndex_.build(mesh.vertexCount(), builder_.bndryMids(),
+            builder_.cnxnMids(), mesh.triCount()) ||
+            !hardEdgeIndex_.classify(mesh, builder_.cosMaxTurnAngle(),
+                exportFlags)) {
+        return false;
+    }
+    midSlots_.assign(hardEdgeIndex_.edgeCount(), UInt32Undef);
+    UInt32 dualNdx = mesh.triCount() + hardEdgeIndex_.edgeCount();
+    const UInt32Array1 &hardVerts = hardEdgeIndex_.hardVerts();
+    UInt32Array1::const_iterator it = hardVerts.begin();
+    for (; it != hardVerts.end(); ++it) {
+        if (hardEdgeIndex_.degree(*it) < 2) {
+            return false;
+        }
+        if (exportFlags[*it]) {
+            hardGceVertToDualVert_.insert(
+                UInt32ToUInt32Map::value_type(*it, dualNdx++));
+        }
+    }
+    return true;
+}
+
+
+bool
+DualCellQuery::buildPolys(UInt32 gceVert)
+{
+    const UInt32 first = UInt32(polys_.size());
+    const UInt32 begin = vertCellOffsets_[gceVert];
+    const UInt32 end = vertCellOffsets_[gceVert + 1];
+    if ((begin != end) && !placeElems(&vertCells_[begin], end - begin)) {
+        return false;
+    }
+    UInt32Array2 fans;
+    if (begin != end) {
+        FanSorter sorter(hardEdgeIndex_, hardGceVertToDualVert_);
+        if (!sorter.run(builder_.mesh(), gceVert, &vertCells_[begin],
+                end - begin, fans)) {
+            return false;
+        }
+    }
+    const bool isBndry = (0 != hardEdgeIndex_.degree(gceVert));
+    bool ret = true;
+    UInt32Array2::const_iterator itFan = fans.begin();
+    for (; ret && (itFan != fans.end()); ++itFan) {
+        polys_.push_back(DualCell());
+        DualCell &cell = polys_.back();
+        cell.gceVert_ = gceVert;
+        cell.isBndry_ = isBndry;
+        cell.dualVerts_ = *itFan;
+        cell.xyz_.resize(3 * itFan->size());
+        for (size_t ii = 0; ret && (ii < itFan->size()); ++ii) {
+            ret = getDualCoord((*itFan)[ii], gceVert, &cell.xyz_[3 * ii]);
+        }
+    }
+    if (!ret) {
+        polys_.resize(first);
+        return false;
+    }
+    vertPolys_[gceVert] = first;
+    ++numCachedVerts_;
+    return true;
+}
+
+
+bool
+DualCellQuery::placeElems(const UInt32 *cells, UInt32 numCells)
+{
+    // Gather the tris that were not placed yet into a small mesh that shares
+    // the vertex array. The placement kernels then work as for a full export.
+    const TriMesh &mesh = builder_.mesh();
+    UInt32Array1 tris;
+    UInt32Array1 newCells;
+    for (UInt32 ii = 0; ii < numCells; ++ii) {
+        const UInt32 cell = cells[ii];
+        if (cell >= mesh.triCount()) {
+            return false;
+        }
+        if (UInt32Undef == elemSlots_[cell]) {
+            const UInt32 *tri = mesh.tri(cell);
+            tris.insert(tris.end(), tri, tri + 3);
+            newCells.push_back(cell);
+        }
+    }
+    if (newCells.empty()) {
+        return true;
+    }
+    TriMesh subMesh(mesh.xyzArray(), mesh.vertexCount(), &tris[0],
+        UInt32(newCells.size()));
+    subMesh.setPlane(mesh.isPlanar(), mesh.planeZ());
+    const size_t offset = elemXyz_.size();
+    elemXyz_.resize(offset + 3 * newCells.size());
+    if (!builder_.placement().placeElemVerts(subMesh, &elemXyz_[offset])) {
+        elemXyz_.resize(offset);
+        return false;
+    }
+    for (size_t ii = 0; ii < newCells.size(); ++ii) {
+        elemSlots_[newCells[ii]] = UInt32(offset / 3 + ii);
+    }
+    return true;
+}
+
+
+bool
+DualCellQuery::placeMid(UInt32 midNdx)
+{
+    if (UInt32Undef != midSlots_[midNdx]) {
+        return true;
+    }
+    // Place the mid against a mesh of its owner and neighbor tris
+    const TriMesh &mesh = builder_.mesh();
+    HardMid mid = hardMid(midNdx);
+    UInt32 cells[2] = { mid.owner_, mid.neighbor_ };
+    const UInt32 numCells = (UInt32Undef == mid.neighbor_) ? 1 : 2;
+    if (!placeElems(cells, numCells)) {
+        return false;
+    }
+    UInt32 tris[6];
+    double elemXyz[6];
+    for (UInt32 ii = 0; ii < numCells; ++ii) {
+        const UInt32 *tri = mesh.tri(cells[ii]);
+        const double *p = &elemXyz_[3 * size_t(elemSlots_[cells[ii]])];
+        std::copy(tri, tri + 3, tris + 3 * ii);
+        std::copy(p, p + 3, elemXyz + 3 * ii);
+    }
+    mid.owner_ = 0;
+    if (2 == numCells) {
+        mid.neighbor_ = 1;
+    }
+    TriMesh subMesh(mesh.xyzArray(), mesh.vertexCount(), tris, numCells);
+    subMesh.setPlane(mesh.isPlanar(), mesh.planeZ());
+    double xyz[3];
+    if (!builder_.placement().placeHardMids(subMesh, elemXyz, &mid, 1, xyz)) {
+        return false;
+    }
+    midSlots_[midNdx] = UInt32(midXyz_.size() / 3);
+    midXyz_.insert(midXyz_.end(), xyz, xyz + 3);
+    return true;
+}
+
+
+bool
+DualCellQuery::getDualCoord(UInt32 dualNdx, UInt32 gceVert, double *xyz)
+{
+    const TriMesh &mesh = builder_.mesh();
+    const double *p = 0;
+    if (dualNdx < mesh.triCount()) {
+        if (placeElems(&dualNdx, 1)) {
+            p = &elemXyz_[3 * size_t(elemSlots_[dualNdx])];
+        }
+    }
+    else if (dualNdx - mesh.triCount() < hardEdgeIndex_.edgeCount()) {
+        const UInt32 midNdx = dualNdx - mesh.triCount();
+        if (placeMid(midNdx)) {
+            p = &midXyz_[3 * size_t(midSlots_[midNdx])];
+        }
+    }
+    else {
+        // the only exported hard vertex in a polygon is its own gce vertex
+        p = mesh.xyz(gceVert);
+    }
+    if (0 != p) {
+        std::copy(p, p + 3, xyz);
+    }
+    return 0 != p;
+}
+
+
+const HardMid &
+DualCellQuery::hardMid(UInt32 midNdx) const
+{
+    const UInt32 numBndryMids = UInt32(builder_.bndryMids().size());
+    return (midNdx < numBndryMids) ? builder_.bndryMids()[midNdx] :
+        builder_.cnxnMids()[midNdx - numBndryMids];
+}
@@ -0,0 +1,129 @@
+/****************************************************************************
+ *
+ * class DualCellQuery
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALCELLQUERY_H_
+#define _DUALCELLQUERY_H_
+
+#include "DualMeshBuilder.h"
+#include "HardEdgeIndex.h"
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+//! A dual polygon returned by a DualCellQuery
+struct DualCell {
+    //! The primal vertex the polygon surrounds
+    UInt32          gceVert_;
+
+    //! True if gceVert_ is touched by a boundary/connection edge
+    bool            isBndry_;
+
+    //! The ordered dual vertex indices. Same numbering as the full export.
+    UInt32Array1    dualVerts_;
+
+    //! The dual vertex xyz values. 3 per dual vertex.
+    DoubleArray1    xyz_;
+};
+typedef std::vector<DualCell>   DualCellArray1;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Returns the dual polygons of selected primal vertices without building
+    the whole dual mesh.
+
+    The query uses the mesh, hard edges, turning angle and placement of a
+    configured DualMeshBuilder. The builder must outlive the query and must
+    not be changed while it is in use. Nothing is computed until the first
+    query:
+      - The vertex to cell lists are built on the first query.
+      - The hard edge indices and exported hard vertices are built on the
+        first query. They cost O(n) for the CSR offsets plus O(number of
+        hard edges).
+      - Dual vertex locations are placed only for the cells and hard edges
+        around the queried vertices.
+    All results are cached, so querying a vertex again is a lookup.
+
+    The mesh is not validated. A query returns false if it runs into a bad
+    vertex or cell index, or into tris with inconsistent orientation or
+    non-manifold edges.
+*/
+class DualCellQuery {
+public:
+
+    DualCellQuery(const DualMeshBuilder &builder);
+    ~DualCellQuery();
+
+    //! Appends the dual polygons of the count gceVerts to cells. A vertex
+    //! touched by hard edges may have more than one polygon. Returns false
+    //! if a vertex index is invalid.
+    bool        query(const UInt32 *gceVerts, UInt32 count,
+                    DualCellArray1 &cells);
+
+    //! Appends the dual polygons of gceVert to cells
+    bool        query(UInt32 gceVert, DualCellArray1 &cells);
+
+    //! Drops all cached indices and results
+    void        clear();
+
+    //! Number of primal vertices with cached polygons
+    inline UInt32
+    cachedVertexCount() const
+    {
+        return numCachedVerts_;
+    }
+
+
+private:
+
+    bool        buildHardIndex();
+    bool        buildPolys(UInt32 gceVert);
+    bool        placeElems(const UInt32 *cells, UInt32 numCells);
+    bool        placeMid(UInt32 midNdx);
+    bool        getDualCoord(UInt32 dualNdx, UInt32 gceVert, double *xyz);
+    const HardMid & hardMid(UInt32 midNdx) const;
+
+private:
+
+    const DualMeshBuilder & builder_;
+    bool                    indexDone_;
+
+    //! CSR cell lists of each vertex. See DualMeshBuilder::buildVertCells().
+    UInt32Array1            vertCellOffsets_;
+    UInt32Array1            vertCells_;
+
+    //! The hard edges of each gce vertex and their mid dual vertices
+    HardEdgeIndex           hardEdgeIndex_;
+
+    //! Maps an exported hard gce vertex to its dual vertex index
+    UInt32ToUInt32Map       hardGceVertToDualVert_;
+
+    //! Slot of each tri in elemXyz_. UInt32Undef if not placed yet.
+    UInt32Array1            elemSlots_;
+    DoubleArray1            elemXyz_;
+
+    //! Slot of each hard mid in midXyz_. UInt32Undef if not placed yet.
+    UInt32Array1            midSlots_;
+    DoubleArray1            midXyz_;
+
+    //! Index of the first cached polygon of each vertex in polys_.
+    //! UInt32Undef if not queried yet. The polygons of a vertex are stored
+    //! together.
+    UInt32Array1            vertPolys_;
+    DualCellArray1          polys_;
+    UInt32                  numCachedVerts_;
+};
+
+#endif // _DUALCELLQUERY_H_
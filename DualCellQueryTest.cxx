@@ -0,0 +1,105 @@
+/****************************************************************************
+ *
+ * dualquerytest command line tool
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "DualCellQuery.h"
+#include "DualMeshBuilder.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*  A 3x3 vertex grid split into 8 tris. Vertex 4 is the only interior
+    vertex.
+
+        6---7---8
+        | / | / |
+        3---4---5
+        | / | / |
+        0---1---2
+*/
+static const double GridXyz[9 * 3] = {
+    0.0, 0.0, 0.0,   1.0, 0.0, 0.0,   2.0, 0.0, 0.0,
+    0.0, 1.0, 0.0,   1.0, 1.0, 0.0,   2.0, 1.0, 0.0,
+    0.0, 2.0, 0.0,   1.0, 2.0, 0.0,   2.0, 2.0, 0.0,
+};
+
+static const UInt32 GridTris[8 * 3] = {
+    0, 1, 4,   0, 4, 3,   1, 2, 5,   1, 5, 4,
+    3, 4, 7,   3, 7, 6,   4, 5, 8,   4, 8, 7,
+};
+
+
+//! Queries every vertex of the grid. If flipTri is valid, its winding is
+//! reversed first. Returns the number of failed queries or -1 if a query
+//! returned an empty or bad polygon.
+static int
+queryGrid(UInt32 flipTri)
+{
+    UInt32 tris[8 * 3];
+    for (UInt32 ii = 0; ii < 8 * 3; ++ii) {
+        tris[ii] = GridTris[ii];
+    }
+    if (flipTri < 8) {
+        tris[3 * flipTri + 1] = GridTris[3 * flipTri + 2];
+        tris[3 * flipTri + 2] = GridTris[3 * flipTri + 1];
+    }
+    TriMesh mesh(GridXyz, 9, tris, 8);
+    DualMeshBuilder builder(mesh);
+    builder.findBndryEdges();
+    DualCellQuery query(builder);
+    int numFailed = 0;
+    for (UInt32 gceVert = 0; gceVert < 9; ++gceVert) {
+        DualCellArray1 cells;
+        if (!query.query(gceVert, cells)) {
+            ++numFailed;
+            continue;
+        }
+        DualCellArray1::const_iterator it = cells.begin();
+        for (; it != cells.end(); ++it) {
+            if (it->dualVerts_.empty() ||
+                    (3 * it->dualVerts_.size() != it->xyz_.size())) {
+                return -1;
+            }
+        }
+    }
+    // a bad vertex index must fail too
+    DualCellArray1 cells;
+    if (query.query(9, cells)) {
+        return -1;
+    }
+    return numFailed;
+}
+
+
+static bool
+check(bool ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAILED", what);
+    return ok;
+}
+
+
+int
+main()
+{
+    bool ok = check(0 == queryGrid(UInt32Undef), "grid queries succeed");
+    // Each query must return, not abort, on an inconsistently oriented tri.
+    // The interior vertex 4 can not be sorted into a fan.
+    for (UInt32 flipTri = 0; flipTri < 8; ++flipTri) {
+        char what[64];
+        sprintf(what, "flip tri %u queries fail gracefully", flipTri);
+        ok = check(0 < queryGrid(flipTri), what) && ok;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
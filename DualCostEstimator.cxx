@@ -0,0 +1,545 @@
+/****************************************************************************
+ *
+ * class DualCostEstimator
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <cmath>
+#include <cstdio>
+
+#include "DualCostEstimator.h"
+#include "DualMeshShmWriter.h"
+#include "ParallelFor.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+namespace {
+
+// Per item costs in ns of the builder steps and writers. Measured with one
+// thread on a 2M tri grid. The validation and agglomeration costs are
+// divided by the parallelFor() worker count.
+const double ValidateTriNs      = 410.0;
+const double CentroidTriNs      = 60.0;
+const double HardIndexVertNs    = 8.0;
+const double HardMidNs          = 100.0;
+const double PolyVertNs         = 170.0;
+const double FanSortNs          = 29.0;     // per k log2(k) of a fan
+const double FanCacheVertNs     = 100.0;
+const double DualEdgeVertNs     = 200.0;
+const double AggLevelVertNs     = 760.0;
+const double WriteByteNs[DualCostEstimator::NumFormats] = {
+    25.0,   // TclFormat
+    2.9,    // VtuFormat
+    3.5,    // ChunkFormat
+    2.0,    // PartFormat
+    0.7     // ShmFormat
+};
+
+// Bytes per item of the builder containers
+const double MeshVertBytes      = 24.0;     // xyz
+const double MeshTriBytes       = 12.0;
+const double HardMidBytes       = 32.0;     // grown by push_back
+const double ValidateTriBytes   = 115.0;    // validation peak
+const double TopoVertBytes      = 9.0;      // cell offsets and flags
+const double TopoTriBytes       = 12.0;     // vertex cell lists
+const double TopoHardMidBytes   = 32.0;     // hard edge index
+const double PlaceDualVertBytes = 24.0;
+const double FanCachePolyVertBytes = 16.0;
+const double DualEdgeBytes      = 36.0;
+const double AggPolyBytes       = 80.0;
+
+//! Vectors filled by push_back hold up to twice their size while growing
+const double GrowthFactor       = 2.0;
+
+// The histogram has a bucket for each valence below HistSize - 1. The last
+// bucket holds the rest.
+const UInt32 HistSize = 33;
+
+
+inline double
+toMB(double numBytes)
+{
+    return numBytes / (1024.0 * 1024.0);
+}
+
+
+//! Number of decimal digits of the largest index below count
+inline double
+indexDigits(double count)
+{
+    return (count < 10.0) ? 1.0 : std::floor(std::log10(count - 1.0)) + 1.0;
+}
+
+
+inline double
+alignUp(double numBytes)
+{
+    return 8.0 * std::ceil(numBytes / 8.0);
+}
+
+} // namespace
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualCostEstimator::DualCostEstimator() :
+    numVerts_(0),
+    numTris_(0),
+    numBndryEdges_(0),
+    numCnxnEdges_(0),
+    singlePrecision_(false),
+    dualEdges_(false),
+    numAggLevels_(0),
+    fanCache_(false),
+    numVariants_(0),
+    sampleShift_(0),
+    sampleMask_(0),
+    valences_(),
+    histogram_(),
+    numSampled_(0),
+    maxValence_(0),
+    meanSortWork_(0.0)
+{
+}
+
+
+void
+DualCostEstimator::setMeshCounts(UInt32 numVerts, UInt32 numTris)
+{
+    numVerts_ = numVerts;
+    numTris_ = numTris;
+}
+
+
+void
+DualCostEstimator::setHardEdgeCounts(UInt32 numBndryEdges,
+    UInt32 numCnxnEdges)
+{
+    numBndryEdges_ = numBndryEdges;
+    numCnxnEdges_ = numCnxnEdges;
+}
+
+
+void
+DualCostEstimator::setSinglePrecision(bool singlePrecision)
+{
+    singlePrecision_ = singlePrecision;
+}
+
+
+void
+DualCostEstimator::setDualEdges(bool enable)
+{
+    dualEdges_ = enable;
+}
+
+
+void
+DualCostEstimator::setAggLevels(UInt32 numLevels)
+{
+    numAggLevels_ = numLevels;
+}
+
+
+void
+DualCostEstimator::setFanCache(bool enable)
+{
+    fanCache_ = enable;
+}
+
+
+void
+DualCostEstimator::setVariantCount(UInt32 numVariants)
+{
+    numVariants_ = numVariants;
+}
+
+
+void
+DualCostEstimator::beginValences()
+{
+    sampleShift_ = 0;
+    while ((numVerts_ >> sampleShift_) >= UInt32(MaxSampledVerts)) {
+        ++sampleShift_;
+    }
+    sampleMask_ = (UInt32(1) << sampleShift_) - 1;
+    valences_.assign((0 == numVerts_) ? 0 :
+        ((numVerts_ - 1) >> sampleShift_) + 1, 0);
+}
+
+
+void
+DualCostEstimator::endValences()
+{
+    histogram_.assign(HistSize, 0);
+    numSampled_ = UInt32(valences_.size());
+    maxValence_ = 0;
+    double sortWork = 0.0;
+    UInt32 numUsed = 0;
+    for (UInt32 ii = 0; ii < numSampled_; ++ii) {
+        const UInt32 k = valences_[ii];
+        ++histogram_[(k < HistSize - 1) ? k : HistSize - 1];
+        if (k > maxValence_) {
+            maxValence_ = k;
+        }
+        if (0 != k) {
+            sortWork += k * std::log(double(k)) / std::log(2.0);
+            ++numUsed;
+        }
+    }
+    meanSortWork_ = (0 == numUsed) ? 0.0 : sortWork / numUsed;
+    valences_.clear();
+    valences_.shrink_to_fit();
+}
+
+
+double
+DualCostEstimator::dualVertCount() const
+{
+    return double(numTris_) + numBndryEdges_ + numCnxnEdges_;
+}
+
+
+double
+DualCostEstimator::polyCount() const
+{
+    // One polygon per used vertex. The fans of a vertex on a connection
+    // edge are split in two.
+    double usedFraction = 1.0;
+    if ((0 != numSampled_) && !histogram_.empty()) {
+        usedFraction = double(numSampled_ - histogram_[0]) / numSampled_;
+    }
+    return usedFraction * numVerts_ + numCnxnEdges_;
+}
+
+
+double
+DualCostEstimator::polyVertCount() const
+{
+    // Each tri centroid is in the polygons of its 3 vertices. Each hard mid
+    // is in the polygons of its 2 vertices, on both sides of a connection.
+    return 3.0 * numTris_ + 2.0 * numBndryEdges_ + 4.0 * numCnxnEdges_;
+}
+
+
+double
+DualCostEstimator::dualEdgeCount() const
+{
+    // One dual edge per primal edge
+    return 0.5 * (3.0 * numTris_ + numBndryEdges_ + numCnxnEdges_);
+}
+
+
+double
+DualCostEstimator::peakBytes(MemoryStats::Category cat, Format format) const
+{
+    const double numHardMids = double(numBndryEdges_) + numCnxnEdges_;
+    double ret = 0.0;
+    switch (cat) {
+    case MemoryStats::Mesh:
+        ret = MeshVertBytes * numVerts_ + MeshTriBytes * numTris_ +
+            HardMidBytes * numHardMids;
+        break;
+    case MemoryStats::Topology:
+        ret = ValidateTriBytes * numTris_;
+        break;
+    case MemoryStats::Placement:
+        ret = PlaceDualVertBytes * dualVertCount();
+        break;
+    case MemoryStats::Fans:
+        if (fanCache_ || (0 != numVariants_)) {
+            ret = FanCachePolyVertBytes * polyVertCount();
+        }
+        break;
+    case MemoryStats::DualEdges:
+        if (dualEdges_ || (0 != numAggLevels_)) {
+            ret = DualEdgeBytes * dualEdgeCount();
+        }
+        if (0 != numAggLevels_) {
+            ret += AggPolyBytes * polyCount();
+        }
+        break;
+    case MemoryStats::Output:
+        ret = GrowthFactor * bufferedBytes(format);
+        break;
+    default:
+        break;
+    }
+    return ret;
+}
+
+
+double
+DualCostEstimator::peakTotalBytes(Format format) const
+{
+    // The validation peak is freed before the dual vertices are placed.
+    // Everything after it is held until the end of the run.
+    const double numHardMids = double(numBndryEdges_) + numCnxnEdges_;
+    const double topoBytes = TopoVertBytes * numVerts_ +
+        TopoTriBytes * numTris_ + TopoHardMidBytes * numHardMids;
+    double runBytes = topoBytes;
+    for (int ii = MemoryStats::Placement; ii < MemoryStats::NumCategories;
+            ++ii) {
+        runBytes += peakBytes(MemoryStats::Category(ii), format);
+    }
+    const double validateBytes = peakBytes(MemoryStats::Topology, format);
+    return peakBytes(MemoryStats::Mesh, format) +
+        ((validateBytes > runBytes) ? validateBytes : runBytes);
+}
+
+
+double
+DualCostEstimator::bufferedBytes(Format format) const
+{
+    const double numDualVerts = dualVertCount();
+    const double numPolys = polyCount();
+    const double numPolyVerts = polyVertCount();
+    double ret = 0.0;
+    switch (format) {
+    case VtuFormat:
+        ret = (singlePrecision_ ? 13.0 : 25.0) * numDualVerts +
+            10.0 * numPolys + 4.0 * numPolyVerts;
+        if (dualEdges_) {
+            ret += 4.0 * numPolyVerts + 16.0 * dualEdgeCount();
+        }
+        ret += 4.0 * numPolys * numAggLevels_;
+        break;
+    case ChunkFormat:
+        // The dual vertex xyz and the polygon boxes
+        ret = 24.0 * numDualVerts + 48.0 * numPolys;
+        break;
+    case PartFormat:
+        ret = 25.0 * numDualVerts + 9.0 * numPolys + 4.0 * numPolyVerts;
+        break;
+    case ShmFormat:
+        ret = outputBytes(ShmFormat);
+        break;
+    default:
+        break;
+    }
+    return ret;
+}
+
+
+double
+DualCostEstimator::outputBytes(Format format) const
+{
+    const double numDualVerts = dualVertCount();
+    const double numPolys = polyCount();
+    const double numPolyVerts = polyVertCount();
+    const double numDualEdges = dualEdges_ ? dualEdgeCount() : 0.0;
+    const double numAggVals = double(numAggLevels_) * numPolys;
+    double ret = 0.0;
+    switch (format) {
+    case TclFormat: {
+        // %.17g or %.9g coordinates and decimal indices
+        const double coordChars = singlePrecision_ ? 12.0 : 20.0;
+        const double vertDigits = indexDigits(numVerts_);
+        const double dualDigits = indexDigits(numDualVerts);
+        const double polyDigits = indexDigits(numPolys);
+        const double edgeDigits = indexDigits(numDualEdges);
+        ret = (18.0 + vertDigits + 3.0 * coordChars) * numVerts_ +
+            (22.0 + dualDigits + 3.0 * coordChars) * numDualVerts +
+            11.0 * numPolys + (dualDigits + 1.0) * numPolyVerts +
+            (polyDigits + 1.0) * numAggVals;
+        if (dualEdges_) {
+            ret += (15.0 + polyDigits) * numPolys +
+                (edgeDigits + 1.0) * numPolyVerts +
+                (14.0 + edgeDigits + 2.0 * dualDigits + 2.0 * polyDigits) *
+                numDualEdges;
+        }
+        break; }
+    case VtuFormat:
+        ret = 2048.0 + bufferedBytes(VtuFormat);
+        break;
+    case ChunkFormat:
+        ret = 24.0 * numVerts_ + 25.0 * numDualVerts + 9.0 * numPolys +
+            4.0 * numPolyVerts + 16.0 * numDualEdges + 4.0 * numAggVals;
+        if (dualEdges_) {
+            ret += 4.0 * numPolyVerts;
+        }
+        break;
+    case PartFormat:
+        // xyz, global index, owner and type of each vertex. The halo
+        // polygons are not counted.
+        ret = 33.0 * numDualVerts + 13.0 * numPolys + 4.0 * numPolyVerts;
+        break;
+    case ShmFormat:
+        ret = alignUp(double(sizeof(DualMeshShmWriter::Header))) +
+            24.0 * numVerts_ + 24.0 * numDualVerts +
+            alignUp(4.0 * numPolys) + alignUp(4.0 * (numPolys + 1.0)) +
+            alignUp(4.0 * numPolyVerts) + alignUp(numDualVerts) +
+            alignUp(numPolys);
+        break;
+    default:
+        break;
+    }
+    return ret;
+}
+
+
+void
+DualCostEstimator::phaseSeconds(Format format, double secs[NumPhases]) const
+{
+    const double numHardMids = double(numBndryEdges_) + numCnxnEdges_;
+    const double triWorkers = parallelWorkerCount(numTris_);
+    const double vertWorkers = parallelWorkerCount(numVerts_);
+    const double numPolys = polyCount();
+    secs[ValidatePhase] = ValidateTriNs * numTris_ / triWorkers;
+    secs[PlacePhase] = CentroidTriNs * numTris_ +
+        HardIndexVertNs * numVerts_ + HardMidNs * numHardMids;
+    const double cacheNs = (fanCache_ || (0 != numVariants_)) ?
+        FanCacheVertNs : 0.0;
+    secs[PolyPhase] = (PolyVertNs + FanSortNs * meanSortWork_ + cacheNs) *
+        numPolys;
+    secs[DualEdgePhase] = (dualEdges_ || (0 != numAggLevels_)) ?
+        DualEdgeVertNs * numPolys : 0.0;
+    secs[AggPhase] = AggLevelVertNs * numAggLevels_ * numPolys / vertWorkers;
+    secs[WritePhase] = WriteByteNs[format] * outputBytes(format);
+    // A variant reuses the sorted fans
+    secs[VariantPhase] = numVariants_ * (secs[ValidatePhase] +
+        secs[PlacePhase] + (PolyVertNs + cacheNs) * numPolys +
+        secs[DualEdgePhase] + secs[AggPhase] + secs[WritePhase]);
+    for (int ii = 0; ii < NumPhases; ++ii) {
+        secs[ii] *= 1.0e-9;
+    }
+}
+
+
+double
+DualCostEstimator::runSeconds(Format format) const
+{
+    double secs[NumPhases];
+    phaseSeconds(format, secs);
+    double ret = 0.0;
+    for (int ii = 0; ii < NumPhases; ++ii) {
+        ret += secs[ii];
+    }
+    return ret;
+}
+
+
+void
+DualCostEstimator::report(Format format,
+    std::vector<std::string> &lines) const
+{
+    static const char *phaseNames[] = {
+                            "validate",     // ValidatePhase
+                            "place",        // PlacePhase
+                            "polygons",     // PolyPhase
+                            "dual edges",   // DualEdgePhase
+                            "agglomerate",  // AggPhase
+                            "write",        // WritePhase
+                            "variants"      // VariantPhase
+                        };
+    char buf[512];
+    snprintf(buf, sizeof(buf), "estimate: %u vertices, %u tris, %u boundary "
+        "and %u connection edges", numVerts_, numTris_, numBndryEdges_,
+        numCnxnEdges_);
+    lines.push_back(buf);
+
+    if (0 != numSampled_) {
+        const UInt32 numUsed = numSampled_ - histogram_[0];
+        double sum = 0.0;
+        for (UInt32 k = 1; k < HistSize; ++k) {
+            sum += double(k) * histogram_[k];
+        }
+        int len = snprintf(buf, sizeof(buf), "estimate: valence of %u "
+            "sampled vertices: mean %.2f, max %u (", numSampled_,
+            (0 == numUsed) ? 0.0 : sum / numUsed, maxValence_);
+        const char *sep = "";
+        for (UInt32 k = 0; (k < HistSize) && (0 <= len) &&
+                (size_t(len) < sizeof(buf)); ++k) {
+            const double pct = 100.0 * histogram_[k] / numSampled_;
+            if (pct >= 0.5) {
+                len += snprintf(buf + len, sizeof(buf) - len, "%s%s%u: %.0f%%",
+                    sep, (HistSize - 1 == k) ? ">=" : "", k, pct);
+                sep = ", ";
+            }
+        }
+        if ((0 <= len) && (size_t(len) < sizeof(buf))) {
+            snprintf(buf + len, sizeof(buf) - len, ")");
+        }
+        lines.push_back(buf);
+    }
+
+    snprintf(buf, sizeof(buf), "estimate: %.0f dual vertices, %.0f polygons, "
+        "%.0f polygon vertices", dualVertCount(), polyCount(),
+        polyVertCount());
+    lines.push_back(buf);
+
+    int len = snprintf(buf, sizeof(buf), "estimate: peak memory %.1f MB (",
+        toMB(peakTotalBytes(format)));
+    const char *sep = "";
+    for (int ii = 0; (ii < MemoryStats::NumCategories) && (0 <= len) &&
+            (size_t(len) < sizeof(buf)); ++ii) {
+        const MemoryStats::Category cat = MemoryStats::Category(ii);
+        const double numBytes = peakBytes(cat, format);
+        if (0.0 != numBytes) {
+            len += snprintf(buf + len, sizeof(buf) - len, "%s%s %.1f", sep,
+                MemoryStats::categoryName(cat), toMB(numBytes));
+            sep = ", ";
+        }
+    }
+    if ((0 <= len) && (size_t(len) < sizeof(buf))) {
+        snprintf(buf + len, sizeof(buf) - len, ")");
+    }
+    lines.push_back(buf);
+
+    len = snprintf(buf, sizeof(buf), "estimate: %s output %.1f MB (",
+        formatName(format), toMB(outputBytes(format)));
+    sep = "";
+    for (int ii = 0; (ii < NumFormats) && (0 <= len) &&
+            (size_t(len) < sizeof(buf)); ++ii) {
+        if (format != ii) {
+            len += snprintf(buf + len, sizeof(buf) - len, "%s%s %.1f", sep,
+                formatName(Format(ii)), toMB(outputBytes(Format(ii))));
+            sep = ", ";
+        }
+    }
+    if ((0 <= len) && (size_t(len) < sizeof(buf))) {
+        snprintf(buf + len, sizeof(buf) - len, ")");
+    }
+    lines.push_back(buf);
+
+    double secs[NumPhases];
+    phaseSeconds(format, secs);
+    len = snprintf(buf, sizeof(buf), "estimate: run time %.1f s (",
+        runSeconds(format));
+    sep = "";
+    for (int ii = 0; (ii < NumPhases) && (0 <= len) &&
+            (size_t(len) < sizeof(buf)); ++ii) {
+        if (0.0 != secs[ii]) {
+            len += snprintf(buf + len, sizeof(buf) - len, "%s%s %.1f", sep,
+                phaseNames[ii], secs[ii]);
+            sep = ", ";
+        }
+    }
+    if ((0 <= len) && (size_t(len) < sizeof(buf))) {
+        snprintf(buf + len, sizeof(buf) - len, ")");
+    }
+    lines.push_back(buf);
+}
+
+
+const char *
+DualCostEstimator::formatName(Format format)
+{
+    static const char *formatNames[] = {
+                            "glf",  // TclFormat
+                            "vtu",  // VtuFormat
+                            "dmc",  // ChunkFormat
+                            "dmp",  // PartFormat
+                            "shm"   // ShmFormat
+                        };
+    return (format < NumFormats) ? formatNames[format] : "";
+}
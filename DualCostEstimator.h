@@ -0,0 +1,157 @@
+/****************************************************************************
+ *
+ * class DualCostEstimator
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALCOSTESTIMATOR_H_
+#define _DUALCOSTESTIMATOR_H_
+
+#include <string>
+#include <vector>
+
+#include "MemoryStats.h"
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Predicts the run time, peak memory and output size of an export without
+    building the dual mesh.
+
+    The inputs are the cheap counts of the grid: the vertex and tri counts,
+    the hard edge counts and a valence histogram of a sample of the
+    vertices. The sampled vertices are every 2^n-th vertex, so at most
+    MaxSampledVerts counters are kept. The dual mesh counts follow from the
+    input counts. Memory and output bytes are modeled per MemoryStats
+    category and per output format from the container layouts. Run time is
+    modeled per builder step from per item costs measured on a reference
+    machine. The fan sorting cost of a vertex grows as k log k with its
+    valence k.
+
+    The exported hard vertices and the region are not known until the
+    build, so the estimate is for the whole grid without them.
+*/
+class DualCostEstimator {
+public:
+
+    enum Format {
+        TclFormat,      //!< glf Tcl script
+        VtuFormat,      //!< VTK XML unstructured grid
+        ChunkFormat,    //!< chunked binary container
+        PartFormat,     //!< binary part files
+        ShmFormat,      //!< shared memory segment
+        NumFormats
+    };
+
+    enum {
+        MaxSampledVerts = 65536
+    };
+
+    DualCostEstimator();
+
+    void        setMeshCounts(UInt32 numVerts, UInt32 numTris);
+    void        setHardEdgeCounts(UInt32 numBndryEdges, UInt32 numCnxnEdges);
+
+    // The export options that change the cost. Default is double
+    // precision with no dual edges, levels, fan cache or variants.
+    void        setSinglePrecision(bool singlePrecision);
+    void        setDualEdges(bool enable);
+    void        setAggLevels(UInt32 numLevels);
+    void        setFanCache(bool enable);
+    void        setVariantCount(UInt32 numVariants);
+
+    //! Starts the valence sampling pass. Call after setMeshCounts() and
+    //! then addTri() for every tri.
+    void        beginValences();
+
+    inline void
+    addTri(const UInt32 *tri)
+    {
+        for (int ii = 0; ii < 3; ++ii) {
+            if ((tri[ii] < numVerts_) && (0 == (tri[ii] & sampleMask_))) {
+                ++valences_[tri[ii] >> sampleShift_];
+            }
+        }
+    }
+
+    //! Builds the valence histogram from the sampled counts
+    void        endValences();
+
+    // The predicted dual mesh counts
+    double      dualVertCount() const;
+    double      polyCount() const;
+    double      polyVertCount() const;
+
+    //! The predicted peak bytes of cat in an export to format
+    double      peakBytes(MemoryStats::Category cat, Format format) const;
+
+    //! The predicted peak bytes of all categories at the same time
+    double      peakTotalBytes(Format format) const;
+
+    double      outputBytes(Format format) const;
+    double      runSeconds(Format format) const;
+
+    //! Appends the report of an export to format to lines
+    void        report(Format format, std::vector<std::string> &lines) const;
+
+    //! The file extension of format without the dot
+    static const char * formatName(Format format);
+
+private:
+
+    enum Phase {
+        ValidatePhase,
+        PlacePhase,
+        PolyPhase,
+        DualEdgePhase,
+        AggPhase,
+        WritePhase,
+        VariantPhase,
+        NumPhases
+    };
+
+    //! Fills secs with the predicted seconds of each phase
+    void        phaseSeconds(Format format, double secs[NumPhases]) const;
+
+    //! The predicted bytes of the dual mesh arrays that format buffers
+    double      bufferedBytes(Format format) const;
+
+    //! The predicted number of dual edges
+    double      dualEdgeCount() const;
+
+private:
+
+    UInt32          numVerts_;
+    UInt32          numTris_;
+    UInt32          numBndryEdges_;
+    UInt32          numCnxnEdges_;
+    bool            singlePrecision_;
+    bool            dualEdges_;
+    UInt32          numAggLevels_;
+    bool            fanCache_;
+    UInt32          numVariants_;
+
+    //! Vertex v is sampled if (v & sampleMask_) is 0. Its count is
+    //! valences_[v >> sampleShift_].
+    UInt32          sampleShift_;
+    UInt32          sampleMask_;
+    UInt32Array1    valences_;
+
+    //! histogram_[k] is the number of sampled vertices with valence k. The
+    //! last entry counts the vertices with that valence or more.
+    UInt32Array1    histogram_;
+    UInt32          numSampled_;
+    UInt32          maxValence_;
+
+    //! The mean of k log2(k) over the used sampled vertices
+    double          meanSortWork_;
+};
+
+#endif // _DUALCOSTESTIMATOR_H_
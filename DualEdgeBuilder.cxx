@@ -0,0 +1,160 @@
+/****************************************************************************
+ *
+ * class DualEdgeBuilder
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include "DualEdgeBuilder.h"
+
+
+DualEdgeBuilder::DualEdgeBuilder(const TriMesh &mesh) :
+    mesh_(mesh),
+    gceVertNdx_(UInt32Undef),
+    triEdges_(),
+    hardSides_(),
+    edgeVerts_(),
+    edgePolys_()
+{
+}
+
+
+DualEdgeBuilder::~DualEdgeBuilder()
+{
+}
+
+
+void
+DualEdgeBuilder::beginVertex(UInt32 gceVertNdx)
+{
+    gceVertNdx_ = gceVertNdx;
+    hardSides_.clear();
+}
+
+
+bool
+DualEdgeBuilder::addPoly(UInt32 polyNdx, const UInt32Array1 &polyVerts,
+    UInt32Array1 &polyEdges)
+{
+    /*  The fan sorter writes the polygon cells in right-handed order around
+        the gce vertex. Hence, the edge from cell A to the next cell B
+        crosses A's left fan-edge which is B's right fan-edge. An open fan
+        starts at its right hard edge mid point and ends at its left one,
+        followed by the gce vertex if it was exported.
+
+                B       A       A = (0,1,2), B = (0,2,3)
+            3-------2-------1   dual edge A-B crosses tri edge (2,0)
+                 \  |  /        tri A's edge 2, tri B's edge 0
+                  \ | /
+                    0           0 = gceVertNdx
+    */
+    const UInt32 numTris = mesh_.triCount();
+    if (triEdges_.empty()) {
+        // allocated on first use
+        triEdges_.assign(3 * size_t(numTris), UInt32Undef);
+    }
+    const size_t numVerts = polyVerts.size();
+    polyEdges.resize(numVerts);
+    for (size_t ii = 0; ii < numVerts; ++ii) {
+        const UInt32 v0 = polyVerts[ii];
+        const UInt32 v1 = polyVerts[(ii + 1) % numVerts];
+        UInt32 slot0 = UInt32Undef;
+        UInt32 slot1 = UInt32Undef;
+        if (v0 < numTris) {
+            // leaving cell v0 across its left fan-edge
+            slot0 = triEdgeSlot(v0, true);
+            if (UInt32Undef == slot0) {
+                return false;
+            }
+        }
+        if (v1 < numTris) {
+            // entering cell v1 across its right fan-edge
+            slot1 = triEdgeSlot(v1, false);
+            if (UInt32Undef == slot1) {
+                return false;
+            }
+        }
+        if ((UInt32Undef == slot0) && (UInt32Undef == slot1)) {
+            polyEdges[ii] = matchHardSide(v0, v1, polyNdx);
+        }
+        else {
+            polyEdges[ii] = matchTriEdge(slot0, slot1, v0, v1, polyNdx);
+        }
+    }
+    return true;
+}
+
+
+UInt32
+DualEdgeBuilder::triEdgeSlot(UInt32 cell, bool leftEdge) const
+{
+    const UInt32 *tri = mesh_.tri(cell);
+    for (UInt32 ii = 0; ii < 3; ++ii) {
+        if (tri[ii] == gceVertNdx_) {
+            // the right fan-edge is tri edge ii, the left one is tri edge ii-1
+            return 3 * cell + (leftEdge ? (ii + 2) % 3 : ii);
+        }
+    }
+    return UInt32Undef;
+}
+
+
+UInt32
+DualEdgeBuilder::matchTriEdge(UInt32 slot0, UInt32 slot1, UInt32 v0,
+    UInt32 v1, UInt32 polyNdx)
+{
+    // An edge between 2 centroids is seen from both tris. An edge between a
+    // centroid and a hard edge mid point only from the centroid's tri.
+    const UInt32 slot = (UInt32Undef != slot0) ? slot0 : slot1;
+    UInt32 edgeNdx = triEdges_[slot];
+    if (UInt32Undef != edgeNdx) {
+        edgePolys_[edgeNdx][1] = polyNdx;
+    }
+    else {
+        edgeNdx = addEdge(v0, v1, polyNdx);
+        triEdges_[slot] = edgeNdx;
+        if ((UInt32Undef != slot0) && (UInt32Undef != slot1)) {
+            triEdges_[slot1] = edgeNdx;
+        }
+    }
+    return edgeNdx;
+}
+
+
+UInt32
+DualEdgeBuilder::matchHardSide(UInt32 v0, UInt32 v1, UInt32 polyNdx)
+{
+    // Only the polygons of the same gce vertex can share this edge. Two
+    // polygons meet here if a connection edge splits the vertex's fan.
+    UInt32Array1::iterator it = hardSides_.begin();
+    for (; it != hardSides_.end(); ++it) {
+        const Edge &verts = edgeVerts_[*it];
+        if ((verts[0] == v1) && (verts[1] == v0)) {
+            const UInt32 edgeNdx = *it;
+            edgePolys_[edgeNdx][1] = polyNdx;
+            hardSides_.erase(it);
+            return edgeNdx;
+        }
+    }
+    const UInt32 edgeNdx = addEdge(v0, v1, polyNdx);
+    hardSides_.push_back(edgeNdx);
+    return edgeNdx;
+}
+
+
+UInt32
+DualEdgeBuilder::addEdge(UInt32 v0, UInt32 v1, UInt32 polyNdx)
+{
+    Edge verts;
+    verts[0] = v0;
+    verts[1] = v1;
+    Edge polys;
+    polys[0] = polyNdx;
+    polys[1] = UInt32Undef;
+    edgeVerts_.push_back(verts);
+    edgePolys_.push_back(polys);
+    return UInt32(edgeVerts_.size() - 1);
+}
@@ -0,0 +1,106 @@
+/****************************************************************************
+ *
+ * class DualEdgeBuilder
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALEDGEBUILDER_H_
+#define _DUALEDGEBUILDER_H_
+
+#include "PluginTypes.h"
+#include "TriMesh.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Numbers the dual polygon edges and finds the 2 polygons that share each
+    edge while the polygons are built.
+
+    Polygon edge k joins the polygon's dual vertices k and k+1. Every dual
+    edge that touches a tri centroid lies inside that tri and crosses one of
+    its edges. It is looked up by that tri edge, so no edge hashing is
+    needed. The remaining edges join the hard edge and hard vertex dual
+    vertices of a single gce vertex and are matched among that vertex's
+    polygons only.
+
+    An edge is numbered when it is first seen. Its leftPoly is the polygon
+    that first used it and its dual vertices are in that polygon's order.
+    rightPoly is UInt32Undef for edges on the grid boundary.
+*/
+class DualEdgeBuilder {
+public:
+
+    DualEdgeBuilder(const TriMesh &mesh);
+    ~DualEdgeBuilder();
+
+    //! Must be called before adding the polygons of gceVertNdx.
+    void        beginVertex(UInt32 gceVertNdx);
+
+    //! Adds the polygon polyNdx of the current gce vertex. Sets polyEdges to
+    //! the polygon's dual edge indices. Returns false if a polygon cell does
+    //! not touch the gce vertex.
+    bool        addPoly(UInt32 polyNdx, const UInt32Array1 &polyVerts,
+                    UInt32Array1 &polyEdges);
+
+    inline UInt32
+    edgeCount() const
+    {
+        return UInt32(edgeVerts_.size());
+    }
+
+
+    inline const Edge &
+    edgeVerts(UInt32 edgeNdx) const
+    {
+        return edgeVerts_[edgeNdx];
+    }
+
+
+    inline UInt32
+    leftPoly(UInt32 edgeNdx) const
+    {
+        return edgePolys_[edgeNdx][0];
+    }
+
+
+    inline UInt32
+    rightPoly(UInt32 edgeNdx) const
+    {
+        return edgePolys_[edgeNdx][1];
+    }
+
+
+private:
+
+    UInt32      triEdgeSlot(UInt32 cell, bool leftEdge) const;
+    UInt32      matchTriEdge(UInt32 slot0, UInt32 slot1, UInt32 v0, UInt32 v1,
+                    UInt32 polyNdx);
+    UInt32      matchHardSide(UInt32 v0, UInt32 v1, UInt32 polyNdx);
+    UInt32      addEdge(UInt32 v0, UInt32 v1, UInt32 polyNdx);
+
+private:
+
+    const TriMesh & mesh_;
+
+    //! The gce vertex whose polygons are being added
+    UInt32          gceVertNdx_;
+
+    //! The dual edge crossing each tri edge. 3 per tri. Tri edge k joins tri
+    //! vertices k and k+1.
+    UInt32Array1    triEdges_;
+
+    //! The dual edges of the current gce vertex that do not touch a centroid
+    UInt32Array1    hardSides_;
+
+    //! Per dual edge, its dual vertices and its left/right polygons
+    EdgeArray1      edgeVerts_;
+    EdgeArray1      edgePolys_;
+};
+
+#endif // _DUALEDGEBUILDER_H_
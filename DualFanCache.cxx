@@ -0,0 +1,458 @@
+/****************************************************************************
+ *
+ * class DualFanCache
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "DualFanCache.h"
+#include "MappedFile.h"
+
+// touched_ values
+static const UInt8 Untouched = 0;
+static const UInt8 Touched = 1;
+static const UInt8 RingTouched = 2;
+
+// The cache file starts with FileMagic and a FileHeader
+static const char FileMagic[] = "DUALTPC1";
+static const UInt32 FileVersion = 1;
+
+struct FileHeader {
+    UInt32              version_;
+    UInt32              numVerts_;
+    UInt32              numTris_;
+    UInt32              numHardKeys_;
+    UInt32              numPolys_;
+    UInt32              numPolyVerts_;
+    unsigned long long  key_;
+};
+
+// Arrays are padded to 8 bytes
+static size_t
+padded(size_t numBytes)
+{
+    return (numBytes + 7) & ~size_t(7);
+}
+
+
+static bool
+writeArray(std::FILE *fp, const void *data, size_t numBytes)
+{
+    static const char zeros[8] = { 0 };
+    const size_t pad = padded(numBytes) - numBytes;
+    return ((0 == numBytes) || (1 == fwrite(data, numBytes, 1, fp))) &&
+        ((0 == pad) || (1 == fwrite(zeros, pad, 1, fp)));
+}
+
+
+// 64 bit FNV-1a over 32 bit words
+static const unsigned long long HashBasis = 14695981039346656037ULL;
+static const unsigned long long HashPrime = 1099511628211ULL;
+
+static inline void
+hashWord(unsigned long long &hash, UInt32 word)
+{
+    hash = (hash ^ word) * HashPrime;
+}
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualFanCache::DualFanCache() :
+    numVerts_(0),
+    tris_(),
+    hardKeys_(),
+    fanOffsets_(),
+    polyOffsets_(),
+    polyVerts_(),
+    hardRemap_(),
+    touched_(),
+    newTris_(),
+    newHardKeys_(),
+    newFanOffsets_(),
+    newPolyOffsets_(),
+    newPolyVerts_(),
+    numReused_(0),
+    numRebuilt_(0)
+{
+}
+
+
+DualFanCache::~DualFanCache()
+{
+}
+
+
+void
+DualFanCache::clear()
+{
+    // swap with empty arrays to release the memory
+    DualFanCache empty;
+    std::swap(*this, empty);
+}
+
+
+void
+DualFanCache::begin(const TriMesh &mesh, const UInt32Array1 &vertCellOffsets,
+    const UInt32Array1 &vertCells,
+    const HardEdgeIndex &hardEdges,
+    const UInt32ToUInt32Map &hardGceVertToDualVert)
+{
+    numReused_ = 0;
+    numRebuilt_ = 0;
+    const UInt32 numTris = mesh.triCount();
+    newTris_.assign(mesh.triArray(), mesh.triArray() + 3 * size_t(numTris));
+    newHardKeys_.clear();
+    newHardKeys_.resize(hardEdges.edgeCount());
+    for (UInt32 ii = 0; ii < hardEdges.edgeCount(); ++ii) {
+        newHardKeys_[ii] = hardEdges.edge(ii);
+    }
+    UInt32ToUInt32Map::const_iterator itVert = hardGceVertToDualVert.begin();
+    for (; itVert != hardGceVertToDualVert.end(); ++itVert) {
+        const UInt32 ndx = itVert->second - numTris;
+        if (ndx >= newHardKeys_.size()) {
+            newHardKeys_.resize(ndx + 1, Edge(UInt32Undef, UInt32Undef));
+        }
+        newHardKeys_[ndx] = Edge(itVert->first, UInt32Undef);
+    }
+    newFanOffsets_.assign(1, 0);
+    newPolyOffsets_.assign(1, 0);
+    newPolyVerts_.clear();
+    if (empty()) {
+        touched_.assign(mesh.vertexCount(), Touched);
+    }
+    else {
+        markTouched(mesh, vertCellOffsets, vertCells, hardEdges,
+            hardGceVertToDualVert);
+    }
+}
+
+
+bool
+DualFanCache::reuseFans(UInt32 gceVertNdx, UInt32Array2 &fans)
+{
+    fans.clear();
+    bool ret = (gceVertNdx < touched_.size()) &&
+        (Untouched == touched_[gceVertNdx]);
+    if (ret) {
+        for (UInt32 poly = fanOffsets_[gceVertNdx];
+                ret && (poly < fanOffsets_[gceVertNdx + 1]); ++poly) {
+            fans.push_back(UInt32Array1());
+            UInt32Array1 &fan = fans.back();
+            fan.reserve(polyOffsets_[poly + 1] - polyOffsets_[poly]);
+            for (UInt32 ii = polyOffsets_[poly];
+                    ret && (ii < polyOffsets_[poly + 1]); ++ii) {
+                UInt32 dualNdx;
+                ret = remap(polyVerts_[ii], dualNdx);
+                fan.push_back(dualNdx);
+            }
+        }
+    }
+    if (ret) {
+        ++numReused_;
+    }
+    else {
+        fans.clear();
+        ++numRebuilt_;
+    }
+    return ret;
+}
+
+
+void
+DualFanCache::addFans(UInt32 gceVertNdx, const UInt32Array2 &fans)
+{
+    // vertices without cells have no polygons
+    while (newFanOffsets_.size() <= gceVertNdx) {
+        newFanOffsets_.push_back(newFanOffsets_.back());
+    }
+    UInt32Array2::const_iterator itFan = fans.begin();
+    for (; itFan != fans.end(); ++itFan) {
+        newPolyVerts_.insert(newPolyVerts_.end(), itFan->begin(),
+            itFan->end());
+        newPolyOffsets_.push_back(UInt32(newPolyVerts_.size()));
+    }
+    newFanOffsets_.push_back(UInt32(newPolyOffsets_.size() - 1));
+}
+
+
+void
+DualFanCache::end()
+{
+    const UInt32 numVerts = UInt32(touched_.size());
+    while (newFanOffsets_.size() <= numVerts) {
+        newFanOffsets_.push_back(newFanOffsets_.back());
+    }
+    numVerts_ = numVerts;
+    tris_.swap(newTris_);
+    hardKeys_.swap(newHardKeys_);
+    fanOffsets_.swap(newFanOffsets_);
+    polyOffsets_.swap(newPolyOffsets_);
+    polyVerts_.swap(newPolyVerts_);
+    // release the scratch arrays
+    UInt32Array1().swap(newTris_);
+    EdgeArray1().swap(newHardKeys_);
+    UInt32Array1().swap(newFanOffsets_);
+    UInt32Array1().swap(newPolyOffsets_);
+    UInt32Array1().swap(newPolyVerts_);
+    UInt32Array1().swap(hardRemap_);
+    UInt8Array1().swap(touched_);
+}
+
+
+void
+DualFanCache::markTouched(const TriMesh &mesh,
+    const UInt32Array1 &vertCellOffsets, const UInt32Array1 &vertCells,
+    const HardEdgeIndex &hardEdges,
+    const UInt32ToUInt32Map &hardGceVertToDualVert)
+{
+    const UInt32 numVerts = mesh.vertexCount();
+    const UInt32 numTris = mesh.triCount();
+    const UInt32 oldNumTris = UInt32(tris_.size() / 3);
+    touched_.assign(numVerts, Untouched);
+    for (UInt32 ii = numVerts_; ii < numVerts; ++ii) {
+        touched_[ii] = Touched;
+    }
+
+    // Tris that changed, were added or were removed
+    for (UInt32 cell = 0; cell < std::max(numTris, oldNumTris); ++cell) {
+        const UInt32 *oldTri = (cell < oldNumTris) ? &tris_[3 * size_t(cell)] :
+            0;
+        const UInt32 *tri = (cell < numTris) ? mesh.tri(cell) : 0;
+        if ((0 != oldTri) && (0 != tri) && (oldTri[0] == tri[0]) &&
+                (oldTri[1] == tri[1]) && (oldTri[2] == tri[2])) {
+            continue;
+        }
+        if (0 != oldTri) {
+            touchTri(oldTri);
+        }
+        if (0 != tri) {
+            touchTri(tri);
+        }
+    }
+
+    // Hard edges and exported hard vertices that were removed. The others
+    // are remapped to their new dual index.
+    hardRemap_.assign(hardKeys_.size(), UInt32Undef);
+    UInt8Array1 isMapped(newHardKeys_.size(), 0);
+    for (size_t ii = 0; ii < hardKeys_.size(); ++ii) {
+        const Edge &key = hardKeys_[ii];
+        if (UInt32Undef == key[0]) {
+            continue;
+        }
+        if (UInt32Undef == key[1]) {
+            UInt32ToUInt32Map::const_iterator it =
+                hardGceVertToDualVert.find(key[0]);
+            if (hardGceVertToDualVert.end() != it) {
+                hardRemap_[ii] = it->second;
+            }
+        }
+        else if (!hardEdges.findEdge(key, hardRemap_[ii])) {
+            hardRemap_[ii] = UInt32Undef;
+        }
+        if (UInt32Undef == hardRemap_[ii]) {
+            touchKey(key);
+        }
+        else {
+            isMapped[hardRemap_[ii] - numTris] = 1;
+        }
+    }
+    // Hard edges and exported hard vertices that were added
+    for (size_t ii = 0; ii < newHardKeys_.size(); ++ii) {
+        if (!isMapped[ii] && (UInt32Undef != newHardKeys_[ii][0])) {
+            touchKey(newHardKeys_[ii]);
+        }
+    }
+
+    // Add the one-ring of the touched vertices
+    for (UInt32 vert = 0; vert < numVerts; ++vert) {
+        if (Touched != touched_[vert]) {
+            continue;
+        }
+        for (UInt32 ii = vertCellOffsets[vert]; ii < vertCellOffsets[vert + 1];
+                ++ii) {
+            const UInt32 *tri = mesh.tri(vertCells[ii]);
+            for (UInt32 jj = 0; jj < 3; ++jj) {
+                if ((tri[jj] < numVerts) && (Untouched == touched_[tri[jj]])) {
+                    touched_[tri[jj]] = RingTouched;
+                }
+            }
+        }
+    }
+}
+
+
+bool
+DualFanCache::remap(UInt32 dualNdx, UInt32 &newNdx) const
+{
+    // Centroids of untouched vertices belong to unchanged tris and keep
+    // their index.
+    const UInt32 oldNumTris = UInt32(tris_.size() / 3);
+    newNdx = (dualNdx < oldNumTris) ? dualNdx :
+        ((dualNdx - oldNumTris < hardRemap_.size()) ?
+            hardRemap_[dualNdx - oldNumTris] : UInt32Undef);
+    return UInt32Undef != newNdx;
+}
+
+
+void
+DualFanCache::touchTri(const UInt32 *tri)
+{
+    for (UInt32 ii = 0; ii < 3; ++ii) {
+        if (tri[ii] < touched_.size()) {
+            touched_[tri[ii]] = Touched;
+        }
+    }
+}
+
+
+void
+DualFanCache::touchKey(const Edge &key)
+{
+    for (UInt32 ii = 0; ii < 2; ++ii) {
+        if (key[ii] < touched_.size()) {
+            touched_[key[ii]] = Touched;
+        }
+    }
+}
+
+
+bool
+DualFanCache::save(const char *fileName, unsigned long long key) const
+{
+    if (empty()) {
+        return false;
+    }
+    std::FILE *fp = fopen(fileName, "wb");
+    if (0 == fp) {
+        return false;
+    }
+    FileHeader header = { FileVersion, numVerts_, UInt32(tris_.size() / 3),
+        UInt32(hardKeys_.size()), UInt32(polyOffsets_.size() - 1),
+        UInt32(polyVerts_.size()), key };
+    UInt32Array1 keys(2 * hardKeys_.size());
+    for (size_t ii = 0; ii < hardKeys_.size(); ++ii) {
+        keys[2 * ii] = hardKeys_[ii][0];
+        keys[2 * ii + 1] = hardKeys_[ii][1];
+    }
+    bool ret = (1 == fwrite(FileMagic, sizeof(FileMagic) - 1, 1, fp)) &&
+        (1 == fwrite(&header, sizeof(header), 1, fp)) &&
+        writeArray(fp, tris_.empty() ? 0 : &tris_[0],
+            tris_.size() * sizeof(UInt32)) &&
+        writeArray(fp, keys.empty() ? 0 : &keys[0],
+            keys.size() * sizeof(UInt32)) &&
+        writeArray(fp, &fanOffsets_[0], fanOffsets_.size() * sizeof(UInt32)) &&
+        writeArray(fp, &polyOffsets_[0],
+            polyOffsets_.size() * sizeof(UInt32)) &&
+        writeArray(fp, polyVerts_.empty() ? 0 : &polyVerts_[0],
+            polyVerts_.size() * sizeof(UInt32));
+    ret = (0 == fclose(fp)) && ret;
+    if (!ret) {
+        // do not leave a truncated cache behind
+        remove(fileName);
+    }
+    return ret;
+}
+
+
+bool
+DualFanCache::load(const char *fileName, unsigned long long key)
+{
+    MappedFile file;
+    if (!file.open(fileName) ||
+            (file.size() < sizeof(FileMagic) - 1 + sizeof(FileHeader))) {
+        return false;
+    }
+    const char *data = static_cast<const char *>(file.data());
+    FileHeader header;
+    memcpy(&header, data + sizeof(FileMagic) - 1, sizeof(header));
+    if ((0 != memcmp(data, FileMagic, sizeof(FileMagic) - 1)) ||
+            (FileVersion != header.version_) || (key != header.key_)) {
+        return false;
+    }
+    // The array sizes in bytes in file order
+    const size_t sizes[5] = {
+        3 * size_t(header.numTris_) * sizeof(UInt32),
+        2 * size_t(header.numHardKeys_) * sizeof(UInt32),
+        (size_t(header.numVerts_) + 1) * sizeof(UInt32),
+        (size_t(header.numPolys_) + 1) * sizeof(UInt32),
+        size_t(header.numPolyVerts_) * sizeof(UInt32)
+    };
+    size_t offsets[6] = { sizeof(FileMagic) - 1 + sizeof(FileHeader) };
+    for (int ii = 0; ii < 5; ++ii) {
+        offsets[ii + 1] = offsets[ii] + padded(sizes[ii]);
+    }
+    if (offsets[5] != file.size()) {
+        return false;
+    }
+    const UInt32 *arrays[5];
+    for (int ii = 0; ii < 5; ++ii) {
+        arrays[ii] = reinterpret_cast<const UInt32 *>(data + offsets[ii]);
+    }
+    const UInt32 *fanOffsets = arrays[2];
+    const UInt32 *polyOffsets = arrays[3];
+    if ((0 != fanOffsets[0]) ||
+            (header.numPolys_ != fanOffsets[header.numVerts_]) ||
+            (0 != polyOffsets[0]) ||
+            (header.numPolyVerts_ != polyOffsets[header.numPolys_])) {
+        return false;
+    }
+    clear();
+    numVerts_ = header.numVerts_;
+    tris_.assign(arrays[0], arrays[0] + 3 * size_t(header.numTris_));
+    hardKeys_.resize(header.numHardKeys_);
+    for (UInt32 ii = 0; ii < header.numHardKeys_; ++ii) {
+        hardKeys_[ii] = Edge(arrays[1][2 * size_t(ii)],
+            arrays[1][2 * size_t(ii) + 1]);
+    }
+    fanOffsets_.assign(fanOffsets, fanOffsets + header.numVerts_ + 1);
+    polyOffsets_.assign(polyOffsets, polyOffsets + header.numPolys_ + 1);
+    polyVerts_.assign(arrays[4], arrays[4] + header.numPolyVerts_);
+    return true;
+}
+
+
+unsigned long long
+DualFanCache::topologyKey(const TriMesh &mesh, const HardMidArray1 &bndryMids,
+    const HardMidArray1 &cnxnMids, double cosMaxTurnAngle)
+{
+    unsigned long long hash = HashBasis;
+    hashWord(hash, mesh.vertexCount());
+    hashWord(hash, mesh.triCount());
+    const UInt32 *tris = mesh.triArray();
+    for (size_t ii = 0; ii < 3 * size_t(mesh.triCount()); ++ii) {
+        hashWord(hash, tris[ii]);
+    }
+    const HardMidArray1 *mids[2] = { &bndryMids, &cnxnMids };
+    for (int ii = 0; ii < 2; ++ii) {
+        hashWord(hash, UInt32(mids[ii]->size()));
+        HardMidArray1::const_iterator it = mids[ii]->begin();
+        for (; it != mids[ii]->end(); ++it) {
+            hashWord(hash, it->edge_[0]);
+            hashWord(hash, it->edge_[1]);
+            hashWord(hash, it->owner_);
+            hashWord(hash, it->neighbor_);
+        }
+    }
+    UInt32 angle[2];
+    memcpy(angle, &cosMaxTurnAngle, sizeof(angle));
+    hashWord(hash, angle[0]);
+    hashWord(hash, angle[1]);
+    return hash;
+}
+
+
+const char *
+DualFanCache::fileMagic()
+{
+    return FileMagic;
+}
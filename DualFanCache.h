@@ -0,0 +1,158 @@
+/****************************************************************************
+ *
+ * class DualFanCache
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALFANCACHE_H_
+#define _DUALFANCACHE_H_
+
+#include "HardEdgeIndex.h"
+#include "PluginTypes.h"
+#include "TriMesh.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Keeps the sorted fans of a DualMeshBuilder run so the next run over a
+    locally edited mesh can reuse them.
+
+    The cache holds a copy of the tris, the hard edge and exported hard
+    vertex numbering and the dual polygons of every vertex. When a builder
+    run is given the cache, it diffs the new tris and hard edges against the
+    cached ones by index. A vertex is touched if one of its cells changed, a
+    hard edge at it was added or removed, or its export state changed. The
+    touched vertices and their one-ring are sorted again. All other vertices
+    reuse their cached polygons. The dual vertex indices are remapped, so a
+    changed tri or hard edge count only renumbers the mid and hard vertex
+    dual indices.
+
+    The cache is replaced with the new run's data as the run proceeds.
+
+    save() writes the cached run to a file tagged with a topologyKey() of the
+    tris, hard edges and turning angle. A later process can load() the file
+    if its key matches and reuse every fan whose hard vertex export state
+    did not change. See README.md for the file layout.
+*/
+class DualFanCache {
+public:
+
+    DualFanCache();
+    ~DualFanCache();
+
+    void        clear();
+
+    inline bool
+    empty() const
+    {
+        return fanOffsets_.empty();
+    }
+
+
+    //! Number of vertices whose polygons were reused by the last run
+    inline UInt32
+    reusedVertexCount() const
+    {
+        return numReused_;
+    }
+
+
+    //! Number of vertices whose polygons were rebuilt by the last run
+    inline UInt32
+    rebuiltVertexCount() const
+    {
+        return numRebuilt_;
+    }
+
+
+    //! Diffs the new mesh against the cached one and starts recording the
+    //! new run. vertCellOffsets and vertCells are the new vertex to cell
+    //! lists. hardEdges and hardGceVertToDualVert must hold the new hard
+    //! edge and hard vertex dual indices.
+    void        begin(const TriMesh &mesh, const UInt32Array1 &vertCellOffsets,
+                    const UInt32Array1 &vertCells,
+                    const HardEdgeIndex &hardEdges,
+                    const UInt32ToUInt32Map &hardGceVertToDualVert);
+
+    //! Sets fans to the remapped cached polygons of gceVertNdx. Returns
+    //! false if the vertex was touched and must be sorted again.
+    bool        reuseFans(UInt32 gceVertNdx, UInt32Array2 &fans);
+
+    //! Records the polygons of gceVertNdx for the next run. Must be called
+    //! for every vertex in ascending order.
+    void        addFans(UInt32 gceVertNdx, const UInt32Array2 &fans);
+
+    //! Makes the recorded run the cached run
+    void        end();
+
+    //! Writes the cached run to fileName tagged with key. Returns false if
+    //! the cache is empty or the write failed.
+    bool        save(const char *fileName, unsigned long long key) const;
+
+    //! Replaces the cache with the run saved in fileName if the file is
+    //! valid and was saved with key. Otherwise the cache is not changed and
+    //! false is returned.
+    bool        load(const char *fileName, unsigned long long key);
+
+    //! Hash of the tris, the hard edges and their owner cells and the
+    //! turning angle
+    static unsigned long long topologyKey(const TriMesh &mesh,
+                    const HardMidArray1 &bndryMids,
+                    const HardMidArray1 &cnxnMids, double cosMaxTurnAngle);
+
+    static const char * fileMagic();
+
+private:
+
+    void        markTouched(const TriMesh &mesh,
+                    const UInt32Array1 &vertCellOffsets,
+                    const UInt32Array1 &vertCells,
+                    const HardEdgeIndex &hardEdges,
+                    const UInt32ToUInt32Map &hardGceVertToDualVert);
+    bool        remap(UInt32 dualNdx, UInt32 &newNdx) const;
+    void        touchTri(const UInt32 *tri);
+    void        touchKey(const Edge &key);
+
+private:
+
+    //! The cached run
+    UInt32              numVerts_;
+    UInt32Array1        tris_;
+
+    //! The key of each hard dual vertex, index = dualNdx - numTris. A hard
+    //! edge mid point is keyed by its edge. An exported hard gce vertex v is
+    //! keyed by (v, UInt32Undef).
+    EdgeArray1          hardKeys_;
+
+    //! Polygons of vertex v are polys [fanOffsets_[v] .. fanOffsets_[v+1]).
+    //! The dual vertices of poly p are
+    //! polyVerts_[polyOffsets_[p] .. polyOffsets_[p+1]).
+    UInt32Array1        fanOffsets_;
+    UInt32Array1        polyOffsets_;
+    UInt32Array1        polyVerts_;
+
+    //! Maps each cached hardKeys_ entry to its new dual vertex index.
+    //! UInt32Undef if it no longer exists.
+    UInt32Array1        hardRemap_;
+
+    //! 1 for each new vertex that must be sorted again
+    UInt8Array1         touched_;
+
+    //! The run being recorded
+    UInt32Array1        newTris_;
+    EdgeArray1          newHardKeys_;
+    UInt32Array1        newFanOffsets_;
+    UInt32Array1        newPolyOffsets_;
+    UInt32Array1        newPolyVerts_;
+
+    UInt32              numReused_;
+    UInt32              numRebuilt_;
+};
+
+#endif // _DUALFANCACHE_H_
@@ -0,0 +1,625 @@
+/****************************************************************************
+ *
+ * class DualMeshBuilder
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#include "DualAgglomerator.h"
+#include "DualCellQuery.h"
+#include "DualMeshBuilder.h"
+#include "DualTrace.h"
+#include "FanSorter.h"
+#include "PluginTypes.h"
+#include "TopologyValidator.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualMeshBuilder::DualMeshBuilder(const TriMesh &mesh) :
+    mesh_(mesh),
+    cosMaxTurnAngle_(cos(30.0 * 3.1415926535897932384626433832795 / 180.0)),
+    placement_(),
+    dualEdges_(false),
+    numAggLevels_(0),
+    fanCache_(0),
+    region_(0),
+    elemXyz_(),
+    bndryMids_(),
+    cnxnMids_(),
+    vertCellOffsets_(),
+    vertCells_(),
+    hardEdgeIndex_(),
+    hardGceVertToDualVert_(),
+    vertFlags_(),
+    numHardVerts_(0),
+    polyClasses_()
+{
+    mesh_.findPlane();
+}
+
+
+DualMeshBuilder::~DualMeshBuilder()
+{
+}
+
+
+void
+DualMeshBuilder::setMesh(const TriMesh &mesh)
+{
+    mesh_ = mesh;
+    mesh_.findPlane();
+}
+
+
+void
+DualMeshBuilder::setMaxTurnAngle(double maxTurnAngleDeg)
+{
+    const double Deg2Rad = 3.1415926535897932384626433832795 / 180.0;
+    cosMaxTurnAngle_ = cos(maxTurnAngleDeg * Deg2Rad);
+}
+
+
+void
+DualMeshBuilder::setPlacement(DualPlacement::Strategy strategy)
+{
+    placement_.setStrategy(strategy);
+}
+
+
+void
+DualMeshBuilder::setDualEdges(bool enable)
+{
+    dualEdges_ = enable;
+}
+
+
+void
+DualMeshBuilder::setAggLevels(UInt32 numLevels)
+{
+    numAggLevels_ = numLevels;
+}
+
+
+void
+DualMeshBuilder::setFanCache(DualFanCache *cache)
+{
+    fanCache_ = cache;
+}
+
+
+void
+DualMeshBuilder::setRegion(const DualRegion *region)
+{
+    region_ = region;
+}
+
+
+void
+DualMeshBuilder::addBndryEdge(UInt32 v0, UInt32 v1, UInt32 ownerCell)
+{
+    HardMid mid = { Edge(v0, v1), ownerCell, UInt32Undef };
+    bndryMids_.push_back(mid);
+}
+
+
+void
+DualMeshBuilder::addCnxnEdge(UInt32 v0, UInt32 v1, UInt32 ownerCell,
+    UInt32 neighborCell)
+{
+    HardMid mid = { Edge(v0, v1), ownerCell, neighborCell };
+    cnxnMids_.push_back(mid);
+}
+
+
+UInt32
+DualMeshBuilder::findBndryEdges()
+{
+    // Each tri edge is stored as (minNdx, maxNdx, cellNdx, localEdgeNdx).
+    // After sorting, an edge used by only one tri is a boundary edge.
+    struct TriEdge {
+        UInt32 v0;
+        UInt32 v1;
+        UInt32 cell;
+        UInt32 local;
+
+        bool operator<(const TriEdge &rhs) const {
+            return (v0 < rhs.v0) || ((v0 == rhs.v0) && (v1 < rhs.v1));
+        }
+    };
+    MemoryStats::Scope memScope(MemoryStats::Mesh);
+    std::vector<TriEdge, DUAL_ALLOCATOR(TriEdge)> edges;
+    edges.reserve(3 * size_t(mesh_.triCount()));
+    for (UInt32 cell = 0; cell < mesh_.triCount(); ++cell) {
+        const UInt32 *tri = mesh_.tri(cell);
+        for (UInt32 ii = 0; ii < 3; ++ii) {
+            const UInt32 a = tri[ii];
+            const UInt32 b = tri[(ii + 1) % 3];
+            TriEdge e = { std::min(a, b), std::max(a, b), cell, ii };
+            edges.push_back(e);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    const size_t before = bndryMids_.size();
+    size_t ii = 0;
+    while (ii < edges.size()) {
+        size_t jj = ii + 1;
+        while ((jj < edges.size()) && !(edges[ii] < edges[jj])) {
+            ++jj;
+        }
+        if (1 == jj - ii) {
+            // keep the owner tri's winding
+            const UInt32 *tri = mesh_.tri(edges[ii].cell);
+            const UInt32 local = edges[ii].local;
+            addBndryEdge(tri[local], tri[(local + 1) % 3], edges[ii].cell);
+        }
+        ii = jj;
+    }
+    return UInt32(bndryMids_.size() - before);
+}
+
+
+bool
+DualMeshBuilder::run(DualMeshSink &sink)
+{
+    if (0 != region_) {
+        return runRegion(sink);
+    }
+    // edges is only filled if the dual edges or agglomeration levels are on
+    DualEdgeBuilder edges(mesh_);
+    return validate(sink) && writeGceVertices(sink) && writeCentroids(sink) &&
+        writeHardMids(sink) && writeHardGceVertices(sink) &&
+        writePolys(edges, sink) && writeAggLevels(edges, sink) &&
+        sink.endMesh();
+}
+
+
+bool
+DualMeshBuilder::runRegion(DualMeshSink &sink)
+{
+    // The polygons of the selected vertices are built by a DualCellQuery.
+    // Only the tris and hard edges around them are placed and sorted, so
+    // the cost is proportional to the region plus the O(n) validation,
+    // selection and vertex to cell lists. The mesh is validated as for a
+    // full export, so bad topology outside the region fails it too.
+    if (dualEdges_ || (0 != numAggLevels_)) {
+        sink.warningMsg("dual edges and agglomeration levels are not written "
+            "for a region");
+    }
+    UInt32Array1 verts;
+    if (!validate(sink)) {
+        return false;
+    }
+    bool ret = sink.beginStep(1);
+    if (ret) {
+        MemoryStats::Scope memScope(MemoryStats::Topology);
+        region_->select(mesh_, bndryMids_, cnxnMids_, verts);
+        if (verts.empty()) {
+            sink.warningMsg("the region does not contain any vertices");
+        }
+        ret = sink.incrementStep();
+    }
+    ret = sink.endStep() && ret;
+    DualCellArray1 cells;
+    return ret && queryRegion(verts, cells, sink) &&
+        writeRegionVerts(verts, cells, sink) &&
+        writeRegionPolys(verts, cells, sink) && sink.endMesh();
+}
+
+
+bool
+DualMeshBuilder::queryRegion(const UInt32Array1 &verts, DualCellArray1 &cells,
+    DualMeshSink &sink)
+{
+    MemoryStats::Scope memScope(MemoryStats::Fans);
+    const UInt32 numVerts = UInt32(verts.size());
+    bool ret = sink.beginStep(numVerts);
+    DualCellQuery query(*this);
+    for (UInt32 ii = 0; ret && (ii < numVerts); ++ii) {
+        if (!query.query(verts[ii], cells)) {
+            sink.errorMsg("region vertex references an invalid vertex, cell "
+                "or hard edge index");
+            ret = false;
+        }
+        ret = ret && sink.incrementStep();
+    }
+    return sink.endStep() && ret;
+}
+
+
+bool
+DualMeshBuilder::writeRegionVerts(const UInt32Array1 &verts,
+    DualCellArray1 &cells, DualMeshSink &sink)
+{
+    // The used dual vertices in ascending order keep the class order of the
+    // full numbering. Their position in used is their region index.
+    MemoryStats::Scope memScope(MemoryStats::Topology);
+    UInt32Array1 used;
+    DualCellArray1::iterator itCell = cells.begin();
+    for (; itCell != cells.end(); ++itCell) {
+        used.insert(used.end(), itCell->dualVerts_.begin(),
+            itCell->dualVerts_.end());
+    }
+    std::sort(used.begin(), used.end());
+    used.erase(std::unique(used.begin(), used.end()), used.end());
+    const UInt32 numUsed = UInt32(used.size());
+    DoubleArray1 usedXyz(3 * size_t(numUsed));
+    for (itCell = cells.begin(); itCell != cells.end(); ++itCell) {
+        UInt32Array1 &dualVerts = itCell->dualVerts_;
+        for (size_t ii = 0; ii < dualVerts.size(); ++ii) {
+            dualVerts[ii] = UInt32(std::lower_bound(used.begin(), used.end(),
+                dualVerts[ii]) - used.begin());
+            std::copy(&itCell->xyz_[3 * ii], &itCell->xyz_[3 * ii] + 3,
+                &usedXyz[3 * size_t(dualVerts[ii])]);
+        }
+    }
+    const UInt32 numTris = mesh_.triCount();
+    const UInt32 numBndryMids = UInt32(bndryMids_.size());
+    const UInt32 numMids = numBndryMids + UInt32(cnxnMids_.size());
+    const UInt32 numElems = UInt32(std::lower_bound(used.begin(), used.end(),
+        numTris) - used.begin());
+    const UInt32 numBndry = UInt32(std::lower_bound(used.begin(), used.end(),
+        numTris + numBndryMids) - used.begin()) - numElems;
+    const UInt32 numCnxn = UInt32(std::lower_bound(used.begin(), used.end(),
+        numTris + numMids) - used.begin()) - numElems - numBndry;
+
+    bool ret = sink.beginStep(numUsed);
+    Vec3 v;
+    for (UInt32 ii = 0; ret && (ii < UInt32(verts.size())); ++ii) {
+        ret = mesh_.getCoord(verts[ii], v) && sink.writeGceVertex(ii, v);
+    }
+    ret = ret && sink.beginCentroids(numElems) &&
+        sink.beginHardMids(numBndry, numCnxn);
+    for (UInt32 ii = 0; ret && (ii < numUsed); ++ii) {
+        DualMeshSink::VertType vType = DualMeshSink::GceVert;
+        if (used[ii] < numTris) {
+            vType = DualMeshSink::ElemVert;
+        }
+        else if (used[ii] < numTris + numBndryMids) {
+            vType = DualMeshSink::BndryVert;
+        }
+        else if (used[ii] < numTris + numMids) {
+            vType = DualMeshSink::CnxnVert;
+        }
+        const double *p = &usedXyz[3 * size_t(ii)];
+        v.set(p[0], p[1], p[2]);
+        ret = sink.writeVertex(ii, v, vType) && sink.incrementStep();
+    }
+    return sink.endStep() && ret;
+}
+
+
+bool
+DualMeshBuilder::writeRegionPolys(const UInt32Array1 &verts,
+    const DualCellArray1 &cells, DualMeshSink &sink)
+{
+    // The gce vertices are numbered by their position in verts
+    bool ret = sink.beginStep(UInt32(cells.size()));
+    DualCellArray1::const_iterator it = cells.begin();
+    for (; ret && (it != cells.end()); ++it) {
+        const UInt32 gceVertNdx = UInt32(std::lower_bound(verts.begin(),
+            verts.end(), it->gceVert_) - verts.begin());
+        ret = sink.writePoly(gceVertNdx, it->isBndry_, it->dualVerts_) &&
+            sink.incrementStep();
+    }
+    return sink.endStep() && ret;
+}
+
+
+bool
+DualMeshBuilder::validate(DualMeshSink &sink)
+{
+    // Catch bad topology before any output is written. The later stages
+    // rely on the validated indices and on the vertex classification.
+    MemoryStats::Scope memScope(MemoryStats::Topology);
+    TopologyValidator validator(mesh_);
+    bool ret = sink.beginStep(1) &&
+        validator.run(bndryMids_, cnxnMids_, sink) && sink.incrementStep();
+    if (ret) {
+        vertFlags_.swap(validator.vertFlags());
+        numHardVerts_ = validator.hardVertCount();
+    }
+    return sink.endStep() && ret;
+}
+
+
+bool
+DualMeshBuilder::writeGceVertices(DualMeshSink &sink)
+{
+    bool ret = true;
+    Vec3 v;
+    for (UInt32 ii = 0; ret && (ii < mesh_.vertexCount()); ++ii) {
+        ret = mesh_.getCoord(ii, v) && sink.writeGceVertex(ii, v);
+    }
+    return ret;
+}
+
+
+bool
+DualMeshBuilder::writeCentroids(DualMeshSink &sink)
+{
+    const UInt32 numCentroids = mesh_.triCount();
+    bool ret = sink.beginStep(numCentroids) &&
+        sink.beginCentroids(numCentroids);
+    if (ret) {
+        MemoryStats::Scope memScope(MemoryStats::Placement);
+        elemXyz_.resize(3 * size_t(numCentroids));
+        if (!placement_.placeElemVerts(mesh_,
+                elemXyz_.empty() ? 0 : &elemXyz_[0])) {
+            sink.errorMsg("tri references an invalid vertex index");
+            ret = false;
+        }
+        Vec3 v;
+        for (UInt32 dualNdx = 0; ret && (dualNdx < numCentroids); ++dualNdx) {
+            const double *p = &elemXyz_[3 * size_t(dualNdx)];
+            v.set(p[0], p[1], p[2]);
+            if (!sink.writeVertex(dualNdx, v, DualMeshSink::ElemVert) ||
+                    !sink.incrementStep()) {
+                ret = false;
+                break;
+            }
+        }
+        MemoryStats::Scope vertCellsScope(MemoryStats::Topology);
+        buildVertCells(mesh_, vertCellOffsets_, vertCells_);
+    }
+    return sink.endStep() && ret;
+}
+
+
+bool
+DualMeshBuilder::writeHardMids(DualMeshSink &sink)
+{
+    const UInt32 numBndryMids = UInt32(bndryMids_.size());
+    const UInt32 numCnxnMids = UInt32(cnxnMids_.size());
+    bool ret = sink.beginStep(numBndryMids + numCnxnMids) &&
+        sink.beginHardMids(numBndryMids, numCnxnMids);
+    // Place all boundary mids and then all connection mids
+    MemoryStats::Scope memScope(MemoryStats::Placement);
+    DoubleArray1 midXyz(3 * size_t(numBndryMids + numCnxnMids));
+    const double *elemXyz = elemXyz_.empty() ? 0 : &elemXyz_[0];
+    if (ret && !midXyz.empty() &&
+            (!placement_.placeHardMids(mesh_, elemXyz,
+                bndryMids_.empty() ? 0 : &bndryMids_[0], numBndryMids,
+                &midXyz[0]) ||
+            !placement_.placeHardMids(mesh_, elemXyz,
+                cnxnMids_.empty() ? 0 : &cnxnMids_[0], numCnxnMids,
+                &midXyz[3 * size_t(numBndryMids)]))) {
+        sink.errorMsg("hard edge references an invalid vertex or cell index");
+        ret = false;
+    }
+    UInt32 dualNdx = mesh_.triCount();
+    Vec3 pt;
+    for (UInt32 ii = 0; ret && (ii < numBndryMids + numCnxnMids);
+            ++ii, ++dualNdx) {
+        const bool isBndry = (ii < numBndryMids);
+        const HardMid &mid = isBndry ? bndryMids_[ii] :
+            cnxnMids_[ii - numBndryMids];
+        const double *p = &midXyz[3 * size_t(ii)];
+        pt.set(p[0], p[1], p[2]);
+        DUAL_TRACE3(HardEdgeAdd, mid.edge_[0], mid.edge_[1], dualNdx);
+        ret = sink.writeVertex(dualNdx, pt, isBndry ? DualMeshSink::BndryVert :
+                DualMeshSink::CnxnVert) && sink.incrementStep();
+    }
+    MemoryStats::setCategory(MemoryStats::Topology);
+    if (ret && !hardEdgeIndex_.build(mesh_.vertexCount(), bndryMids_,
+            cnxnMids_, mesh_.triCount())) {
+        sink.errorMsg("hard edge references an invalid vertex index");
+        ret = false;
+    }
+    return sink.endStep() && ret;
+}
+
+
+bool
+DualMeshBuilder::writeHardGceVertices(DualMeshSink &sink)
+{
+    MemoryStats::Scope memScope(MemoryStats::Topology);
+    bool ret = sink.beginStep(numHardVerts_);
+    hardGceVertToDualVert_.clear();
+    UInt8Array1 exportFlags;
+    if (ret && !hardEdgeIndex_.classify(mesh_, cosMaxTurnAngle_,
+            exportFlags)) {
+        ret = false;
+    }
+    // capture starting dual index for any exported GCE points
+    UInt32 dualNdx = mesh_.triCount() + hardEdgeIndex_.edgeCount();
+    const UInt32Array1 &hardVerts = hardEdgeIndex_.hardVerts();
+    UInt32Array1::const_iterator it = hardVerts.begin();
+    for (; ret && (it != hardVerts.end()); ++it) {
+        const UInt32 gceVertNdx = *it;
+        const UInt32 numHardEdges = hardEdgeIndex_.degree(gceVertNdx);
+        if (numHardEdges < 2) {
+            // should never get here
+            DUAL_TRACE2(BadHardVert, gceVertNdx, numHardEdges);
+            ret = false;
+            break;
+        }
+        if (exportFlags[gceVertNdx]) {
+            Vec3 v;
+            if (!mesh_.getCoord(gceVertNdx, v)) {
+                ret = false;
+                break;
+            }
+            // add gce to dual vertex mapping
+            hardGceVertToDualVert_.insert(
+                UInt32ToUInt32Map::value_type(gceVertNdx, dualNdx));
+            DUAL_TRACE3(GceVertExport, gceVertNdx, dualNdx, numHardEdges);
+            if (!sink.writeVertex(dualNdx++, v, DualMeshSink::GceVert)) {
+                ret = false;
+                break;
+            }
+        }
+        if (!sink.incrementStep()) {
+            ret = false;
+            break;
+        }
+    }
+    return sink.endStep() && ret;
+}
+
+
+bool
+DualMeshBuilder::writePolys(DualEdgeBuilder &edges, DualMeshSink &sink)
+{
+    MemoryStats::Scope memScope(MemoryStats::Fans);
+    bool ret = sink.beginStep(mesh_.vertexCount());
+    polyClasses_.clear();
+    if (ret && !vertCells_.empty()) {
+        FanSorter sorter(hardEdgeIndex_, hardGceVertToDualVert_);
+        UInt32Array2 fans;
+        const bool needEdges = dualEdges_ || (0 != numAggLevels_);
+        UInt32Array1 polyEdges;
+        UInt32 polyNdx = 0;
+        if (0 != fanCache_) {
+            fanCache_->begin(mesh_, vertCellOffsets_, vertCells_,
+                hardEdgeIndex_, hardGceVertToDualVert_);
+        }
+        for (UInt32 gceVertNdx = 0; gceVertNdx < mesh_.vertexCount();
+                ++gceVertNdx) {
+            const UInt32 begin = vertCellOffsets_[gceVertNdx];
+            const UInt32 end = vertCellOffsets_[gceVertNdx + 1];
+            if (begin != end) {
+                MemoryStats::setCategory(MemoryStats::DualEdges);
+                edges.beginVertex(gceVertNdx);
+                // Sort cell indices in radial order around gce vertex.
+                // Multiple fans are possible if hard edges are encountered.
+                MemoryStats::setCategory(MemoryStats::Fans);
+                fans.clear();
+                if (((0 == fanCache_) ||
+                        !fanCache_->reuseFans(gceVertNdx, fans)) &&
+                        !sorter.run(mesh_, gceVertNdx, &vertCells_[begin],
+                            end - begin, fans)) {
+                    sink.errorMsg("tris around a vertex have inconsistent "
+                        "orientation or non-manifold edges");
+                    ret = false;
+                    break;
+                }
+                if (0 != fanCache_) {
+                    fanCache_->addFans(gceVertNdx, fans);
+                }
+                const bool isBndry = (0 != (vertFlags_[gceVertNdx] &
+                    TopologyValidator::HardVertFlag));
+                MemoryStats::setCategory(MemoryStats::DualEdges);
+                if (0 != numAggLevels_) {
+                    DualAgglomerator::PolyClass polyClass =
+                        DualAgglomerator::InteriorPoly;
+                    if (hardGceVertToDualVert_.end() !=
+                            hardGceVertToDualVert_.find(gceVertNdx)) {
+                        polyClass = DualAgglomerator::CornerPoly;
+                    }
+                    else if (isBndry) {
+                        polyClass = DualAgglomerator::HardPoly;
+                    }
+                    polyClasses_.insert(polyClasses_.end(), fans.size(),
+                        UInt8(polyClass));
+                }
+                UInt32Array2::const_iterator itFan = fans.begin();
+                for (; itFan != fans.end(); ++itFan) {
+                    if (!sink.writePoly(gceVertNdx, isBndry, *itFan) ||
+                            (needEdges &&
+                            !edges.addPoly(polyNdx, *itFan, polyEdges)) ||
+                            (dualEdges_ &&
+                            !sink.writePolyEdges(polyNdx, polyEdges))) {
+                        ret = false;
+                        break;
+                    }
+                    ++polyNdx;
+                }
+            }
+            if (!ret || !sink.incrementStep()) {
+                ret = false;
+                break;
+            }
+        }
+        MemoryStats::setCategory(MemoryStats::Fans);
+        if (0 != fanCache_) {
+            // a partial run can not be reused
+            if (ret) {
+                fanCache_->end();
+            }
+            else {
+                fanCache_->clear();
+            }
+        }
+        ret = ret && (!dualEdges_ || writeDualEdges(edges, sink));
+    }
+    return sink.endStep() && ret;
+}
+
+
+bool
+DualMeshBuilder::writeAggLevels(const DualEdgeBuilder &edges,
+    DualMeshSink &sink)
+{
+    if (0 == numAggLevels_) {
+        return true;
+    }
+    MemoryStats::Scope memScope(MemoryStats::DualEdges);
+    bool ret = sink.beginStep(numAggLevels_);
+    if (ret) {
+        DualAgglomerator agglomerator;
+        agglomerator.setPolys(polyClasses_, edges, mesh_.triCount());
+        UInt32Array1 fineToCoarse;
+        for (UInt32 level = 1; ret && (level <= numAggLevels_); ++level) {
+            const UInt32 numCoarse = agglomerator.coarsen(fineToCoarse);
+            ret = sink.writeAggLevel(level, numCoarse, fineToCoarse) &&
+                sink.incrementStep();
+        }
+    }
+    return sink.endStep() && ret;
+}
+
+
+bool
+DualMeshBuilder::writeDualEdges(const DualEdgeBuilder &edges,
+    DualMeshSink &sink)
+{
+    bool ret = sink.beginDualEdges(edges.edgeCount());
+    for (UInt32 ii = 0; ret && (ii < edges.edgeCount()); ++ii) {
+        ret = sink.writeDualEdge(ii, edges.edgeVerts(ii), edges.leftPoly(ii),
+            edges.rightPoly(ii));
+    }
+    return ret;
+}
+
+
+void
+DualMeshBuilder::buildVertCells(const TriMesh &mesh, UInt32Array1 &offsets,
+    UInt32Array1 &cells)
+{
+    // Counting sort of the tri vertex references into CSR form. Cells are
+    // stored in ascending order for each vertex.
+    const UInt32 numVerts = mesh.vertexCount();
+    const UInt32 numTris = mesh.triCount();
+    offsets.assign(size_t(numVerts) + 1, 0);
+    for (UInt32 cell = 0; cell < numTris; ++cell) {
+        const UInt32 *tri = mesh.tri(cell);
+        for (UInt32 ii = 0; ii < 3; ++ii) {
+            if (tri[ii] < numVerts) {
+                ++offsets[tri[ii] + 1];
+            }
+        }
+    }
+    for (UInt32 ii = 0; ii < numVerts; ++ii) {
+        offsets[ii + 1] += offsets[ii];
+    }
+    cells.resize(offsets[numVerts]);
+    UInt32Array1 fill(offsets.begin(), offsets.end() - 1);
+    for (UInt32 cell = 0; cell < numTris; ++cell) {
+        const UInt32 *tri = mesh.tri(cell);
+        for (UInt32 ii = 0; ii < 3; ++ii) {
+            if (tri[ii] < numVerts) {
+                cells[fill[tri[ii]]++] = cell;
+            }
+        }
+    }
+}
+
@@ -0,0 +1,205 @@
+/****************************************************************************
+ *
+ * class DualMeshBuilder
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALMESHBUILDER_H_
+#define _DUALMESHBUILDER_H_
+
+#include "DualEdgeBuilder.h"
+#include "DualFanCache.h"
+#include "DualMeshSink.h"
+#include "DualPlacement.h"
+#include "DualRegion.h"
+#include "HardEdgeIndex.h"
+#include "PluginTypes.h"
+#include "TriMesh.h"
+
+struct DualCell;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Builds the polygon dual of a 2D triangle mesh.
+
+    DualMeshBuilder is host-independent. It only depends on the TriMesh
+    arrays and the hard (boundary and connection) edges given to it. The
+    dual mesh is streamed to a DualMeshSink.
+
+    The dual mesh vertices are numbered as:
+      [0, NumTris)                    tri centroids
+      [NumTris, +NumBndryMids)        boundary edge mid points
+      [..., +NumCnxnMids)             connection edge mid points
+      [..., +NumGceDualVerts)         hard gce vertices that exceed the max
+                                      turning angle
+
+    If a region is set, only the region's polygons and the dual vertices
+    they use are written. Both are renumbered compactly. See runRegion().
+
+    The mesh's plane is found when it is set. A planar mesh (every z the
+    same, as for a Pointwise 2D grid) is placed and classified by the 2D
+    kernels.
+*/
+class DualMeshBuilder {
+public:
+
+    DualMeshBuilder(const TriMesh &mesh = TriMesh());
+    ~DualMeshBuilder();
+
+    void        setMesh(const TriMesh &mesh);
+    void        setMaxTurnAngle(double maxTurnAngleDeg);
+    void        setPlacement(DualPlacement::Strategy strategy);
+
+    // If true, the dual edges and their left/right polygons are written.
+    // Default is false.
+    void        setDualEdges(bool enable);
+
+    // Number of agglomeration multigrid levels to write. Default is 0.
+    void        setAggLevels(UInt32 numLevels);
+
+    // If set, the polygons of vertices that did not change since the
+    // cached run are reused and the cache is updated by run(). Default is 0.
+    void        setFanCache(DualFanCache *cache);
+
+    // If set, only the polygons of the region's vertices are written. See
+    // runRegion(). Default is 0.
+    void        setRegion(const DualRegion *region);
+
+    // Hard edges must be added in dual vertex order.
+    void        addBndryEdge(UInt32 v0, UInt32 v1, UInt32 ownerCell);
+    void        addCnxnEdge(UInt32 v0, UInt32 v1, UInt32 ownerCell,
+                    UInt32 neighborCell);
+
+    // Adds a boundary edge for every tri edge used by only one tri. Returns
+    // the number of boundary edges added.
+    UInt32      findBndryEdges();
+
+    bool        run(DualMeshSink &sink);
+
+    inline const TriMesh &
+    mesh() const
+    {
+        return mesh_;
+    }
+
+
+    inline double
+    cosMaxTurnAngle() const
+    {
+        return cosMaxTurnAngle_;
+    }
+
+
+    inline const DualPlacement &
+    placement() const
+    {
+        return placement_;
+    }
+
+
+    inline const HardMidArray1 &
+    bndryMids() const
+    {
+        return bndryMids_;
+    }
+
+
+    inline const HardMidArray1 &
+    cnxnMids() const
+    {
+        return cnxnMids_;
+    }
+
+
+    //! Builds the CSR cell lists of every vertex. The cells touching vertex
+    //! v are cells[offsets[v] .. offsets[v+1]) in ascending order.
+    static void buildVertCells(const TriMesh &mesh, UInt32Array1 &offsets,
+                    UInt32Array1 &cells);
+
+
+private:
+
+    bool        runRegion(DualMeshSink &sink);
+    bool        queryRegion(const UInt32Array1 &verts,
+                    std::vector<DualCell> &cells, DualMeshSink &sink);
+    bool        writeRegionVerts(const UInt32Array1 &verts,
+                    std::vector<DualCell> &cells, DualMeshSink &sink);
+    bool        writeRegionPolys(const UInt32Array1 &verts,
+                    const std::vector<DualCell> &cells, DualMeshSink &sink);
+
+    bool        validate(DualMeshSink &sink);
+    bool        writeGceVertices(DualMeshSink &sink);
+    bool        writeCentroids(DualMeshSink &sink);
+    bool        writeHardMids(DualMeshSink &sink);
+    bool        writeHardGceVertices(DualMeshSink &sink);
+    bool        writePolys(DualEdgeBuilder &edges, DualMeshSink &sink);
+    bool        writeDualEdges(const DualEdgeBuilder &edges,
+                    DualMeshSink &sink);
+    bool        writeAggLevels(const DualEdgeBuilder &edges,
+                    DualMeshSink &sink);
+
+
+private:
+
+    //! The primal tri mesh
+    TriMesh                 mesh_;
+
+    //! Cosine of the max hard edge turning angle
+    double                  cosMaxTurnAngle_;
+
+    //! Computes the dual vertex locations
+    DualPlacement           placement_;
+
+    //! If true, the dual edges are written
+    bool                    dualEdges_;
+
+    //! Number of agglomeration levels to write
+    UInt32                  numAggLevels_;
+
+    //! The fans of the previous run. 0 if not reusing fans.
+    DualFanCache *          fanCache_;
+
+    //! The region to write. 0 if writing the whole mesh.
+    const DualRegion *      region_;
+
+    //! The tri dual vertex xyz values. 3 per tri.
+    DoubleArray1            elemXyz_;
+
+    //! The boundary edges in dual vertex order.
+    HardMidArray1           bndryMids_;
+
+    //! The connection edges in dual vertex order.
+    HardMidArray1           cnxnMids_;
+
+    //! CSR offsets into vertCells_. The cells touching gce vertex v are
+    //! vertCells_[vertCellOffsets_[v] .. vertCellOffsets_[v+1]).
+    UInt32Array1            vertCellOffsets_;
+
+    //! CSR gce cell indices grouped by gce vertex.
+    UInt32Array1            vertCells_;
+
+    //! The hard edges of each gce vertex and their dual vertices
+    HardEdgeIndex           hardEdgeIndex_;
+
+    // Maps a hard gce vertex index to its dual index.
+    UInt32ToUInt32Map       hardGceVertToDualVert_;
+
+    //! TopologyValidator::VertFlag bits for each gce vertex
+    UInt8Array1             vertFlags_;
+
+    //! Number of boundary/connection gce vertices
+    UInt32                  numHardVerts_;
+
+    //! DualAgglomerator::PolyClass of each polygon. Only filled if
+    //! agglomeration levels are written.
+    UInt8Array1             polyClasses_;
+};
+
+#endif // _DUALMESHBUILDER_H_
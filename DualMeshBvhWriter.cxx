@@ -0,0 +1,230 @@
+/****************************************************************************
+ *
+ * class DualMeshBvhWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "DualMeshBvhWriter.h"
+#include "DualPolyBvh.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+namespace {
+
+//! The largest float <= v
+inline float
+floatDown(double v)
+{
+    const float f = float(v);
+    return (double(f) > v) ?
+        std::nextafter(f, -std::numeric_limits<float>::max()) : f;
+}
+
+
+//! The smallest float >= v
+inline float
+floatUp(double v)
+{
+    const float f = float(v);
+    return (double(f) < v) ?
+        std::nextafter(f, std::numeric_limits<float>::max()) : f;
+}
+
+} // namespace
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualMeshBvhWriter::DualMeshBvhWriter(DualMeshSink &target) :
+    target_(target),
+    fileName_(),
+    vertXyz_(),
+    polyBoxes_()
+{
+}
+
+
+DualMeshBvhWriter::~DualMeshBvhWriter()
+{
+}
+
+
+void
+DualMeshBvhWriter::setFileName(const std::string &fileName)
+{
+    fileName_ = fileName;
+    vertXyz_.clear();
+    polyBoxes_.clear();
+}
+
+
+bool
+DualMeshBvhWriter::writeGceVertex(UInt32 gceVertNdx, const Vec3 &v)
+{
+    return target_.writeGceVertex(gceVertNdx, v);
+}
+
+
+bool
+DualMeshBvhWriter::beginCentroids(UInt32 count)
+{
+    return target_.beginCentroids(count);
+}
+
+
+bool
+DualMeshBvhWriter::beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids)
+{
+    return target_.beginHardMids(numBndryMids, numCnxnMids);
+}
+
+
+bool
+DualMeshBvhWriter::writeVertex(UInt32 dualNdx, const Vec3 &v,
+    VertType vType)
+{
+    if (!fileName_.empty()) {
+        if (vertXyz_.size() <= 3 * size_t(dualNdx)) {
+            vertXyz_.resize(3 * (size_t(dualNdx) + 1));
+        }
+        double *p = &vertXyz_[3 * size_t(dualNdx)];
+        p[0] = v[0];
+        p[1] = v[1];
+        p[2] = v[2];
+    }
+    return target_.writeVertex(dualNdx, v, vType);
+}
+
+
+bool
+DualMeshBvhWriter::writePoly(UInt32 gceVertNdx, bool isBndry,
+    const UInt32Array1 &dualVerts)
+{
+    if (!fileName_.empty() && !dualVerts.empty()) {
+        double box[6];
+        for (size_t ii = 0; ii < dualVerts.size(); ++ii) {
+            if (vertXyz_.size() <= 3 * size_t(dualVerts[ii])) {
+                target_.errorMsg("polygon references an unknown dual vertex");
+                return false;
+            }
+            const double *p = &vertXyz_[3 * size_t(dualVerts[ii])];
+            for (int jj = 0; jj < 3; ++jj) {
+                box[jj] = (0 == ii) ? p[jj] : std::min(box[jj], p[jj]);
+                box[jj + 3] = (0 == ii) ? p[jj] : std::max(box[jj + 3], p[jj]);
+            }
+        }
+        for (int jj = 0; jj < 3; ++jj) {
+            polyBoxes_.push_back(floatDown(box[jj]));
+        }
+        for (int jj = 3; jj < 6; ++jj) {
+            polyBoxes_.push_back(floatUp(box[jj]));
+        }
+    }
+    return target_.writePoly(gceVertNdx, isBndry, dualVerts);
+}
+
+
+bool
+DualMeshBvhWriter::writePolyEdges(UInt32 polyNdx,
+    const UInt32Array1 &dualEdges)
+{
+    return target_.writePolyEdges(polyNdx, dualEdges);
+}
+
+
+bool
+DualMeshBvhWriter::beginDualEdges(UInt32 count)
+{
+    return target_.beginDualEdges(count);
+}
+
+
+bool
+DualMeshBvhWriter::writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+    UInt32 leftPoly, UInt32 rightPoly)
+{
+    return target_.writeDualEdge(edgeNdx, dualVerts, leftPoly, rightPoly);
+}
+
+
+bool
+DualMeshBvhWriter::writeAggLevel(UInt32 level, UInt32 numCoarse,
+    const UInt32Array1 &fineToCoarse)
+{
+    return target_.writeAggLevel(level, numCoarse, fineToCoarse);
+}
+
+
+bool
+DualMeshBvhWriter::endMesh()
+{
+    bool ret = target_.endMesh();
+    if (ret && !fileName_.empty()) {
+        // the vertices are not needed by the tree
+        DoubleArray1().swap(vertXyz_);
+        DualPolyBvh bvh;
+        bvh.build(polyBoxes_.empty() ? 0 : &polyBoxes_[0],
+            UInt32(polyBoxes_.size() / 6));
+        FloatArray1().swap(polyBoxes_);
+        if (!bvh.save(fileName_.c_str())) {
+            target_.errorMsg("polygon BVH file write failed");
+            ret = false;
+        }
+    }
+    return ret;
+}
+
+
+bool
+DualMeshBvhWriter::beginStep(UInt32 total)
+{
+    return target_.beginStep(total);
+}
+
+
+bool
+DualMeshBvhWriter::incrementStep()
+{
+    return target_.incrementStep();
+}
+
+
+bool
+DualMeshBvhWriter::endStep()
+{
+    return target_.endStep();
+}
+
+
+void
+DualMeshBvhWriter::errorMsg(const char *msg)
+{
+    target_.errorMsg(msg);
+}
+
+
+void
+DualMeshBvhWriter::warningMsg(const char *msg)
+{
+    target_.warningMsg(msg);
+}
+
+
+void
+DualMeshBvhWriter::infoMsg(const char *msg)
+{
+    target_.infoMsg(msg);
+}
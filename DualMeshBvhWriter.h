@@ -0,0 +1,76 @@
+/****************************************************************************
+ *
+ * class DualMeshBvhWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALMESHBVHWRITER_H_
+#define _DUALMESHBVHWRITER_H_
+
+#include <string>
+
+#include "DualMeshSink.h"
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! DualMeshSink that forwards everything to a target sink and writes a
+    DualPolyBvh over the polygons to a file.
+
+    The dual vertex xyz values and the bounding box of each polygon are
+    kept while the mesh streams through. The tree is built and saved by
+    endMesh(). Polygon indices are in write order, so they match the
+    polygon numbering of the target's output. If no file name is set, the
+    writer only forwards.
+*/
+class DualMeshBvhWriter : public DualMeshSink {
+public:
+
+    DualMeshBvhWriter(DualMeshSink &target);
+    virtual ~DualMeshBvhWriter();
+
+    //! Sets the BVH file name. Empty disables the BVH.
+    void            setFileName(const std::string &fileName);
+
+    virtual bool    writeGceVertex(UInt32 gceVertNdx, const Vec3 &v);
+    virtual bool    beginCentroids(UInt32 count);
+    virtual bool    beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids);
+    virtual bool    writeVertex(UInt32 dualNdx, const Vec3 &v,
+                        VertType vType);
+    virtual bool    writePoly(UInt32 gceVertNdx, bool isBndry,
+                        const UInt32Array1 &dualVerts);
+    virtual bool    writePolyEdges(UInt32 polyNdx,
+                        const UInt32Array1 &dualEdges);
+    virtual bool    beginDualEdges(UInt32 count);
+    virtual bool    writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+                        UInt32 leftPoly, UInt32 rightPoly);
+    virtual bool    writeAggLevel(UInt32 level, UInt32 numCoarse,
+                        const UInt32Array1 &fineToCoarse);
+    virtual bool    endMesh();
+    virtual bool    beginStep(UInt32 total);
+    virtual bool    incrementStep();
+    virtual bool    endStep();
+    virtual void    errorMsg(const char *msg);
+    virtual void    warningMsg(const char *msg);
+    virtual void    infoMsg(const char *msg);
+
+private:
+
+    DualMeshSink &  target_;
+    std::string     fileName_;
+
+    //! The dual vertex xyz values. 3 per vertex.
+    DoubleArray1    vertXyz_;
+
+    //! The polygon boxes (min xyz, max xyz), rounded outward to float
+    FloatArray1     polyBoxes_;
+};
+
+#endif // _DUALMESHBVHWRITER_H_
@@ -0,0 +1,386 @@
+/****************************************************************************
+ *
+ * class DualMeshChunkWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+
+#include "DualMeshChunkWriter.h"
+
+static const char   FileMagic[] = "DUALMSH1";
+static const char   IndexMagic[] = "DUALIDX1";
+static const UInt32 FileVersion = 1;
+
+// Chunk payload arrays start on 8 byte boundaries
+static const size_t Align = 8;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+//! The chunk header. Also the fixed part of an index entry.
+struct ChunkHeader {
+    UInt32  kind_;
+    UInt32  aux_;       // AggLevelChunk level, otherwise 0
+    UInt32  flags_;
+    UInt32  first_;     // index of the first record
+    UInt32  count_;     // number of records
+    UInt32  numBytes_;  // payload size
+};
+
+struct DualMeshChunkWriter::IndexEntry {
+    unsigned long long  offset_;    // file offset of the chunk header
+    ChunkHeader         header_;
+    double              box_[6];    // xmin ymin zmin xmax ymax zmax
+};
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualMeshChunkWriter::DualMeshChunkWriter(std::FILE *fp, UInt32 chunkSize) :
+    fp_(fp),
+    chunkSize_((0 == chunkSize) ? 1 : chunkSize),
+    headerDone_(false),
+    offset_(0),
+    dualXyz_(),
+    kind_(GceVertChunk),
+    aux_(0),
+    flags_(0),
+    first_(0),
+    count_(0),
+    xyz_(),
+    bytes_(),
+    ints_(),
+    offsets_(),
+    verts_(),
+    edges_(),
+    index_()
+{
+    memset(next_, 0, sizeof(next_));
+}
+
+
+DualMeshChunkWriter::~DualMeshChunkWriter()
+{
+}
+
+
+bool
+DualMeshChunkWriter::writeGceVertex(UInt32 gceVertNdx, const Vec3 &v)
+{
+    (void)gceVertNdx;
+    if (!beginRecord(GceVertChunk)) {
+        return false;
+    }
+    const double xyz[3] = { v[0], v[1], v[2] };
+    xyz_.insert(xyz_.end(), xyz, xyz + 3);
+    addToBox(xyz);
+    return true;
+}
+
+
+bool
+DualMeshChunkWriter::beginCentroids(UInt32 count)
+{
+    dualXyz_.reserve(3 * size_t(count));
+    return true;
+}
+
+
+bool
+DualMeshChunkWriter::beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids)
+{
+    dualXyz_.reserve(dualXyz_.size() +
+        3 * (size_t(numBndryMids) + numCnxnMids));
+    return true;
+}
+
+
+bool
+DualMeshChunkWriter::writeVertex(UInt32 dualNdx, const Vec3 &v,
+    VertType vType)
+{
+    if ((3 * size_t(dualNdx) != dualXyz_.size()) ||
+            !beginRecord(DualVertChunk)) {
+        return false;
+    }
+    const double xyz[3] = { v[0], v[1], v[2] };
+    dualXyz_.insert(dualXyz_.end(), xyz, xyz + 3);
+    xyz_.insert(xyz_.end(), xyz, xyz + 3);
+    bytes_.push_back(UInt8(vType));
+    addToBox(xyz);
+    return true;
+}
+
+
+bool
+DualMeshChunkWriter::writePoly(UInt32 gceVertNdx, bool isBndry,
+    const UInt32Array1 &dualVerts)
+{
+    if (!beginRecord(PolyChunk)) {
+        return false;
+    }
+    if (offsets_.empty()) {
+        offsets_.push_back(0);
+    }
+    ints_.push_back(gceVertNdx);
+    bytes_.push_back(isBndry ? 1 : 0);
+    verts_.insert(verts_.end(), dualVerts.begin(), dualVerts.end());
+    offsets_.push_back(UInt32(verts_.size()));
+    UInt32Array1::const_iterator it = dualVerts.begin();
+    for (; it != dualVerts.end(); ++it) {
+        if (3 * size_t(*it) >= dualXyz_.size()) {
+            return false;
+        }
+        addToBox(&dualXyz_[3 * size_t(*it)]);
+    }
+    return true;
+}
+
+
+bool
+DualMeshChunkWriter::writePolyEdges(UInt32 polyNdx,
+    const UInt32Array1 &dualEdges)
+{
+    // always follows the writePoly() call of the same polygon
+    (void)polyNdx;
+    flags_ |= HasPolyEdges;
+    edges_.insert(edges_.end(), dualEdges.begin(), dualEdges.end());
+    return true;
+}
+
+
+bool
+DualMeshChunkWriter::writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+    UInt32 leftPoly, UInt32 rightPoly)
+{
+    (void)edgeNdx;
+    if (!beginRecord(DualEdgeChunk) ||
+            (3 * size_t(dualVerts[0]) >= dualXyz_.size()) ||
+            (3 * size_t(dualVerts[1]) >= dualXyz_.size())) {
+        return false;
+    }
+    verts_.push_back(dualVerts[0]);
+    verts_.push_back(dualVerts[1]);
+    ints_.push_back(leftPoly);
+    ints_.push_back(rightPoly);
+    addToBox(&dualXyz_[3 * size_t(dualVerts[0])]);
+    addToBox(&dualXyz_[3 * size_t(dualVerts[1])]);
+    return true;
+}
+
+
+bool
+DualMeshChunkWriter::writeAggLevel(UInt32 level, UInt32 numCoarse,
+    const UInt32Array1 &fineToCoarse)
+{
+    (void)numCoarse;
+    // each level is numbered from 0
+    bool ret = flushChunk();
+    next_[AggLevelChunk] = 0;
+    UInt32Array1::const_iterator it = fineToCoarse.begin();
+    for (; ret && (it != fineToCoarse.end()); ++it) {
+        ret = beginRecord(AggLevelChunk, level);
+        ints_.push_back(*it);
+    }
+    return ret;
+}
+
+
+bool
+DualMeshChunkWriter::endMesh()
+{
+    // An empty mesh is a header with no chunks
+    bool ret = flushChunk() && (headerDone_ || writeHeader());
+    const unsigned long long indexOffset = offset_;
+    if (ret && !index_.empty()) {
+        ret = (index_.size() == fwrite(&index_[0], sizeof(IndexEntry),
+            index_.size(), fp_));
+    }
+    const UInt32 footer[2] = { UInt32(index_.size()), 0 };
+    return ret &&
+        (1 == fwrite(&indexOffset, sizeof(indexOffset), 1, fp_)) &&
+        (1 == fwrite(footer, sizeof(footer), 1, fp_)) &&
+        (1 == fwrite(IndexMagic, sizeof(IndexMagic) - 1, 1, fp_));
+}
+
+
+bool
+DualMeshChunkWriter::beginRecord(ChunkKind kind, UInt32 aux)
+{
+    if (!headerDone_) {
+        if (!writeHeader()) {
+            return false;
+        }
+    }
+    else if ((kind != kind_) || (aux != aux_) || (count_ == chunkSize_)) {
+        if (!flushChunk()) {
+            return false;
+        }
+    }
+    if (0 == count_) {
+        kind_ = kind;
+        aux_ = aux;
+        flags_ = 0;
+        first_ = next_[kind];
+        box_[0] = box_[1] = box_[2] = DBL_MAX;
+        box_[3] = box_[4] = box_[5] = -DBL_MAX;
+    }
+    ++count_;
+    ++next_[kind];
+    return true;
+}
+
+
+bool
+DualMeshChunkWriter::writeHeader()
+{
+    const UInt32 header[2] = { FileVersion, chunkSize_ };
+    headerDone_ = true;
+    offset_ = sizeof(FileMagic) - 1 + sizeof(header);
+    count_ = 0;
+    return (1 == fwrite(FileMagic, sizeof(FileMagic) - 1, 1, fp_)) &&
+        (1 == fwrite(header, sizeof(header), 1, fp_));
+}
+
+
+bool
+DualMeshChunkWriter::flushChunk()
+{
+    if (0 == count_) {
+        return true;
+    }
+    IndexEntry entry;
+    entry.offset_ = offset_;
+    entry.header_.kind_ = kind_;
+    entry.header_.aux_ = aux_;
+    entry.header_.flags_ = flags_;
+    entry.header_.first_ = first_;
+    entry.header_.count_ = count_;
+    entry.header_.numBytes_ = 0;
+    const bool hasBox = (box_[0] <= box_[3]);
+    for (int ii = 0; ii < 6; ++ii) {
+        entry.box_[ii] = hasBox ? box_[ii] : 0.0;
+    }
+
+    // Payload arrays in ChunkKind order. Empty arrays write nothing.
+    const void *arrays[5] = { 0, 0, 0, 0, 0 };
+    size_t sizes[5] = { 0, 0, 0, 0, 0 };
+    switch (kind_) {
+    case GceVertChunk:
+        arrays[0] = xyz_.empty() ? 0 : &xyz_[0];
+        sizes[0] = xyz_.size() * sizeof(double);
+        break;
+    case DualVertChunk:
+        arrays[0] = xyz_.empty() ? 0 : &xyz_[0];
+        sizes[0] = xyz_.size() * sizeof(double);
+        arrays[1] = bytes_.empty() ? 0 : &bytes_[0];
+        sizes[1] = bytes_.size();
+        break;
+    case PolyChunk:
+        arrays[0] = ints_.empty() ? 0 : &ints_[0];
+        sizes[0] = ints_.size() * sizeof(UInt32);
+        arrays[1] = bytes_.empty() ? 0 : &bytes_[0];
+        sizes[1] = bytes_.size();
+        arrays[2] = offsets_.empty() ? 0 : &offsets_[0];
+        sizes[2] = offsets_.size() * sizeof(UInt32);
+        arrays[3] = verts_.empty() ? 0 : &verts_[0];
+        sizes[3] = verts_.size() * sizeof(UInt32);
+        arrays[4] = edges_.empty() ? 0 : &edges_[0];
+        sizes[4] = edges_.size() * sizeof(UInt32);
+        break;
+    case DualEdgeChunk:
+        arrays[0] = verts_.empty() ? 0 : &verts_[0];
+        sizes[0] = verts_.size() * sizeof(UInt32);
+        arrays[1] = ints_.empty() ? 0 : &ints_[0];
+        sizes[1] = ints_.size() * sizeof(UInt32);
+        break;
+    case AggLevelChunk:
+        arrays[0] = ints_.empty() ? 0 : &ints_[0];
+        sizes[0] = ints_.size() * sizeof(UInt32);
+        break;
+    }
+    size_t numBytes = 0;
+    for (int ii = 0; ii < 5; ++ii) {
+        numBytes += (sizes[ii] + Align - 1) / Align * Align;
+    }
+    entry.header_.numBytes_ = UInt32(numBytes);
+    bool ret = (1 == fwrite(&entry.header_, sizeof(ChunkHeader), 1, fp_));
+    offset_ += sizeof(ChunkHeader);
+    for (int ii = 0; ret && (ii < 5); ++ii) {
+        ret = writeArray(arrays[ii], sizes[ii]);
+    }
+    index_.push_back(entry);
+
+    count_ = 0;
+    xyz_.clear();
+    bytes_.clear();
+    ints_.clear();
+    offsets_.clear();
+    verts_.clear();
+    edges_.clear();
+    return ret;
+}
+
+
+bool
+DualMeshChunkWriter::writeArray(const void *data, size_t numBytes)
+{
+    static const char zeros[Align] = { 0 };
+    const size_t pad = (Align - numBytes % Align) % Align;
+    offset_ += numBytes + pad;
+    return ((0 == numBytes) || (1 == fwrite(data, numBytes, 1, fp_))) &&
+        ((0 == pad) || (1 == fwrite(zeros, pad, 1, fp_)));
+}
+
+
+void
+DualMeshChunkWriter::addToBox(const double *xyz)
+{
+    for (int ii = 0; ii < 3; ++ii) {
+        if (xyz[ii] < box_[ii]) {
+            box_[ii] = xyz[ii];
+        }
+        if (xyz[ii] > box_[ii + 3]) {
+            box_[ii + 3] = xyz[ii];
+        }
+    }
+}
+
+
+void
+DualMeshChunkWriter::errorMsg(const char *msg)
+{
+    fprintf(stderr, "error: %s\n", msg);
+}
+
+
+void
+DualMeshChunkWriter::warningMsg(const char *msg)
+{
+    fprintf(stderr, "warning: %s\n", msg);
+}
+
+
+bool
+DualMeshChunkWriter::isChunkFileName(const char *filename)
+{
+    return hasFileExt(filename, ".dmc");
+}
+
+
+const char *
+DualMeshChunkWriter::fileMagic()
+{
+    return FileMagic;
+}
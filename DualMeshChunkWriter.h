@@ -0,0 +1,120 @@
+/****************************************************************************
+ *
+ * class DualMeshChunkWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALMESHCHUNKWRITER_H_
+#define _DUALMESHCHUNKWRITER_H_
+
+#include <cstdio>
+
+#include "DualMeshSink.h"
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Writes the dual mesh as a chunked, seekable binary container (.dmc) to
+    a stdio FILE opened in binary mode.
+
+    The records are grouped into chunks of at most chunkSize records. Every
+    chunk holds a single record kind and can be decoded on its own. A chunk
+    is written as soon as it is full, so only the current chunk and the dual
+    vertex xyz values (for the polygon bounding boxes) are kept in memory.
+    All values are in native byte order. See README.md for the layout.
+*/
+class DualMeshChunkWriter : public DualMeshSink {
+public:
+
+    enum ChunkKind {
+        GceVertChunk = 1,   //!< double xyz[3n]
+        DualVertChunk,      //!< double xyz[3n], UInt8 vertType[n]
+        PolyChunk,          //!< UInt32 gceVert[n], UInt8 isBndry[n],
+                            //!< UInt32 offsets[n+1], UInt32 verts[],
+                            //!< UInt32 edges[] if HasPolyEdges
+        DualEdgeChunk,      //!< UInt32 verts[2n], UInt32 polys[2n]
+        AggLevelChunk       //!< UInt32 fineToCoarse[n]
+    };
+
+    enum ChunkFlag {
+        HasPolyEdges = 0x01 //!< a PolyChunk has the polygon edge indices
+    };
+
+    DualMeshChunkWriter(std::FILE *fp, UInt32 chunkSize = 16384);
+    virtual ~DualMeshChunkWriter();
+
+    virtual bool    writeGceVertex(UInt32 gceVertNdx, const Vec3 &v);
+    virtual bool    beginCentroids(UInt32 count);
+    virtual bool    beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids);
+    virtual bool    writeVertex(UInt32 dualNdx, const Vec3 &v,
+                        VertType vType);
+    virtual bool    writePoly(UInt32 gceVertNdx, bool isBndry,
+                        const UInt32Array1 &dualVerts);
+    virtual bool    writePolyEdges(UInt32 polyNdx,
+                        const UInt32Array1 &dualEdges);
+    virtual bool    writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+                        UInt32 leftPoly, UInt32 rightPoly);
+    virtual bool    writeAggLevel(UInt32 level, UInt32 numCoarse,
+                        const UInt32Array1 &fineToCoarse);
+    virtual bool    endMesh();
+
+    virtual void    errorMsg(const char *msg);
+    virtual void    warningMsg(const char *msg);
+
+    //! Returns true if filename ends with ".dmc" (case insensitive)
+    static bool     isChunkFileName(const char *filename);
+
+    static const char * fileMagic();
+
+private:
+
+    struct IndexEntry;
+    typedef std::vector<IndexEntry>     IndexEntryArray1;
+
+    //! Writes the file magic, version and chunk size
+    bool    writeHeader();
+    bool    beginRecord(ChunkKind kind, UInt32 aux = 0);
+    bool    flushChunk();
+    bool    writeArray(const void *data, size_t numBytes);
+    void    addToBox(const double *xyz);
+
+private:
+
+    std::FILE *         fp_;
+    UInt32              chunkSize_;
+    bool                headerDone_;
+
+    //! Bytes written so far
+    unsigned long long  offset_;
+
+    //! The dual vertex xyz values. 3 per vertex.
+    DoubleArray1        dualXyz_;
+
+    //! The current chunk
+    ChunkKind           kind_;
+    UInt32              aux_;
+    UInt32              flags_;
+    UInt32              first_;
+    UInt32              count_;
+    double              box_[6];
+    DoubleArray1        xyz_;
+    UInt8Array1         bytes_;
+    UInt32Array1        ints_;
+    UInt32Array1        offsets_;
+    UInt32Array1        verts_;
+    UInt32Array1        edges_;
+
+    //! The next record index of each ChunkKind
+    UInt32              next_[AggLevelChunk + 1];
+
+    IndexEntryArray1    index_;
+};
+
+#endif // _DUALMESHCHUNKWRITER_H_
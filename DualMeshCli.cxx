@@ -0,0 +1,372 @@
+/****************************************************************************
+ *
+ * dualmesh command line tool
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "DualCostEstimator.h"
+#include "DualFanCache.h"
+#include "DualMeshBuilder.h"
+#include "DualMeshBvhWriter.h"
+#include "DualMeshTclWriter.h"
+#include "DualMeshChunkWriter.h"
+#include "DualMeshMemoryMonitor.h"
+#include "DualMeshMirror.h"
+#include "DualMeshPartWriter.h"
+#include "DualMeshShmWriter.h"
+#include "DualMeshVtuWriter.h"
+#include "DualPlacement.h"
+#include "DualRegion.h"
+#include "DualTrace.h"
+#include "DualVariant.h"
+#include "TriMeshFile.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+//! Prints the memory reports. The file writers ignore info messages.
+class CliMemoryMonitor : public DualMeshMemoryMonitor {
+public:
+
+    CliMemoryMonitor(DualMeshSink &target) :
+        DualMeshMemoryMonitor(target)
+    {
+    }
+
+protected:
+
+    virtual void
+    reportMsg(const char *msg)
+    {
+        fprintf(stderr, "%s\n", msg);
+    }
+};
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+//! Writes the dual mesh of builder to outName in the format of its extension
+//! or to the shared memory segment of a "shm:<name>" outName. If symNormal
+//! is set, the dual mesh is mirrored across the symmetry plane
+//! dot(*symNormal, x) = symOffset.
+static bool
+runToFile(DualMeshBuilder &builder, const char *outName, UInt32 numParts,
+    bool singlePrecision, const char *bvhName, bool memReport,
+    double memBudget, const Vec3 *symNormal, double symOffset)
+{
+    std::string shmName;
+    const bool isShm = DualMeshShmWriter::isShmName(outName, shmName);
+    const bool isParts = !isShm && (1 < numParts);
+    const bool isVtu = !isShm && !isParts &&
+        DualMeshVtuWriter::isVtuFileName(outName);
+    const bool isChunk = !isShm && !isParts &&
+        DualMeshChunkWriter::isChunkFileName(outName);
+    std::FILE *out = 0;
+    if (!isShm) {
+        out = fopen(outName, (isVtu || isChunk) ? "wb" : "w");
+        if (0 == out) {
+            fprintf(stderr, "error: %s: could not open for write\n", outName);
+            return false;
+        }
+    }
+
+    DualMeshTclWriter tclWriter(out, singlePrecision);
+    DualMeshVtuWriter vtuWriter(out, singlePrecision);
+    DualMeshChunkWriter chunkWriter(out);
+    DualMeshPartWriter partWriter(out, outName, numParts);
+    DualMeshShmWriter shmWriter(shmName.c_str());
+    DualMeshSink *writer = &tclWriter;
+    if (isShm) {
+        writer = &shmWriter;
+    }
+    else if (isParts) {
+        writer = &partWriter;
+    }
+    else if (isVtu) {
+        writer = &vtuWriter;
+    }
+    else if (isChunk) {
+        writer = &chunkWriter;
+    }
+    DualMeshBvhWriter bvhWriter(*writer);
+    if (0 != bvhName) {
+        bvhWriter.setFileName(bvhName);
+    }
+    DualMeshMirror mirror(bvhWriter);
+    if (0 != symNormal) {
+        mirror.setPlane(*symNormal, symOffset);
+        mirror.setCosMaxTurnAngle(builder.cosMaxTurnAngle());
+    }
+    CliMemoryMonitor monitor(mirror);
+    monitor.setReport(memReport);
+    monitor.setBudget((memBudget > 0.0) ?
+        size_t(memBudget * 1024.0 * 1024.0) : 0);
+    monitor.begin();
+
+    bool ok = builder.run(monitor);
+    ok = ((0 == out) || (0 == fclose(out))) && ok;
+    if (!ok) {
+        fprintf(stderr, "error: %s: dual mesh export failed\n", outName);
+    }
+    return ok;
+}
+
+
+//! Prints the predicted cost of writing the dual mesh of builder to outName
+static void
+printEstimate(const DualMeshBuilder &builder, const char *outName,
+    UInt32 numParts, bool singlePrecision, bool dualEdges, UInt32 aggLevels,
+    bool fanCache, UInt32 numVariants)
+{
+    std::string shmName;
+    DualCostEstimator::Format format = DualCostEstimator::TclFormat;
+    if (DualMeshShmWriter::isShmName(outName, shmName)) {
+        format = DualCostEstimator::ShmFormat;
+    }
+    else if (1 < numParts) {
+        format = DualCostEstimator::PartFormat;
+    }
+    else if (DualMeshVtuWriter::isVtuFileName(outName)) {
+        format = DualCostEstimator::VtuFormat;
+    }
+    else if (DualMeshChunkWriter::isChunkFileName(outName)) {
+        format = DualCostEstimator::ChunkFormat;
+    }
+    const TriMesh &mesh = builder.mesh();
+    DualCostEstimator estimator;
+    estimator.setMeshCounts(mesh.vertexCount(), mesh.triCount());
+    estimator.setHardEdgeCounts(UInt32(builder.bndryMids().size()),
+        UInt32(builder.cnxnMids().size()));
+    estimator.setSinglePrecision(singlePrecision);
+    estimator.setDualEdges(dualEdges);
+    estimator.setAggLevels(aggLevels);
+    estimator.setFanCache(fanCache);
+    estimator.setVariantCount(numVariants);
+    estimator.beginValences();
+    for (UInt32 ii = 0; ii < mesh.triCount(); ++ii) {
+        estimator.addTri(mesh.tri(ii));
+    }
+    estimator.endValences();
+    std::vector<std::string> lines;
+    estimator.report(format, lines);
+    for (size_t ii = 0; ii < lines.size(); ++ii) {
+        printf("%s\n", lines[ii].c_str());
+    }
+}
+
+
+static void
+usage(const char *exe)
+{
+    fprintf(stderr,
+        "usage: %s [options] in.tri out.glf|out.vtu|out.dmc|shm:name\n"
+        "  -a deg     hard edge max turning angle (default 30)\n"
+        "  -p name    dual vertex placement %s (default Centroid)\n"
+        "  -t file    write a debug trace file\n"
+        "  -c file    reuse the sorted fans saved in the topology cache file\n"
+        "             if it matches the mesh and save them to it\n"
+        "  -s         write single precision coordinates\n"
+        "  -e         write the dual edges and their left/right polygons\n"
+        "  -m levels  write agglomeration multigrid levels\n"
+        "  -B file    write a bounding volume hierarchy of the polygons\n"
+        "  -V list    also write out.v<k> for each ';' separated set of\n"
+        "             turning angle and/or placement name\n"
+        "  -k parts   split the polygons into parts .dmp files. out lists them.\n"
+        "  -r         report the memory use of each step\n"
+        "  -M mb      warn if the projected peak memory exceeds mb MB\n"
+        "  -n         only print the estimated run time, peak memory and\n"
+        "             output size. Nothing is written.\n"
+        "  -b box     only write the polygons of the vertices in the box\n"
+        "             \"xmin ymin zmin xmax ymax zmax\"\n"
+        "  -l layers  only write the polygons of layers vertex layers from\n"
+        "             the boundary edges\n"
+        "  -S plane   in.tri is a half model. Also write its mirror image\n"
+        "             across the symmetry plane \"a b c d\" (a*x + b*y + c*z\n"
+        "             = d) and merge the polygons on the plane.\n"
+        "A .vtu output file is written as a VTK XML unstructured grid.\n"
+        "A .dmc output file is written as a chunked binary container.\n"
+        "shm:name publishes the dual in the POSIX shared memory segment\n"
+        "name for the dualshm tool or another consumer.\n", exe,
+        DualPlacement::enumNames());
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    double maxTurnAngle = 30.0;
+    const char *traceName = 0;
+    const char *cacheName = 0;
+    const char *bvhName = 0;
+    const char *variantList = 0;
+    bool singlePrecision = false;
+    bool dualEdges = false;
+    unsigned int aggLevels = 0;
+    unsigned int numParts = 1;
+    bool memReport = false;
+    double memBudget = 0.0;
+    bool estimate = false;
+    DualRegion region;
+    Vec3 boxLo;
+    Vec3 boxHi;
+    bool isMirrored = false;
+    Vec3 symNormal;
+    double symOffset = 0.0;
+    DualPlacement::Strategy placement = DualPlacement::Centroid;
+    int ii = 1;
+    for (; (ii < argc) && ('-' == argv[ii][0]); ++ii) {
+        if ((0 == strcmp(argv[ii], "-a")) && (ii + 1 < argc)) {
+            maxTurnAngle = atof(argv[++ii]);
+        }
+        else if ((0 == strcmp(argv[ii], "-m")) && (ii + 1 < argc)) {
+            aggLevels = (unsigned int)atoi(argv[++ii]);
+        }
+        else if ((0 == strcmp(argv[ii], "-k")) && (ii + 1 < argc)) {
+            numParts = (unsigned int)atoi(argv[++ii]);
+        }
+        else if ((0 == strcmp(argv[ii], "-M")) && (ii + 1 < argc)) {
+            memBudget = atof(argv[++ii]);
+        }
+        else if ((0 == strcmp(argv[ii], "-b")) && (ii + 1 < argc) &&
+                DualRegion::parseBox(argv[ii + 1], boxLo, boxHi)) {
+            region.setBox(boxLo, boxHi);
+            ++ii;
+        }
+        else if ((0 == strcmp(argv[ii], "-S")) && (ii + 1 < argc) &&
+                DualMeshMirror::parsePlane(argv[ii + 1], symNormal,
+                    symOffset)) {
+            isMirrored = true;
+            ++ii;
+        }
+        else if ((0 == strcmp(argv[ii], "-l")) && (ii + 1 < argc)) {
+            region.setHardBand((unsigned int)atoi(argv[++ii]));
+        }
+        else if ((0 == strcmp(argv[ii], "-t")) && (ii + 1 < argc)) {
+            traceName = argv[++ii];
+        }
+        else if ((0 == strcmp(argv[ii], "-V")) && (ii + 1 < argc)) {
+            variantList = argv[++ii];
+        }
+        else if ((0 == strcmp(argv[ii], "-B")) && (ii + 1 < argc)) {
+            bvhName = argv[++ii];
+        }
+        else if ((0 == strcmp(argv[ii], "-c")) && (ii + 1 < argc)) {
+            cacheName = argv[++ii];
+        }
+        else if ((0 == strcmp(argv[ii], "-p")) && (ii + 1 < argc) &&
+                DualPlacement::fromName(argv[ii + 1], placement)) {
+            ++ii;
+        }
+        else if (0 == strcmp(argv[ii], "-s")) {
+            singlePrecision = true;
+        }
+        else if (0 == strcmp(argv[ii], "-e")) {
+            dualEdges = true;
+        }
+        else if (0 == strcmp(argv[ii], "-r")) {
+            memReport = true;
+        }
+        else if (0 == strcmp(argv[ii], "-n")) {
+            estimate = true;
+        }
+        else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (ii + 2 != argc) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char *inName = argv[ii];
+    const char *outName = argv[ii + 1];
+    DualVariant::Array1 variants;
+    std::string badToken;
+    if (!DualVariant::parseList(variantList,
+            DualVariant(maxTurnAngle, placement), variants, badToken)) {
+        fprintf(stderr, "error: -V: invalid option %s\n", badToken.c_str());
+        return EXIT_FAILURE;
+    }
+    if (isMirrored && (dualEdges || (0 < aggLevels))) {
+        fprintf(stderr, "warning: -S: dual edges and agglomeration levels "
+            "can not be mirrored. They are not written.\n");
+        dualEdges = false;
+        aggLevels = 0;
+    }
+
+    TriMeshFile in;
+    if (!in.open(inName)) {
+        fprintf(stderr, "error: %s: %s\n", inName, in.errorMsg());
+        return EXIT_FAILURE;
+    }
+    DualTrace::enable(0 != traceName);
+
+    DualMeshBuilder builder(in.mesh());
+    builder.setMaxTurnAngle(maxTurnAngle);
+    builder.setPlacement(placement);
+    builder.setDualEdges(dualEdges);
+    builder.setAggLevels(aggLevels);
+    builder.findBndryEdges();
+    builder.setRegion(region.isSet() ? &region : 0);
+    if (estimate) {
+        printEstimate(builder, outName, numParts, singlePrecision, dualEdges,
+            aggLevels, 0 != cacheName, UInt32(variants.size()));
+        return EXIT_SUCCESS;
+    }
+    DualFanCache fanCache;
+    unsigned long long cacheKey = 0;
+    if ((0 != cacheName) && !region.isSet()) {
+        cacheKey = DualFanCache::topologyKey(builder.mesh(),
+            builder.bndryMids(), builder.cnxnMids(),
+            builder.cosMaxTurnAngle());
+        fanCache.load(cacheName, cacheKey);
+    }
+    if ((0 != cacheName) || !variants.empty()) {
+        // the variants reuse the fans of the previous run
+        builder.setFanCache(&fanCache);
+    }
+    bool ok = runToFile(builder, outName, numParts, singlePrecision, bvhName,
+        memReport, memBudget, isMirrored ? &symNormal : 0, symOffset);
+    if (ok && (0 != fanCache.reusedVertexCount())) {
+        fprintf(stderr, "reused the polygons of %u vertices, rebuilt %u\n",
+            fanCache.reusedVertexCount(), fanCache.rebuiltVertexCount());
+    }
+    if (ok && (0 != cacheName) && !region.isSet() &&
+            !fanCache.save(cacheName, cacheKey)) {
+        fprintf(stderr, "warning: %s: could not write topology cache\n",
+            cacheName);
+    }
+
+    for (UInt32 jj = 0; ok && (jj < UInt32(variants.size())); ++jj) {
+        const std::string varName = DualVariant::fileName(outName, jj + 1);
+        const std::string varBvhName = (0 == bvhName) ? std::string() :
+            DualVariant::fileName(bvhName, jj + 1);
+        builder.setMaxTurnAngle(variants[jj].maxTurnAngle_);
+        builder.setPlacement(variants[jj].placement_);
+        ok = runToFile(builder, varName.c_str(), numParts, singlePrecision,
+            (0 == bvhName) ? 0 : varBvhName.c_str(), memReport, memBudget,
+            isMirrored ? &symNormal : 0, symOffset);
+        if (ok) {
+            fprintf(stderr, "%s: reused the polygons of %u vertices, "
+                "rebuilt %u\n", varName.c_str(), fanCache.reusedVertexCount(),
+                fanCache.rebuiltVertexCount());
+        }
+    }
+
+    if ((0 != traceName) && !DualTrace::save(traceName)) {
+        fprintf(stderr, "warning: %s: could not write trace\n", traceName);
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
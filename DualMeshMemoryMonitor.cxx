@@ -0,0 +1,247 @@
+/****************************************************************************
+ *
+ * class DualMeshMemoryMonitor
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <cstdio>
+
+#include "DualMeshMemoryMonitor.h"
+
+// Number of budget checks per step
+static const UInt32 ChecksPerStep = 16;
+
+
+//! Prints numBytes in MB, or in KB or bytes if it is below 1 MB
+static void
+formatBytes(size_t numBytes, char *buf, size_t bufSize)
+{
+    if (numBytes >= 1024 * 1024) {
+        snprintf(buf, bufSize, "%.1f MB",
+            double(numBytes) / (1024.0 * 1024.0));
+    }
+    else if (numBytes >= 1024) {
+        snprintf(buf, bufSize, "%.1f KB", double(numBytes) / 1024.0);
+    }
+    else {
+        snprintf(buf, bufSize, "%u bytes", UInt32(numBytes));
+    }
+}
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualMeshMemoryMonitor::DualMeshMemoryMonitor(DualMeshSink &target) :
+    target_(target),
+    budget_(0),
+    report_(false),
+    warned_(false),
+    stepNum_(0),
+    stepStartBytes_(0),
+    stepTotal_(0),
+    stepDone_(0),
+    nextCheck_(0)
+{
+}
+
+
+DualMeshMemoryMonitor::~DualMeshMemoryMonitor()
+{
+}
+
+
+void
+DualMeshMemoryMonitor::begin()
+{
+    MemoryStats::resetPeaks();
+    warned_ = false;
+    stepNum_ = 0;
+}
+
+
+bool
+DualMeshMemoryMonitor::writeGceVertex(UInt32 gceVertNdx, const Vec3 &v)
+{
+    MemoryStats::Scope memScope(MemoryStats::Output);
+    return target_.writeGceVertex(gceVertNdx, v);
+}
+
+
+bool
+DualMeshMemoryMonitor::beginCentroids(UInt32 count)
+{
+    MemoryStats::Scope memScope(MemoryStats::Output);
+    return target_.beginCentroids(count);
+}
+
+
+bool
+DualMeshMemoryMonitor::beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids)
+{
+    MemoryStats::Scope memScope(MemoryStats::Output);
+    return target_.beginHardMids(numBndryMids, numCnxnMids);
+}
+
+
+bool
+DualMeshMemoryMonitor::writeVertex(UInt32 dualNdx, const Vec3 &v,
+    VertType vType)
+{
+    MemoryStats::Scope memScope(MemoryStats::Output);
+    return target_.writeVertex(dualNdx, v, vType);
+}
+
+
+bool
+DualMeshMemoryMonitor::writePoly(UInt32 gceVertNdx, bool isBndry,
+    const UInt32Array1 &dualVerts)
+{
+    MemoryStats::Scope memScope(MemoryStats::Output);
+    return target_.writePoly(gceVertNdx, isBndry, dualVerts);
+}
+
+
+bool
+DualMeshMemoryMonitor::writePolyEdges(UInt32 polyNdx,
+    const UInt32Array1 &dualEdges)
+{
+    MemoryStats::Scope memScope(MemoryStats::Output);
+    return target_.writePolyEdges(polyNdx, dualEdges);
+}
+
+
+bool
+DualMeshMemoryMonitor::beginDualEdges(UInt32 count)
+{
+    MemoryStats::Scope memScope(MemoryStats::Output);
+    return target_.beginDualEdges(count);
+}
+
+
+bool
+DualMeshMemoryMonitor::writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+    UInt32 leftPoly, UInt32 rightPoly)
+{
+    MemoryStats::Scope memScope(MemoryStats::Output);
+    return target_.writeDualEdge(edgeNdx, dualVerts, leftPoly, rightPoly);
+}
+
+
+bool
+DualMeshMemoryMonitor::writeAggLevel(UInt32 level, UInt32 numCoarse,
+    const UInt32Array1 &fineToCoarse)
+{
+    MemoryStats::Scope memScope(MemoryStats::Output);
+    return target_.writeAggLevel(level, numCoarse, fineToCoarse);
+}
+
+
+bool
+DualMeshMemoryMonitor::endMesh()
+{
+    MemoryStats::Scope memScope(MemoryStats::Output);
+    return target_.endMesh();
+}
+
+
+bool
+DualMeshMemoryMonitor::beginStep(UInt32 total)
+{
+    stepStartBytes_ = MemoryStats::totalBytes();
+    stepTotal_ = total;
+    stepDone_ = 0;
+    nextCheck_ = (total + ChecksPerStep - 1) / ChecksPerStep;
+    checkBudget(MemoryStats::peakTotalBytes());
+    return target_.beginStep(total);
+}
+
+
+bool
+DualMeshMemoryMonitor::incrementStep()
+{
+    ++stepDone_;
+    if ((0 != budget_) && !warned_ && (stepDone_ >= nextCheck_) &&
+            (stepDone_ < stepTotal_)) {
+        nextCheck_ += (stepTotal_ + ChecksPerStep - 1) / ChecksPerStep;
+        // Assume the step keeps growing at the same rate
+        const size_t curBytes = MemoryStats::totalBytes();
+        size_t projected = MemoryStats::peakTotalBytes();
+        if (curBytes > stepStartBytes_) {
+            const double growth = double(curBytes - stepStartBytes_) *
+                double(stepTotal_) / double(stepDone_);
+            if (double(stepStartBytes_) + growth > double(projected)) {
+                projected = size_t(double(stepStartBytes_) + growth);
+            }
+        }
+        checkBudget(projected);
+    }
+    return target_.incrementStep();
+}
+
+
+bool
+DualMeshMemoryMonitor::endStep()
+{
+    ++stepNum_;
+    checkBudget(MemoryStats::peakTotalBytes());
+    if (report_) {
+        char stats[512];
+        MemoryStats::format(stats, sizeof(stats));
+        char msg[600];
+        sprintf(msg, "memory after step %u: %s", stepNum_, stats);
+        reportMsg(msg);
+    }
+    return target_.endStep();
+}
+
+
+void
+DualMeshMemoryMonitor::errorMsg(const char *msg)
+{
+    target_.errorMsg(msg);
+}
+
+
+void
+DualMeshMemoryMonitor::warningMsg(const char *msg)
+{
+    target_.warningMsg(msg);
+}
+
+
+void
+DualMeshMemoryMonitor::infoMsg(const char *msg)
+{
+    target_.infoMsg(msg);
+}
+
+
+void
+DualMeshMemoryMonitor::reportMsg(const char *msg)
+{
+    target_.infoMsg(msg);
+}
+
+
+void
+DualMeshMemoryMonitor::checkBudget(size_t projectedBytes)
+{
+    if ((0 == budget_) || warned_ || (projectedBytes <= budget_)) {
+        return;
+    }
+    warned_ = true;
+    char projected[32];
+    char budget[32];
+    formatBytes(projectedBytes, projected, sizeof(projected));
+    formatBytes(budget_, budget, sizeof(budget));
+    char msg[256];
+    sprintf(msg, "memory: projected peak of %s in step %u exceeds the "
+        "budget of %s", projected, stepNum_ + 1, budget);
+    target_.warningMsg(msg);
+}
@@ -0,0 +1,106 @@
+/****************************************************************************
+ *
+ * class DualMeshMemoryMonitor
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALMESHMEMORYMONITOR_H_
+#define _DUALMESHMEMORYMONITOR_H_
+
+#include "DualMeshSink.h"
+#include "MemoryStats.h"
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! DualMeshSink that forwards everything to a target sink and watches the
+    MemoryStats counters.
+
+    The write methods are forwarded in the Output category, so the buffers
+    of the output writers are charged to Output. At the end of each progress
+    step, the total and per category bytes are reported if enabled. If a
+    budget is set, the peak of the running step is projected from its growth
+    so far and a warning is sent as soon as the projection exceeds the
+    budget. The warning is sent once per run.
+*/
+class DualMeshMemoryMonitor : public DualMeshSink {
+public:
+
+    DualMeshMemoryMonitor(DualMeshSink &target);
+    virtual ~DualMeshMemoryMonitor();
+
+    //! Sets the budget in bytes. 0 disables the budget check.
+    inline void
+    setBudget(size_t numBytes)
+    {
+        budget_ = numBytes;
+    }
+
+
+    //! Report the memory use at the end of each step?
+    inline void
+    setReport(bool report)
+    {
+        report_ = report;
+    }
+
+
+    //! Resets the MemoryStats peaks and the step count. Call before the
+    //! first step of a run.
+    void            begin();
+
+    virtual bool    writeGceVertex(UInt32 gceVertNdx, const Vec3 &v);
+    virtual bool    beginCentroids(UInt32 count);
+    virtual bool    beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids);
+    virtual bool    writeVertex(UInt32 dualNdx, const Vec3 &v,
+                        VertType vType);
+    virtual bool    writePoly(UInt32 gceVertNdx, bool isBndry,
+                        const UInt32Array1 &dualVerts);
+    virtual bool    writePolyEdges(UInt32 polyNdx,
+                        const UInt32Array1 &dualEdges);
+    virtual bool    beginDualEdges(UInt32 count);
+    virtual bool    writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+                        UInt32 leftPoly, UInt32 rightPoly);
+    virtual bool    writeAggLevel(UInt32 level, UInt32 numCoarse,
+                        const UInt32Array1 &fineToCoarse);
+    virtual bool    endMesh();
+    virtual bool    beginStep(UInt32 total);
+    virtual bool    incrementStep();
+    virtual bool    endStep();
+    virtual void    errorMsg(const char *msg);
+    virtual void    warningMsg(const char *msg);
+    virtual void    infoMsg(const char *msg);
+
+protected:
+
+    //! Sends a memory report line. The default sends it to the target's
+    //! infoMsg().
+    virtual void    reportMsg(const char *msg);
+
+private:
+
+    void            checkBudget(size_t projectedBytes);
+
+private:
+
+    DualMeshSink &  target_;
+    size_t          budget_;
+    bool            report_;
+    bool            warned_;
+    UInt32          stepNum_;
+
+    //! The running step
+    size_t          stepStartBytes_;
+    UInt32          stepTotal_;
+    UInt32          stepDone_;
+    UInt32          nextCheck_;
+};
+
+#endif // _DUALMESHMEMORYMONITOR_H_
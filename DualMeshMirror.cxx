@@ -0,0 +1,665 @@
+/****************************************************************************
+ *
+ * class DualMeshMirror
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "DualMeshMirror.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+namespace {
+
+//! A vertex closer to the plane than this times the grid extent is on it
+const double PlaneRelTol = 1.0e-6;
+
+typedef std::pair<UInt32, UInt32> UInt32Pair;
+
+
+inline bool
+isHardMid(UInt8 vType)
+{
+    return (DualMeshSink::BndryVert == vType) ||
+        (DualMeshSink::CnxnVert == vType);
+}
+
+} // namespace
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualMeshMirror::DualMeshMirror(DualMeshSink &target) :
+    target_(target),
+    isEnabled_(false),
+    normal_(0.0, 0.0, 1.0),
+    offset_(0.0),
+    cosMaxTurnAngle_(-1.0),
+    gceXyz_(),
+    vertXyz_(),
+    vertTypes_(),
+    polyGceVerts_(),
+    polyBndry_(),
+    polyOffsets_(1, 0),
+    polyVerts_()
+{
+}
+
+
+DualMeshMirror::~DualMeshMirror()
+{
+}
+
+
+void
+DualMeshMirror::setPlane(const Vec3 &normal, double offset)
+{
+    isEnabled_ = true;
+    normal_ = normal;
+    offset_ = offset;
+    clearMesh();
+}
+
+
+void
+DualMeshMirror::clearPlane()
+{
+    isEnabled_ = false;
+    clearMesh();
+}
+
+
+bool
+DualMeshMirror::isEnabled() const
+{
+    return isEnabled_;
+}
+
+
+void
+DualMeshMirror::setCosMaxTurnAngle(double cosMaxTurnAngle)
+{
+    cosMaxTurnAngle_ = cosMaxTurnAngle;
+}
+
+
+bool
+DualMeshMirror::writeGceVertex(UInt32 gceVertNdx, const Vec3 &v)
+{
+    if (!isEnabled_) {
+        return target_.writeGceVertex(gceVertNdx, v);
+    }
+    const double xyz[3] = { v[0], v[1], v[2] };
+    gceXyz_.insert(gceXyz_.end(), xyz, xyz + 3);
+    return true;
+}
+
+
+bool
+DualMeshMirror::beginCentroids(UInt32 count)
+{
+    if (!isEnabled_) {
+        return target_.beginCentroids(count);
+    }
+    vertXyz_.reserve(3 * size_t(count));
+    vertTypes_.reserve(count);
+    return true;
+}
+
+
+bool
+DualMeshMirror::beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids)
+{
+    if (!isEnabled_) {
+        return target_.beginHardMids(numBndryMids, numCnxnMids);
+    }
+    const size_t numVerts = vertTypes_.size() + numBndryMids + numCnxnMids;
+    vertXyz_.reserve(3 * numVerts);
+    vertTypes_.reserve(numVerts);
+    return true;
+}
+
+
+bool
+DualMeshMirror::writeVertex(UInt32 dualNdx, const Vec3 &v, VertType vType)
+{
+    if (!isEnabled_) {
+        return target_.writeVertex(dualNdx, v, vType);
+    }
+    const double xyz[3] = { v[0], v[1], v[2] };
+    vertXyz_.insert(vertXyz_.end(), xyz, xyz + 3);
+    vertTypes_.push_back(UInt8(vType));
+    return true;
+}
+
+
+bool
+DualMeshMirror::writePoly(UInt32 gceVertNdx, bool isBndry,
+    const UInt32Array1 &dualVerts)
+{
+    if (!isEnabled_) {
+        return target_.writePoly(gceVertNdx, isBndry, dualVerts);
+    }
+    for (size_t ii = 0; ii < dualVerts.size(); ++ii) {
+        if (dualVerts[ii] >= vertTypes_.size()) {
+            target_.errorMsg("polygon references an unknown dual vertex");
+            return false;
+        }
+    }
+    if (gceVertNdx >= gceXyz_.size() / 3) {
+        target_.errorMsg("polygon references an unknown gce vertex");
+        return false;
+    }
+    polyGceVerts_.push_back(gceVertNdx);
+    polyBndry_.push_back(isBndry ? 1 : 0);
+    polyVerts_.insert(polyVerts_.end(), dualVerts.begin(), dualVerts.end());
+    polyOffsets_.push_back(UInt32(polyVerts_.size()));
+    return true;
+}
+
+
+bool
+DualMeshMirror::writePolyEdges(UInt32 polyNdx, const UInt32Array1 &dualEdges)
+{
+    if (isEnabled_) {
+        target_.errorMsg("dual edges can not be mirrored");
+        return false;
+    }
+    return target_.writePolyEdges(polyNdx, dualEdges);
+}
+
+
+bool
+DualMeshMirror::beginDualEdges(UInt32 count)
+{
+    if (isEnabled_) {
+        target_.errorMsg("dual edges can not be mirrored");
+        return false;
+    }
+    return target_.beginDualEdges(count);
+}
+
+
+bool
+DualMeshMirror::writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+    UInt32 leftPoly, UInt32 rightPoly)
+{
+    if (isEnabled_) {
+        target_.errorMsg("dual edges can not be mirrored");
+        return false;
+    }
+    return target_.writeDualEdge(edgeNdx, dualVerts, leftPoly, rightPoly);
+}
+
+
+bool
+DualMeshMirror::writeAggLevel(UInt32 level, UInt32 numCoarse,
+    const UInt32Array1 &fineToCoarse)
+{
+    if (isEnabled_) {
+        target_.errorMsg("agglomeration levels can not be mirrored");
+        return false;
+    }
+    return target_.writeAggLevel(level, numCoarse, fineToCoarse);
+}
+
+
+bool
+DualMeshMirror::endMesh()
+{
+    if (!isEnabled_) {
+        return target_.endMesh();
+    }
+    const bool ret = writeMirrored() && target_.endMesh();
+    clearMesh();
+    return ret;
+}
+
+
+bool
+DualMeshMirror::beginStep(UInt32 total)
+{
+    return target_.beginStep(total);
+}
+
+
+bool
+DualMeshMirror::incrementStep()
+{
+    return target_.incrementStep();
+}
+
+
+bool
+DualMeshMirror::endStep()
+{
+    return target_.endStep();
+}
+
+
+void
+DualMeshMirror::errorMsg(const char *msg)
+{
+    target_.errorMsg(msg);
+}
+
+
+void
+DualMeshMirror::warningMsg(const char *msg)
+{
+    target_.warningMsg(msg);
+}
+
+
+void
+DualMeshMirror::infoMsg(const char *msg)
+{
+    target_.infoMsg(msg);
+}
+
+
+bool
+DualMeshMirror::parsePlane(const char *str, Vec3 &normal, double &offset)
+{
+    double v[4];
+    char extra;
+    bool ret = (0 != str) && (4 == sscanf(str, "%lf %lf %lf %lf %c",
+        &v[0], &v[1], &v[2], &v[3], &extra));
+    const double len = ret ?
+        std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]) : 0.0;
+    ret = ret && (0.0 < len);
+    if (ret) {
+        normal.set(v[0] / len, v[1] / len, v[2] / len);
+        offset = v[3] / len;
+    }
+    return ret;
+}
+
+
+bool
+DualMeshMirror::fitPlane(const TriMesh &mesh, const UInt32Array1 &verts,
+    Vec3 &normal, double &offset)
+{
+    // The plane is spanned by the vertex farthest from the first one and
+    // the vertex farthest from the line through both.
+    Vec3 p0;
+    Vec3 p;
+    size_t first = 0;
+    while ((first < verts.size()) && !mesh.getCoord(verts[first], p0)) {
+        ++first;
+    }
+    Vec3 dir(0.0, 0.0, 0.0);
+    double maxLenSq = 0.0;
+    for (size_t ii = first; ii < verts.size(); ++ii) {
+        if (mesh.getCoord(verts[ii], p) &&
+                ((p - p0).length_squared() > maxLenSq)) {
+            dir = p - p0;
+            maxLenSq = dir.length_squared();
+        }
+    }
+    if (0.0 == maxLenSq) {
+        return false;
+    }
+    dir /= std::sqrt(maxLenSq);
+    const double tol = PlaneRelTol * std::sqrt(maxLenSq);
+    Vec3 span(0.0, 0.0, 0.0);
+    double maxDistSq = 0.0;
+    for (size_t ii = first; ii < verts.size(); ++ii) {
+        if (mesh.getCoord(verts[ii], p)) {
+            const Vec3 c = cml::cross(dir, p - p0);
+            if (c.length_squared() > maxDistSq) {
+                span = c;
+                maxDistSq = c.length_squared();
+            }
+        }
+    }
+    if (maxDistSq > tol * tol) {
+        normal = span / std::sqrt(maxDistSq);
+    }
+    else if (mesh.isPlanar()) {
+        // the line is in the z plane of the mesh
+        normal.set(dir[1], -dir[0], 0.0);
+        normal /= normal.length();
+    }
+    else {
+        return false;
+    }
+    offset = cml::dot(normal, p0);
+    for (size_t ii = first; ii < verts.size(); ++ii) {
+        if (mesh.getCoord(verts[ii], p) &&
+                (std::fabs(cml::dot(normal, p) - offset) > tol)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool
+DualMeshMirror::writeMirrored()
+{
+    const UInt32 numGceVerts = UInt32(gceXyz_.size() / 3);
+    const UInt32 numVerts = UInt32(vertTypes_.size());
+    const UInt32 numPolys = UInt32(polyGceVerts_.size());
+
+    // The plane tolerance is relative to the extent of the grid
+    double lo[3] = { 0.0, 0.0, 0.0 };
+    double hi[3] = { 0.0, 0.0, 0.0 };
+    for (size_t ii = 0; ii < gceXyz_.size(); ++ii) {
+        const size_t k = ii % 3;
+        lo[k] = ((ii < 3) || (gceXyz_[ii] < lo[k])) ? gceXyz_[ii] : lo[k];
+        hi[k] = ((ii < 3) || (gceXyz_[ii] > hi[k])) ? gceXyz_[ii] : hi[k];
+    }
+    const double tol = PlaneRelTol * std::sqrt((hi[0] - lo[0]) *
+        (hi[0] - lo[0]) + (hi[1] - lo[1]) * (hi[1] - lo[1]) +
+        (hi[2] - lo[2]) * (hi[2] - lo[2]));
+
+    // The gce vertices on the plane are their own mirror image. The images
+    // of the others follow the half model.
+    UInt8Array1 gceOnPlane(numGceVerts, 0);
+    UInt32Array1 gceImages(numGceVerts);
+    UInt32 numFullGceVerts = numGceVerts;
+    bool isBelow = false;
+    bool isAbove = false;
+    for (UInt32 ii = 0; ii < numGceVerts; ++ii) {
+        const double *p = &gceXyz_[3 * size_t(ii)];
+        const double dist = normal_[0] * p[0] + normal_[1] * p[1] +
+            normal_[2] * p[2] - offset_;
+        if (std::fabs(dist) <= tol) {
+            gceOnPlane[ii] = 1;
+            gceImages[ii] = ii;
+        }
+        else {
+            isBelow = isBelow || (dist < 0.0);
+            isAbove = isAbove || (dist > 0.0);
+            gceImages[ii] = numFullGceVerts++;
+        }
+    }
+    if (isBelow && isAbove) {
+        target_.errorMsg("the grid crosses the symmetry plane");
+        return false;
+    }
+
+    // The hard mids and hard gce vertices on the plane are shared. An
+    // element vertex never is, even if the placement put it there.
+    UInt8Array1 isShared(numVerts, 0);
+    for (UInt32 ii = 0; ii < numVerts; ++ii) {
+        isShared[ii] = (ElemVert != vertTypes_[ii]) &&
+            (std::fabs(cml::dot(normal_, vertXyz(ii)) - offset_) <= tol);
+    }
+
+    // A vertex reference below numVerts is a half model vertex. Adding
+    // numVerts gives its mirror image. References from 2 * numVerts on are
+    // the hard gce vertices added for the new corners.
+    const UInt32 NewBase = 2 * numVerts;
+
+    // The gce vertices on the plane that are corners of the full model,
+    // found from their other (unshared) hard mids
+    std::vector<UInt32Pair> otherMids;
+    std::vector<UInt32Pair> halfCorners;
+    for (UInt32 pp = 0; pp < numPolys; ++pp) {
+        const UInt32 gce = polyGceVerts_[pp];
+        if (!gceOnPlane[gce]) {
+            continue;
+        }
+        for (UInt32 ii = polyOffsets_[pp]; ii < polyOffsets_[pp + 1]; ++ii) {
+            const UInt32 v = polyVerts_[ii];
+            if (isHardMid(vertTypes_[v]) && !isShared[v]) {
+                otherMids.push_back(UInt32Pair(gce, v));
+            }
+            else if ((GceVert == vertTypes_[v]) && isShared[v]) {
+                halfCorners.push_back(UInt32Pair(gce, v));
+            }
+        }
+    }
+    std::sort(otherMids.begin(), otherMids.end());
+    otherMids.erase(std::unique(otherMids.begin(), otherMids.end()),
+        otherMids.end());
+    UInt32Array1 cornerGces;
+    for (size_t ii = 0; ii < otherMids.size(); ) {
+        const UInt32 gce = otherMids[ii].first;
+        size_t jj = ii + 1;
+        while ((jj < otherMids.size()) && (gce == otherMids[jj].first)) {
+            ++jj;
+        }
+        // Junctions are always corners. A single hard edge turns from its
+        // mirror image into itself. With d = mid - gce that turn is
+        // (2 dot(d, n)^2 - dot(d, d)) / dot(d, d).
+        bool isCorner = (1 < jj - ii);
+        if (!isCorner) {
+            const double *p = &gceXyz_[3 * size_t(gce)];
+            const Vec3 d = vertXyz(otherMids[ii].second) -
+                Vec3(p[0], p[1], p[2]);
+            const double dd = cml::dot(d, d);
+            const double dn = cml::dot(d, normal_);
+            isCorner = (0.0 < dd) &&
+                ((2.0 * dn * dn - dd) / dd < cosMaxTurnAngle_);
+        }
+        if (isCorner) {
+            cornerGces.push_back(gce);
+        }
+        ii = jj;
+    }
+    std::vector<UInt32Pair>().swap(otherMids);
+    // The corners keep the hard gce vertex of the half model if it has one
+    UInt32Array1 cornerRefs(cornerGces.size(), UInt32Undef);
+    for (size_t ii = 0; ii < halfCorners.size(); ++ii) {
+        UInt32Array1::const_iterator it = std::lower_bound(cornerGces.begin(),
+            cornerGces.end(), halfCorners[ii].first);
+        if ((cornerGces.end() != it) && (*it == halfCorners[ii].first)) {
+            cornerRefs[it - cornerGces.begin()] = halfCorners[ii].second;
+        }
+    }
+    UInt32Array1 newCornerGces;
+
+    // The full model polygons as vertex references
+    UInt32Array1 fullGceVerts;
+    UInt8Array1 fullBndry;
+    UInt32Array1 fullOffsets(1, 0);
+    UInt32Array1 fullRefs;
+    fullGceVerts.reserve(2 * size_t(numPolys));
+    fullBndry.reserve(2 * size_t(numPolys));
+    fullOffsets.reserve(2 * size_t(numPolys) + 1);
+    fullRefs.reserve(2 * polyVerts_.size());
+    UInt32Array1 chain;
+    UInt32 numUnmerged = 0;
+    for (UInt32 pp = 0; pp < numPolys; ++pp) {
+        const UInt32 gce = polyGceVerts_[pp];
+        const UInt32 *verts = &polyVerts_[0] + polyOffsets_[pp];
+        const UInt32 n = polyOffsets_[pp + 1] - polyOffsets_[pp];
+        // A polygon on the plane is one chain of unshared vertices closed
+        // by a run of shared ones that holds the symmetry edge mids
+        UInt32 numChains = 0;
+        UInt32 start = 0;
+        bool hasSharedMid = false;
+        for (UInt32 ii = 0; gceOnPlane[gce] && (ii < n); ++ii) {
+            if (isShared[verts[(ii + n - 1) % n]] && !isShared[verts[ii]]) {
+                ++numChains;
+                start = ii;
+            }
+            hasSharedMid = hasSharedMid ||
+                (isShared[verts[ii]] && isHardMid(vertTypes_[verts[ii]]));
+        }
+        if (!gceOnPlane[gce] || (1 != numChains) || !hasSharedMid) {
+            fullRefs.insert(fullRefs.end(), verts, verts + n);
+            fullOffsets.push_back(UInt32(fullRefs.size()));
+            fullGceVerts.push_back(gce);
+            fullBndry.push_back(polyBndry_[pp]);
+            if (gceOnPlane[gce]) {
+                // The polygon and its mirror image stay separate
+                numUnmerged += hasSharedMid ? 1 : 0;
+                for (UInt32 ii = n; ii > 0; --ii) {
+                    const UInt32 v = verts[ii - 1];
+                    fullRefs.push_back(isShared[v] ? v : numVerts + v);
+                }
+                fullOffsets.push_back(UInt32(fullRefs.size()));
+                fullGceVerts.push_back(gce);
+                fullBndry.push_back(polyBndry_[pp]);
+            }
+            continue;
+        }
+        chain.clear();
+        bool isBndry = false;
+        for (UInt32 ii = start; !isShared[verts[ii % n]]; ++ii) {
+            chain.push_back(verts[ii % n]);
+            isBndry = isBndry || isHardMid(vertTypes_[chain.back()]);
+        }
+        // The merged polygon is the chain followed by its reversed mirror
+        // image. It starts and ends at the other hard edge, so that the
+        // gap between the edge and its mirror image closes it.
+        const bool endsAtMid = isHardMid(vertTypes_[chain.back()]);
+        if (!endsAtMid) {
+            fullRefs.insert(fullRefs.end(), chain.begin(), chain.end());
+        }
+        for (size_t ii = chain.size(); ii > 0; --ii) {
+            fullRefs.push_back(numVerts + chain[ii - 1]);
+        }
+        if (endsAtMid) {
+            fullRefs.insert(fullRefs.end(), chain.begin(), chain.end());
+        }
+        UInt32Array1::const_iterator it = std::lower_bound(cornerGces.begin(),
+            cornerGces.end(), gce);
+        if (isBndry && (cornerGces.end() != it) && (*it == gce)) {
+            UInt32 &ref = cornerRefs[it - cornerGces.begin()];
+            if (UInt32Undef == ref) {
+                ref = NewBase + UInt32(newCornerGces.size());
+                newCornerGces.push_back(gce);
+            }
+            fullRefs.push_back(ref);
+        }
+        fullOffsets.push_back(UInt32(fullRefs.size()));
+        fullGceVerts.push_back(gce);
+        fullBndry.push_back(isBndry ? 1 : 0);
+    }
+    UInt32Array1().swap(cornerRefs);
+    // The mirror images of the polygons off the plane with reversed winding
+    for (UInt32 pp = 0; pp < numPolys; ++pp) {
+        const UInt32 gce = polyGceVerts_[pp];
+        if (gceOnPlane[gce]) {
+            continue;
+        }
+        for (UInt32 ii = polyOffsets_[pp + 1]; ii > polyOffsets_[pp]; --ii) {
+            const UInt32 v = polyVerts_[ii - 1];
+            fullRefs.push_back(isShared[v] ? v : numVerts + v);
+        }
+        fullOffsets.push_back(UInt32(fullRefs.size()));
+        fullGceVerts.push_back(gceImages[gce]);
+        fullBndry.push_back(polyBndry_[pp]);
+    }
+    if (0 < numUnmerged) {
+        char msg[128];
+        sprintf(msg, "%u polygons at the symmetry plane were not merged",
+            numUnmerged);
+        target_.warningMsg(msg);
+    }
+
+    // Number the used vertices by type. The half model vertices of a type
+    // come first, then their mirror images.
+    UInt8Array1 isUsed(NewBase, 0);
+    for (size_t ii = 0; ii < fullRefs.size(); ++ii) {
+        if (fullRefs[ii] < NewBase) {
+            isUsed[fullRefs[ii]] = 1;
+        }
+    }
+    const VertType TypeOrder[4] = { ElemVert, BndryVert, CnxnVert, GceVert };
+    UInt32 typeCounts[4] = { 0, 0, 0, 0 };
+    UInt32Array1 fullNdx(NewBase + newCornerGces.size(), UInt32Undef);
+    UInt32 numFullVerts = 0;
+    for (int tt = 0; tt < 4; ++tt) {
+        for (UInt32 ref = 0; ref < NewBase; ++ref) {
+            if (isUsed[ref] &&
+                    (TypeOrder[tt] == vertTypes_[ref % numVerts])) {
+                fullNdx[ref] = numFullVerts++;
+                ++typeCounts[tt];
+            }
+        }
+    }
+    for (UInt32 ii = 0; ii < UInt32(newCornerGces.size()); ++ii) {
+        fullNdx[NewBase + ii] = numFullVerts++;
+        ++typeCounts[3];
+    }
+
+    // Write the full model
+    bool ret = true;
+    for (UInt32 ii = 0; ret && (ii < numGceVerts); ++ii) {
+        const double *p = &gceXyz_[3 * size_t(ii)];
+        ret = target_.writeGceVertex(ii, Vec3(p[0], p[1], p[2]));
+    }
+    for (UInt32 ii = 0; ret && (ii < numGceVerts); ++ii) {
+        if (!gceOnPlane[ii]) {
+            const double *p = &gceXyz_[3 * size_t(ii)];
+            ret = target_.writeGceVertex(gceImages[ii],
+                reflect(Vec3(p[0], p[1], p[2])));
+        }
+    }
+    ret = ret && target_.beginCentroids(typeCounts[0]);
+    for (int tt = 0; ret && (tt < 4); ++tt) {
+        if (1 == tt) {
+            ret = target_.beginHardMids(typeCounts[1], typeCounts[2]);
+        }
+        for (UInt32 ref = 0; ret && (ref < NewBase); ++ref) {
+            const UInt32 v = ref % numVerts;
+            if (isUsed[ref] && (TypeOrder[tt] == vertTypes_[v])) {
+                ret = target_.writeVertex(fullNdx[ref], (ref < numVerts) ?
+                    vertXyz(v) : reflect(vertXyz(v)), TypeOrder[tt]);
+            }
+        }
+    }
+    for (UInt32 ii = 0; ret && (ii < UInt32(newCornerGces.size())); ++ii) {
+        const double *p = &gceXyz_[3 * size_t(newCornerGces[ii])];
+        ret = target_.writeVertex(fullNdx[NewBase + ii],
+            Vec3(p[0], p[1], p[2]), GceVert);
+    }
+    UInt32Array1 dualVerts;
+    for (size_t pp = 0; ret && (pp < fullGceVerts.size()); ++pp) {
+        dualVerts.clear();
+        for (UInt32 ii = fullOffsets[pp]; ii < fullOffsets[pp + 1]; ++ii) {
+            dualVerts.push_back(fullNdx[fullRefs[ii]]);
+        }
+        ret = target_.writePoly(fullGceVerts[pp], 0 != fullBndry[pp],
+            dualVerts);
+    }
+    return ret;
+}
+
+
+Vec3
+DualMeshMirror::reflect(const Vec3 &v) const
+{
+    return v - (2.0 * (cml::dot(normal_, v) - offset_)) * normal_;
+}
+
+
+Vec3
+DualMeshMirror::vertXyz(UInt32 dualNdx) const
+{
+    const double *p = &vertXyz_[3 * size_t(dualNdx)];
+    return Vec3(p[0], p[1], p[2]);
+}
+
+
+void
+DualMeshMirror::clearMesh()
+{
+    DoubleArray1().swap(gceXyz_);
+    DoubleArray1().swap(vertXyz_);
+    UInt8Array1().swap(vertTypes_);
+    UInt32Array1().swap(polyGceVerts_);
+    UInt8Array1().swap(polyBndry_);
+    UInt32Array1(1, 0).swap(polyOffsets_);
+    UInt32Array1().swap(polyVerts_);
+}
@@ -0,0 +1,127 @@
+/****************************************************************************
+ *
+ * class DualMeshMirror
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALMESHMIRROR_H_
+#define _DUALMESHMIRROR_H_
+
+#include "DualMeshSink.h"
+#include "PluginTypes.h"
+#include "TriMesh.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! DualMeshSink that turns the dual of a half model into the dual of the
+    full model and forwards it to a target sink.
+
+    The half model lies on one side of a symmetry plane. The dual mesh is
+    kept while it streams through. endMesh() writes it followed by its
+    mirror image: the coordinates are reflected across the plane and the
+    polygon winding is reversed. The gce vertices and the hard mids and
+    hard gce vertices that lie on the plane are shared by both halves.
+
+    The polygon of a gce vertex on the plane is merged with its mirror
+    image into one polygon. The mids of the symmetry edges are dropped, as
+    these edges are interior edges of the full model. The merged polygon
+    keeps the hard gce vertex if the gce vertex still is a corner of the
+    full model. That is the case if it has more than one other hard edge
+    or if its other hard edge and its mirror image turn by more than the
+    max turning angle.
+
+    Dual edges and agglomeration levels can not be mirrored. If no plane
+    is set, the mirror only forwards.
+*/
+class DualMeshMirror : public DualMeshSink {
+public:
+
+    DualMeshMirror(DualMeshSink &target);
+    virtual ~DualMeshMirror();
+
+    //! Mirrors across the plane dot(normal, x) = offset. normal must be
+    //! a unit vector.
+    void            setPlane(const Vec3 &normal, double offset);
+
+    //! Turns mirroring off
+    void            clearPlane();
+
+    bool            isEnabled() const;
+
+    //! The max turning angle of the build. Decides which gce vertices on
+    //! the plane are corners of the full model.
+    void            setCosMaxTurnAngle(double cosMaxTurnAngle);
+
+    virtual bool    writeGceVertex(UInt32 gceVertNdx, const Vec3 &v);
+    virtual bool    beginCentroids(UInt32 count);
+    virtual bool    beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids);
+    virtual bool    writeVertex(UInt32 dualNdx, const Vec3 &v,
+                        VertType vType);
+    virtual bool    writePoly(UInt32 gceVertNdx, bool isBndry,
+                        const UInt32Array1 &dualVerts);
+    virtual bool    writePolyEdges(UInt32 polyNdx,
+                        const UInt32Array1 &dualEdges);
+    virtual bool    beginDualEdges(UInt32 count);
+    virtual bool    writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+                        UInt32 leftPoly, UInt32 rightPoly);
+    virtual bool    writeAggLevel(UInt32 level, UInt32 numCoarse,
+                        const UInt32Array1 &fineToCoarse);
+    virtual bool    endMesh();
+    virtual bool    beginStep(UInt32 total);
+    virtual bool    incrementStep();
+    virtual bool    endStep();
+    virtual void    errorMsg(const char *msg);
+    virtual void    warningMsg(const char *msg);
+    virtual void    infoMsg(const char *msg);
+
+    //! Parses the 4 numbers "a b c d" of the plane a*x + b*y + c*z = d.
+    //! Returns false if str is not 4 numbers or (a, b, c) is zero.
+    static bool     parsePlane(const char *str, Vec3 &normal, double &offset);
+
+    //! Finds the plane of the verts of mesh. The verts of a planar mesh
+    //! may be on a line. The plane then is the one through the line that
+    //! is normal to the mesh. Returns false if the verts do not span a
+    //! plane or are not all on it.
+    static bool     fitPlane(const TriMesh &mesh, const UInt32Array1 &verts,
+                        Vec3 &normal, double &offset);
+
+private:
+
+    //! Writes the full model to the target
+    bool            writeMirrored();
+
+    //! The mirror image of v
+    Vec3            reflect(const Vec3 &v) const;
+
+    Vec3            vertXyz(UInt32 dualNdx) const;
+
+    //! Frees the kept half model
+    void            clearMesh();
+
+private:
+
+    DualMeshSink &  target_;
+    bool            isEnabled_;
+    Vec3            normal_;
+    double          offset_;
+    double          cosMaxTurnAngle_;
+
+    //! The kept half model. 3 xyz values per vertex. The polygon vertices
+    //! of polygon p are polyVerts_[polyOffsets_[p] .. polyOffsets_[p+1]).
+    DoubleArray1    gceXyz_;
+    DoubleArray1    vertXyz_;
+    UInt8Array1     vertTypes_;
+    UInt32Array1    polyGceVerts_;
+    UInt8Array1     polyBndry_;
+    UInt32Array1    polyOffsets_;
+    UInt32Array1    polyVerts_;
+};
+
+#endif // _DUALMESHMIRROR_H_
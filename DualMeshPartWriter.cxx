@@ -0,0 +1,392 @@
+/****************************************************************************
+ *
+ * class DualMeshPartWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+
+#include "DualMeshPartWriter.h"
+#include "DualPartitioner.h"
+
+static const char   FileMagic[] = "DUALPRT1";
+static const UInt32 FileVersion = 1;
+
+// Part file arrays start on 8 byte boundaries
+static const size_t Align = 8;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualMeshPartWriter::DualMeshPartWriter(std::FILE *fp, const char *baseName,
+        UInt32 numParts) :
+    fp_(fp),
+    baseName_((0 == baseName) ? "" : baseName),
+    numParts_((0 == numParts) ? 1 : numParts),
+    xyz_(),
+    vertTypes_(),
+    polyVerts_(),
+    polyOffsets_(1, 0),
+    polyBndry_(),
+    polyGceVerts_(),
+    polyParts_(),
+    partOffsets_(),
+    partPolys_(),
+    vertPolyOffsets_(),
+    vertPolys_(),
+    vertOwners_(),
+    polyStamps_(),
+    vertStamps_(),
+    vertLocals_()
+{
+}
+
+
+DualMeshPartWriter::~DualMeshPartWriter()
+{
+}
+
+
+bool
+DualMeshPartWriter::writeGceVertex(UInt32 gceVertNdx, const Vec3 &v)
+{
+    // the gce vertices are not part of the dual mesh
+    (void)gceVertNdx;
+    (void)v;
+    return true;
+}
+
+
+bool
+DualMeshPartWriter::beginCentroids(UInt32 count)
+{
+    xyz_.reserve(3 * size_t(count));
+    vertTypes_.reserve(count);
+    return true;
+}
+
+
+bool
+DualMeshPartWriter::beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids)
+{
+    const size_t count = vertTypes_.size() + numBndryMids + numCnxnMids;
+    xyz_.reserve(3 * count);
+    vertTypes_.reserve(count);
+    return true;
+}
+
+
+bool
+DualMeshPartWriter::writeVertex(UInt32 dualNdx, const Vec3 &v,
+    VertType vType)
+{
+    if (dualNdx != vertTypes_.size()) {
+        return false;
+    }
+    xyz_.push_back(v[0]);
+    xyz_.push_back(v[1]);
+    xyz_.push_back(v[2]);
+    vertTypes_.push_back(UInt8(vType));
+    return true;
+}
+
+
+bool
+DualMeshPartWriter::writePoly(UInt32 gceVertNdx, bool isBndry,
+    const UInt32Array1 &dualVerts)
+{
+    polyVerts_.insert(polyVerts_.end(), dualVerts.begin(), dualVerts.end());
+    polyOffsets_.push_back(UInt32(polyVerts_.size()));
+    polyBndry_.push_back(isBndry ? 1 : 0);
+    polyGceVerts_.push_back(gceVertNdx);
+    return true;
+}
+
+
+bool
+DualMeshPartWriter::endMesh()
+{
+    const UInt32 numVerts = UInt32(vertTypes_.size());
+    const UInt32 numPolys = UInt32(polyGceVerts_.size());
+    UInt32Array1::const_iterator it = polyVerts_.begin();
+    for (; it != polyVerts_.end(); ++it) {
+        if (*it >= numVerts) {
+            errorMsg("polygon references an invalid dual vertex index");
+            return false;
+        }
+    }
+
+    // Partition the polygon centroids
+    DoubleArray1 centroids(3 * size_t(numPolys), 0.0);
+    for (UInt32 poly = 0; poly < numPolys; ++poly) {
+        double *c = &centroids[3 * size_t(poly)];
+        const UInt32 begin = polyOffsets_[poly];
+        const UInt32 end = polyOffsets_[poly + 1];
+        for (UInt32 ii = begin; ii < end; ++ii) {
+            const double *p = &xyz_[3 * size_t(polyVerts_[ii])];
+            c[0] += p[0];
+            c[1] += p[1];
+            c[2] += p[2];
+        }
+        if (begin != end) {
+            c[0] /= (end - begin);
+            c[1] /= (end - begin);
+            c[2] /= (end - begin);
+        }
+    }
+    DualPartitioner::rcb(centroids.empty() ? 0 : &centroids[0], numPolys,
+        numParts_, polyParts_);
+    DoubleArray1().swap(centroids);
+
+    // Counting sort of the polygons by part
+    partOffsets_.assign(size_t(numParts_) + 1, 0);
+    for (UInt32 poly = 0; poly < numPolys; ++poly) {
+        ++partOffsets_[polyParts_[poly] + 1];
+    }
+    for (UInt32 part = 0; part < numParts_; ++part) {
+        partOffsets_[part + 1] += partOffsets_[part];
+    }
+    partPolys_.resize(numPolys);
+    UInt32Array1 fill(partOffsets_.begin(), partOffsets_.end() - 1);
+    for (UInt32 poly = 0; poly < numPolys; ++poly) {
+        partPolys_[fill[polyParts_[poly]]++] = poly;
+    }
+
+    buildVertPolys();
+    polyStamps_.assign(numPolys, UInt32Undef);
+    vertStamps_.assign(numVerts, UInt32Undef);
+    vertLocals_.assign(numVerts, UInt32Undef);
+
+    bool ret = (0 <= fprintf(fp_, "# dual mesh partitions\n"
+        "# part ownPolys haloPolys file\n"
+        "parts %u polys %u verts %u\n", numParts_, numPolys, numVerts));
+    for (UInt32 part = 0; ret && (part < numParts_); ++part) {
+        // the manifest lists the part files relative to itself
+        const std::string name = partFileName(part);
+        const size_t slash = name.find_last_of("/\\");
+        UInt32 numOwned = 0;
+        UInt32 numHalo = 0;
+        ret = writePart(part, numOwned, numHalo) &&
+            (0 <= fprintf(fp_, "part %u %u %u %s\n", part, numOwned, numHalo,
+                name.c_str() + ((std::string::npos == slash) ? 0 :
+                    slash + 1)));
+    }
+    return ret;
+}
+
+
+void
+DualMeshPartWriter::errorMsg(const char *msg)
+{
+    fprintf(stderr, "error: %s\n", msg);
+}
+
+
+void
+DualMeshPartWriter::warningMsg(const char *msg)
+{
+    fprintf(stderr, "warning: %s\n", msg);
+}
+
+
+std::string
+DualMeshPartWriter::partFileName(UInt32 part) const
+{
+    char suffix[32];
+    sprintf(suffix, ".p%u.dmp", part);
+    return baseName_ + suffix;
+}
+
+
+const char *
+DualMeshPartWriter::fileMagic()
+{
+    return FileMagic;
+}
+
+
+void
+DualMeshPartWriter::buildVertPolys()
+{
+    // Counting sort of the polygon vertex references into CSR form. Also
+    // finds the lowest part that uses each vertex.
+    const UInt32 numVerts = UInt32(vertTypes_.size());
+    const UInt32 numPolys = UInt32(polyGceVerts_.size());
+    vertPolyOffsets_.assign(size_t(numVerts) + 1, 0);
+    vertOwners_.assign(numVerts, UInt32Undef);
+    for (UInt32 poly = 0; poly < numPolys; ++poly) {
+        for (UInt32 ii = polyOffsets_[poly]; ii < polyOffsets_[poly + 1];
+                ++ii) {
+            const UInt32 vert = polyVerts_[ii];
+            ++vertPolyOffsets_[vert + 1];
+            vertOwners_[vert] = std::min(vertOwners_[vert], polyParts_[poly]);
+        }
+    }
+    for (UInt32 ii = 0; ii < numVerts; ++ii) {
+        vertPolyOffsets_[ii + 1] += vertPolyOffsets_[ii];
+    }
+    vertPolys_.resize(vertPolyOffsets_[numVerts]);
+    UInt32Array1 fill(vertPolyOffsets_.begin(), vertPolyOffsets_.end() - 1);
+    for (UInt32 poly = 0; poly < numPolys; ++poly) {
+        for (UInt32 ii = polyOffsets_[poly]; ii < polyOffsets_[poly + 1];
+                ++ii) {
+            vertPolys_[fill[polyVerts_[ii]]++] = poly;
+        }
+    }
+}
+
+
+bool
+DualMeshPartWriter::writePart(UInt32 part, UInt32 &numOwned,
+    UInt32 &numHalo)
+{
+    // The own polygons followed by the halo polygons in ascending order
+    UInt32Array1 polys(partPolys_.begin() + partOffsets_[part],
+        partPolys_.begin() + partOffsets_[part + 1]);
+    numOwned = UInt32(polys.size());
+    for (UInt32 ii = 0; ii < numOwned; ++ii) {
+        polyStamps_[polys[ii]] = part;
+    }
+    for (UInt32 ii = 0; ii < numOwned; ++ii) {
+        const UInt32 poly = polys[ii];
+        for (UInt32 jj = polyOffsets_[poly]; jj < polyOffsets_[poly + 1];
+                ++jj) {
+            const UInt32 vert = polyVerts_[jj];
+            for (UInt32 kk = vertPolyOffsets_[vert];
+                    kk < vertPolyOffsets_[vert + 1]; ++kk) {
+                if (part != polyStamps_[vertPolys_[kk]]) {
+                    polyStamps_[vertPolys_[kk]] = part;
+                    polys.push_back(vertPolys_[kk]);
+                }
+            }
+        }
+    }
+    std::sort(polys.begin() + numOwned, polys.end());
+    numHalo = UInt32(polys.size()) - numOwned;
+
+    // Number the vertices in the order the polygons use them. The vertices
+    // of the own polygons come first.
+    UInt32Array1 verts;
+    UInt32Array1 offsets(1, 0);
+    UInt32Array1 localPolyVerts;
+    UInt32 numOwnedVerts = 0;
+    for (UInt32 ii = 0; ii < polys.size(); ++ii) {
+        const UInt32 poly = polys[ii];
+        for (UInt32 jj = polyOffsets_[poly]; jj < polyOffsets_[poly + 1];
+                ++jj) {
+            const UInt32 vert = polyVerts_[jj];
+            if (part != vertStamps_[vert]) {
+                vertStamps_[vert] = part;
+                vertLocals_[vert] = UInt32(verts.size());
+                verts.push_back(vert);
+            }
+            localPolyVerts.push_back(vertLocals_[vert]);
+        }
+        offsets.push_back(UInt32(localPolyVerts.size()));
+        if (ii + 1 == numOwned) {
+            numOwnedVerts = UInt32(verts.size());
+        }
+    }
+
+    // The other parts whose own polygons use each own vertex
+    UInt32Array1 shared;
+    UInt32Array1 otherParts;
+    for (UInt32 ii = 0; ii < numOwnedVerts; ++ii) {
+        const UInt32 vert = verts[ii];
+        otherParts.clear();
+        for (UInt32 kk = vertPolyOffsets_[vert];
+                kk < vertPolyOffsets_[vert + 1]; ++kk) {
+            const UInt32 other = polyParts_[vertPolys_[kk]];
+            if (part != other) {
+                otherParts.push_back(other);
+            }
+        }
+        std::sort(otherParts.begin(), otherParts.end());
+        otherParts.erase(std::unique(otherParts.begin(), otherParts.end()),
+            otherParts.end());
+        for (UInt32 kk = 0; kk < otherParts.size(); ++kk) {
+            shared.push_back(ii);
+            shared.push_back(otherParts[kk]);
+        }
+    }
+
+    // Gather the per vertex and per polygon arrays
+    const UInt32 numVerts = UInt32(verts.size());
+    const UInt32 numPolys = UInt32(polys.size());
+    DoubleArray1 xyz(3 * size_t(numVerts));
+    UInt32Array1 owners(numVerts);
+    UInt8Array1 vertTypes(numVerts);
+    for (UInt32 ii = 0; ii < numVerts; ++ii) {
+        std::copy(&xyz_[3 * size_t(verts[ii])],
+            &xyz_[3 * size_t(verts[ii])] + 3, &xyz[3 * size_t(ii)]);
+        owners[ii] = vertOwners_[verts[ii]];
+        vertTypes[ii] = vertTypes_[verts[ii]];
+    }
+    UInt32Array1 gceVerts(numPolys);
+    UInt8Array1 bndry(numPolys);
+    UInt32Array1 haloOwners(numHalo);
+    for (UInt32 ii = 0; ii < numPolys; ++ii) {
+        gceVerts[ii] = polyGceVerts_[polys[ii]];
+        bndry[ii] = polyBndry_[polys[ii]];
+        if (ii >= numOwned) {
+            haloOwners[ii - numOwned] = polyParts_[polys[ii]];
+        }
+    }
+
+    const std::string name = partFileName(part);
+    std::FILE *fp = fopen(name.c_str(), "wb");
+    if (0 == fp) {
+        const std::string msg = name + ": could not open part file";
+        errorMsg(msg.c_str());
+        return false;
+    }
+    const UInt32 header[8] = { FileVersion, part, numParts_, numVerts,
+        numOwned, numHalo, UInt32(localPolyVerts.size()),
+        UInt32(shared.size() / 2) };
+    bool ret = (1 == fwrite(FileMagic, sizeof(FileMagic) - 1, 1, fp)) &&
+        (1 == fwrite(header, sizeof(header), 1, fp)) &&
+        writeArray(fp, xyz.empty() ? 0 : &xyz[0],
+            xyz.size() * sizeof(double)) &&
+        writeArray(fp, verts.empty() ? 0 : &verts[0],
+            verts.size() * sizeof(UInt32)) &&
+        writeArray(fp, owners.empty() ? 0 : &owners[0],
+            owners.size() * sizeof(UInt32)) &&
+        writeArray(fp, vertTypes.empty() ? 0 : &vertTypes[0],
+            vertTypes.size()) &&
+        writeArray(fp, &offsets[0], offsets.size() * sizeof(UInt32)) &&
+        writeArray(fp, localPolyVerts.empty() ? 0 : &localPolyVerts[0],
+            localPolyVerts.size() * sizeof(UInt32)) &&
+        writeArray(fp, polys.empty() ? 0 : &polys[0],
+            polys.size() * sizeof(UInt32)) &&
+        writeArray(fp, gceVerts.empty() ? 0 : &gceVerts[0],
+            gceVerts.size() * sizeof(UInt32)) &&
+        writeArray(fp, bndry.empty() ? 0 : &bndry[0], bndry.size()) &&
+        writeArray(fp, haloOwners.empty() ? 0 : &haloOwners[0],
+            haloOwners.size() * sizeof(UInt32)) &&
+        writeArray(fp, shared.empty() ? 0 : &shared[0],
+            shared.size() * sizeof(UInt32));
+    ret = (0 == fclose(fp)) && ret;
+    if (!ret) {
+        const std::string msg = name + ": part file write failed";
+        errorMsg(msg.c_str());
+    }
+    return ret;
+}
+
+
+bool
+DualMeshPartWriter::writeArray(std::FILE *fp, const void *data,
+    size_t numBytes)
+{
+    static const char zeros[Align] = { 0 };
+    const size_t pad = (Align - numBytes % Align) % Align;
+    return ((0 == numBytes) || (1 == fwrite(data, numBytes, 1, fp))) &&
+        ((0 == pad) || (1 == fwrite(zeros, pad, 1, fp)));
+}
@@ -0,0 +1,116 @@
+/****************************************************************************
+ *
+ * class DualMeshPartWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALMESHPARTWRITER_H_
+#define _DUALMESHPARTWRITER_H_
+
+#include <cstdio>
+#include <string>
+
+#include "DualMeshSink.h"
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Splits the dual polygons into parts and writes one binary part file per
+    part (.dmp).
+
+    The polygons are partitioned by recursive coordinate bisection of their
+    centroids (the mean of their dual vertices). Each part file holds the
+    part's own polygons followed by its halo: the polygons of other parts
+    that share a dual vertex with an own polygon. Vertices and polygons are
+    numbered locally, and the global index of each is stored. Each vertex
+    also stores its owner, the lowest part whose own polygons use it. The
+    shared vertex list pairs each own vertex with every other part whose
+    own polygons use it. See README.md for the layout.
+
+    A text manifest that lists the part files is written to fp. Part k is
+    written to baseName.p<k>.dmp. The points and polygons are buffered and
+    the parts are written by endMesh(). Dual edges and agglomeration levels
+    are not written.
+*/
+class DualMeshPartWriter : public DualMeshSink {
+public:
+
+    DualMeshPartWriter(std::FILE *fp, const char *baseName, UInt32 numParts);
+    virtual ~DualMeshPartWriter();
+
+    virtual bool    writeGceVertex(UInt32 gceVertNdx, const Vec3 &v);
+    virtual bool    beginCentroids(UInt32 count);
+    virtual bool    beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids);
+    virtual bool    writeVertex(UInt32 dualNdx, const Vec3 &v,
+                        VertType vType);
+    virtual bool    writePoly(UInt32 gceVertNdx, bool isBndry,
+                        const UInt32Array1 &dualVerts);
+    virtual bool    endMesh();
+
+    virtual void    errorMsg(const char *msg);
+    virtual void    warningMsg(const char *msg);
+
+    //! The name of the file of part k
+    std::string     partFileName(UInt32 part) const;
+
+    static const char * fileMagic();
+
+private:
+
+    void            buildVertPolys();
+    bool            writePart(UInt32 part, UInt32 &numOwned,
+                        UInt32 &numHalo);
+    bool            writeArray(std::FILE *fp, const void *data,
+                        size_t numBytes);
+
+private:
+
+    std::FILE *     fp_;
+    std::string     baseName_;
+    UInt32          numParts_;
+
+    //! The dual vertex xyz values. 3 per vertex.
+    DoubleArray1    xyz_;
+
+    //! The dual vertex VertType values
+    UInt8Array1     vertTypes_;
+
+    //! The polygon dual vertices. The dual vertices of polygon p are
+    //! polyVerts_[polyOffsets_[p] .. polyOffsets_[p+1]).
+    UInt32Array1    polyVerts_;
+    UInt32Array1    polyOffsets_;
+
+    //! Per polygon BndryPoly flag and primal vertex
+    UInt8Array1     polyBndry_;
+    UInt32Array1    polyGceVerts_;
+
+    //! The part of each polygon
+    UInt32Array1    polyParts_;
+
+    //! The polygons of part k are
+    //! partPolys_[partOffsets_[k] .. partOffsets_[k+1]) in ascending order.
+    UInt32Array1    partOffsets_;
+    UInt32Array1    partPolys_;
+
+    //! CSR polygon lists of each dual vertex
+    UInt32Array1    vertPolyOffsets_;
+    UInt32Array1    vertPolys_;
+
+    //! The lowest part whose own polygons use each dual vertex
+    UInt32Array1    vertOwners_;
+
+    //! Scratch arrays of writePart(). The part that last visited each
+    //! polygon and vertex and the vertex's local index in that part.
+    UInt32Array1    polyStamps_;
+    UInt32Array1    vertStamps_;
+    UInt32Array1    vertLocals_;
+};
+
+#endif // _DUALMESHPARTWRITER_H_
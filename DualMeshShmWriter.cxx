@@ -0,0 +1,238 @@
+/****************************************************************************
+ *
+ * class DualMeshShmWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#if !defined(WINDOWS)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <unistd.h>
+#endif
+
+#include "DualMeshShmWriter.h"
+
+static const char SegmentMagic[] = "DUALSHM1";
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+namespace {
+
+inline unsigned long long
+alignUp(unsigned long long offset)
+{
+    return (offset + 7) & ~7ULL;
+}
+
+
+//! Sets offset to the current end and moves the end past numBytes
+inline void
+placeArray(unsigned long long &end, size_t numBytes,
+    unsigned long long &offset)
+{
+    offset = end;
+    end = alignUp(end + numBytes);
+}
+
+
+template<typename T>
+inline void
+copyArray(char *base, unsigned long long offset, const T &array)
+{
+    if (!array.empty()) {
+        memcpy(base + offset, &array[0],
+            array.size() * sizeof(typename T::value_type));
+    }
+}
+
+} // namespace
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualMeshShmWriter::DualMeshShmWriter(const char *name) :
+    name_(),
+    gceXyz_(),
+    xyz_(),
+    vertTypes_(),
+    polyGceVerts_(),
+    polyBndry_(),
+    polyOffsets_(1, 0),
+    polyVerts_()
+{
+    name_ = ((0 != name) && ('/' == name[0])) ? "" : "/";
+    name_ += (0 == name) ? "" : name;
+}
+
+
+DualMeshShmWriter::~DualMeshShmWriter()
+{
+}
+
+
+bool
+DualMeshShmWriter::writeGceVertex(UInt32 gceVertNdx, const Vec3 &v)
+{
+    (void)gceVertNdx;
+    const double xyz[3] = { v[0], v[1], v[2] };
+    gceXyz_.insert(gceXyz_.end(), xyz, xyz + 3);
+    return true;
+}
+
+
+bool
+DualMeshShmWriter::beginCentroids(UInt32 count)
+{
+    xyz_.reserve(3 * size_t(count));
+    vertTypes_.reserve(count);
+    return true;
+}
+
+
+bool
+DualMeshShmWriter::beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids)
+{
+    const size_t numVerts = vertTypes_.size() + numBndryMids + numCnxnMids;
+    xyz_.reserve(3 * numVerts);
+    vertTypes_.reserve(numVerts);
+    return true;
+}
+
+
+bool
+DualMeshShmWriter::writeVertex(UInt32 dualNdx, const Vec3 &v,
+    VertType vType)
+{
+    (void)dualNdx;
+    const double xyz[3] = { v[0], v[1], v[2] };
+    xyz_.insert(xyz_.end(), xyz, xyz + 3);
+    vertTypes_.push_back(UInt8(vType));
+    return true;
+}
+
+
+bool
+DualMeshShmWriter::writePoly(UInt32 gceVertNdx, bool isBndry,
+    const UInt32Array1 &dualVerts)
+{
+    polyGceVerts_.push_back(gceVertNdx);
+    polyBndry_.push_back(isBndry ? 1 : 0);
+    polyVerts_.insert(polyVerts_.end(), dualVerts.begin(), dualVerts.end());
+    polyOffsets_.push_back(UInt32(polyVerts_.size()));
+    return true;
+}
+
+
+bool
+DualMeshShmWriter::endMesh()
+{
+    return publish();
+}
+
+
+void
+DualMeshShmWriter::errorMsg(const char *msg)
+{
+    fprintf(stderr, "error: %s\n", msg);
+}
+
+
+void
+DualMeshShmWriter::warningMsg(const char *msg)
+{
+    fprintf(stderr, "warning: %s\n", msg);
+}
+
+
+bool
+DualMeshShmWriter::isShmName(const char *outName, std::string &name)
+{
+    const bool ret = (0 != outName) && (0 == strncmp(outName, "shm:", 4)) &&
+        ('\0' != outName[4]);
+    if (ret) {
+        name = outName + 4;
+    }
+    return ret;
+}
+
+
+const char *
+DualMeshShmWriter::segmentMagic()
+{
+    return SegmentMagic;
+}
+
+
+bool
+DualMeshShmWriter::publish()
+{
+#if defined(WINDOWS)
+    return false;
+#else
+    Header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic_, SegmentMagic, sizeof(hdr.magic_));
+    hdr.version_ = Version;
+    hdr.numGceVerts_ = UInt32(gceXyz_.size() / 3);
+    hdr.numVerts_ = UInt32(vertTypes_.size());
+    hdr.numPolys_ = UInt32(polyGceVerts_.size());
+    hdr.numPolyVerts_ = UInt32(polyVerts_.size());
+    unsigned long long end = alignUp(sizeof(Header));
+    placeArray(end, gceXyz_.size() * sizeof(double), hdr.gceXyzOffset_);
+    placeArray(end, xyz_.size() * sizeof(double), hdr.xyzOffset_);
+    placeArray(end, polyGceVerts_.size() * sizeof(UInt32),
+        hdr.polyGceVertOffset_);
+    placeArray(end, polyOffsets_.size() * sizeof(UInt32),
+        hdr.polyOffsetsOffset_);
+    placeArray(end, polyVerts_.size() * sizeof(UInt32), hdr.polyVertsOffset_);
+    placeArray(end, vertTypes_.size(), hdr.vertTypeOffset_);
+    placeArray(end, polyBndry_.size(), hdr.polyBndryOffset_);
+    hdr.totalBytes_ = end;
+
+    // A new segment, so a consumer of the old one is not disturbed
+    shm_unlink(name_.c_str());
+    const int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    void *addr = MAP_FAILED;
+    if (0 == ftruncate(fd, off_t(hdr.totalBytes_))) {
+        addr = mmap(0, size_t(hdr.totalBytes_), PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (MAP_FAILED == addr) {
+        shm_unlink(name_.c_str());
+        return false;
+    }
+    char *base = static_cast<char*>(addr);
+    // ready_ is 0 until the arrays are in place
+    memcpy(base, &hdr, sizeof(hdr));
+    copyArray(base, hdr.gceXyzOffset_, gceXyz_);
+    copyArray(base, hdr.xyzOffset_, xyz_);
+    copyArray(base, hdr.polyGceVertOffset_, polyGceVerts_);
+    copyArray(base, hdr.polyOffsetsOffset_, polyOffsets_);
+    copyArray(base, hdr.polyVertsOffset_, polyVerts_);
+    copyArray(base, hdr.vertTypeOffset_, vertTypes_);
+    copyArray(base, hdr.polyBndryOffset_, polyBndry_);
+    volatile UInt32 *ready = &reinterpret_cast<Header*>(base)->ready_;
+    std::atomic_thread_fence(std::memory_order_release);
+    *ready = 1;
+    const bool ret = (0 == msync(addr, size_t(hdr.totalBytes_), MS_ASYNC));
+    munmap(addr, size_t(hdr.totalBytes_));
+    return ret;
+#endif
+}
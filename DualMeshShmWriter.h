@@ -0,0 +1,111 @@
+/****************************************************************************
+ *
+ * class DualMeshShmWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALMESHSHMWRITER_H_
+#define _DUALMESHSHMWRITER_H_
+
+#include <string>
+
+#include "DualMeshSink.h"
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Publishes the dual mesh in a named POSIX shared memory segment.
+
+    The dual vertex and polygon arrays are gathered in memory and copied to
+    a new segment at endMesh(). A consumer process on the same node maps the
+    segment and uses the arrays in place. The segment starts with a Header.
+    Its ready_ flag is set last, after a release fence, so a consumer that
+    sees ready_ == 1 (followed by an acquire fence) sees complete arrays.
+
+    An existing segment of the same name is unlinked first. A consumer that
+    still maps it keeps the old data. The segment stays after the export
+    until a consumer or the next export unlinks it.
+
+    The dual edges and agglomeration levels are not published. Not
+    supported on Windows.
+*/
+class DualMeshShmWriter : public DualMeshSink {
+public:
+
+    //! Native byte order. Each array starts on an 8 byte boundary at its
+    //! byte offset from the segment start.
+    struct Header {
+        char                magic_[8];          //!< "DUALSHM1"
+        UInt32              version_;
+        UInt32              ready_;             //!< 1 when complete
+        UInt32              numGceVerts_;
+        UInt32              numVerts_;
+        UInt32              numPolys_;
+        UInt32              numPolyVerts_;
+        unsigned long long  totalBytes_;        //!< segment size
+        unsigned long long  gceXyzOffset_;      //!< double [numGceVerts][3]
+        unsigned long long  xyzOffset_;         //!< double [numVerts][3]
+        unsigned long long  polyGceVertOffset_; //!< UInt32 [numPolys]
+        unsigned long long  polyOffsetsOffset_; //!< UInt32 [numPolys+1]
+        unsigned long long  polyVertsOffset_;   //!< UInt32 [numPolyVerts]
+        unsigned long long  vertTypeOffset_;    //!< UInt8 [numVerts]
+        unsigned long long  polyBndryOffset_;   //!< UInt8 [numPolys]
+    };
+
+    enum {
+        Version = 1
+    };
+
+    //! name is the shm_open() name. A leading '/' is added if missing.
+    DualMeshShmWriter(const char *name);
+    virtual ~DualMeshShmWriter();
+
+    virtual bool    writeGceVertex(UInt32 gceVertNdx, const Vec3 &v);
+    virtual bool    beginCentroids(UInt32 count);
+    virtual bool    beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids);
+    virtual bool    writeVertex(UInt32 dualNdx, const Vec3 &v,
+                        VertType vType);
+    virtual bool    writePoly(UInt32 gceVertNdx, bool isBndry,
+                        const UInt32Array1 &dualVerts);
+    virtual bool    endMesh();
+
+    virtual void    errorMsg(const char *msg);
+    virtual void    warningMsg(const char *msg);
+
+    inline const std::string &
+    name() const
+    {
+        return name_;
+    }
+
+
+    //! Returns true if outName is "shm:<name>" and sets name
+    static bool     isShmName(const char *outName, std::string &name);
+
+    static const char * segmentMagic();
+
+private:
+
+    //! Creates the segment and copies the arrays into it
+    bool            publish();
+
+private:
+
+    std::string     name_;
+    DoubleArray1    gceXyz_;
+    DoubleArray1    xyz_;
+    UInt8Array1     vertTypes_;
+    UInt32Array1    polyGceVerts_;
+    UInt8Array1     polyBndry_;
+    UInt32Array1    polyOffsets_;
+    UInt32Array1    polyVerts_;
+};
+
+#endif // _DUALMESHSHMWRITER_H_
@@ -0,0 +1,122 @@
+/****************************************************************************
+ *
+ * class DualMeshSink
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALMESHSINK_H_
+#define _DUALMESHSINK_H_
+
+#include <cctype>
+#include <cstring>
+
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Receives the dual mesh from a DualMeshBuilder.
+
+    The builder calls the write methods in this order:
+      writeGceVertex()  for every primal (gce) vertex
+      beginCentroids()  followed by writeVertex(ElemVert) for every triangle
+      beginHardMids()   followed by writeVertex(BndryVert or CnxnVert)
+      writeVertex(GceVert) for every exported hard gce vertex
+      writePoly()       for every dual polygon
+      writeAggLevel()   for every agglomeration level, if enabled with
+                        DualMeshBuilder::setAggLevels()
+      endMesh()         after the last polygon
+    Dual vertex and polygon indices are assigned in write order starting at 0.
+
+    If dual edges are enabled with DualMeshBuilder::setDualEdges(), each
+    writePoly() is followed by writePolyEdges(). Edge k of a polygon joins
+    its dual vertices k and k+1, so the polygon vertex and edge lists share
+    the same CSR offsets. After the last polygon, beginDualEdges() is
+    followed by writeDualEdge() for every dual edge.
+
+    The progress methods bracket each major step of the build. Returning
+    false from any method aborts the build.
+*/
+class DualMeshSink {
+public:
+
+    enum VertType {
+        BndryVert, ElemVert, CnxnVert, GceVert
+    };
+
+    virtual ~DualMeshSink() {}
+
+    virtual bool    writeGceVertex(UInt32 gceVertNdx, const Vec3 &v) = 0;
+    virtual bool    beginCentroids(UInt32 count) = 0;
+    virtual bool    beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids) = 0;
+    virtual bool    writeVertex(UInt32 dualNdx, const Vec3 &v,
+                        VertType vType) = 0;
+    virtual bool    writePoly(UInt32 gceVertNdx, bool isBndry,
+                        const UInt32Array1 &dualVerts) = 0;
+
+    // optional dual edge handlers
+    virtual bool    writePolyEdges(UInt32 polyNdx,
+                        const UInt32Array1 &dualEdges)
+                    { (void)polyNdx; (void)dualEdges; return true; }
+    virtual bool    beginDualEdges(UInt32 count) { (void)count; return true; }
+
+    //! dualVerts are in leftPoly order. rightPoly is UInt32Undef for an edge
+    //! on the grid boundary.
+    virtual bool    writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+                        UInt32 leftPoly, UInt32 rightPoly)
+                    {
+                        (void)edgeNdx; (void)dualVerts; (void)leftPoly;
+                        (void)rightPoly;
+                        return true;
+                    }
+
+    //! fineToCoarse maps each node of the next finer level (the polygons
+    //! for level 1) to one of the numCoarse nodes of level.
+    virtual bool    writeAggLevel(UInt32 level, UInt32 numCoarse,
+                        const UInt32Array1 &fineToCoarse)
+                    {
+                        (void)level; (void)numCoarse; (void)fineToCoarse;
+                        return true;
+                    }
+
+    //! Called once after all polygons were written. Sinks that buffer the
+    //! dual mesh write it here.
+    virtual bool    endMesh() { return true; }
+
+    // progress handlers
+    virtual bool    beginStep(UInt32 total) { (void)total; return true; }
+    virtual bool    incrementStep() { return true; }
+    virtual bool    endStep() { return true; }
+
+    // message handlers
+    virtual void    errorMsg(const char *msg) { (void)msg; }
+    virtual void    warningMsg(const char *msg) { (void)msg; }
+    virtual void    infoMsg(const char *msg) { (void)msg; }
+
+    //! Returns true if filename ends with ext (case insensitive). ext must
+    //! be lower case and include the dot.
+    static bool
+    hasFileExt(const char *filename, const char *ext)
+    {
+        const size_t extLen = strlen(ext);
+        const size_t len = (0 == filename) ? 0 : strlen(filename);
+        if (len < extLen) {
+            return false;
+        }
+        const char *p = filename + len - extLen;
+        for (size_t ii = 0; ii < extLen; ++ii) {
+            if (ext[ii] != tolower((unsigned char)p[ii])) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif // _DUALMESHSINK_H_
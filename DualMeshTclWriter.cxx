@@ -0,0 +1,136 @@
+/****************************************************************************
+ *
+ * class DualMeshTclWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <cstdio>
+
+#include "DualMeshTclWriter.h"
+
+
+DualMeshTclWriter::DualMeshTclWriter(std::FILE *fp, bool singlePrecision) :
+    fp_(fp),
+    digits_(singlePrecision ? 9 : 17)
+{
+}
+
+
+DualMeshTclWriter::~DualMeshTclWriter()
+{
+}
+
+
+bool
+DualMeshTclWriter::writeGceVertex(UInt32 gceVertNdx, const Vec3 &v)
+{
+    return 0 < fprintf(fp_, "gceVertex %u { %.*g %.*g %.*g }\n", gceVertNdx,
+        digits_, v[0], digits_, v[1], digits_, v[2]);
+}
+
+
+bool
+DualMeshTclWriter::beginCentroids(UInt32 count)
+{
+    return 0 < fprintf(fp_, "# Element centroid points %u\n", count);
+}
+
+
+bool
+DualMeshTclWriter::beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids)
+{
+    (void)numCnxnMids;
+    return 0 < fprintf(fp_, "# boundary mid points %u\n", numBndryMids);
+}
+
+
+bool
+DualMeshTclWriter::writeVertex(UInt32 dualNdx, const Vec3 &v, VertType vType)
+{
+    static const char *vertTypeNames[] = {
+                            "Bndry", // BndryVert,
+                            "Elem",  // ElemVert,
+                            "Cnxn",  // CnxnVert,
+                            "Gce"    // GceVert
+                        };
+    return 0 < fprintf(fp_, "vertex %s %u { %.*g %.*g %.*g }\n",
+        vertTypeNames[vType], dualNdx, digits_, v[0], digits_, v[1], digits_,
+        v[2]);
+}
+
+
+bool
+DualMeshTclWriter::writePoly(UInt32 gceVertNdx, bool isBndry,
+    const UInt32Array1 &dualVerts)
+{
+    (void)gceVertNdx;
+    // boundary vertex cells form a partial, <360 deg polygon
+    bool ret = (EOF != fputs(isBndry ? "poly B { " : "poly I { ", fp_));
+    UInt32Array1::const_iterator it = dualVerts.begin();
+    for (; ret && (it != dualVerts.end()); ++it) {
+        ret = (0 < fprintf(fp_, "%u ", *it));
+    }
+    return ret && (EOF != fputs("}\n", fp_));
+}
+
+
+bool
+DualMeshTclWriter::writePolyEdges(UInt32 polyNdx,
+    const UInt32Array1 &dualEdges)
+{
+    bool ret = (0 < fprintf(fp_, "polyEdges %u { ", polyNdx));
+    UInt32Array1::const_iterator it = dualEdges.begin();
+    for (; ret && (it != dualEdges.end()); ++it) {
+        ret = (0 < fprintf(fp_, "%u ", *it));
+    }
+    return ret && (EOF != fputs("}\n", fp_));
+}
+
+
+bool
+DualMeshTclWriter::beginDualEdges(UInt32 count)
+{
+    return 0 < fprintf(fp_, "# dual edges %u\n", count);
+}
+
+
+bool
+DualMeshTclWriter::writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+    UInt32 leftPoly, UInt32 rightPoly)
+{
+    // boundary edges have no right polygon
+    return 0 < fprintf(fp_, "dualEdge %u { %u %u } %u %d\n", edgeNdx,
+        dualVerts[0], dualVerts[1], leftPoly,
+        (UInt32Undef == rightPoly) ? -1 : int(rightPoly));
+}
+
+
+bool
+DualMeshTclWriter::writeAggLevel(UInt32 level, UInt32 numCoarse,
+    const UInt32Array1 &fineToCoarse)
+{
+    bool ret = (0 < fprintf(fp_, "aggLevel %u %u { ", level, numCoarse));
+    UInt32Array1::const_iterator it = fineToCoarse.begin();
+    for (; ret && (it != fineToCoarse.end()); ++it) {
+        ret = (0 < fprintf(fp_, "%u ", *it));
+    }
+    return ret && (EOF != fputs("}\n", fp_));
+}
+
+
+void
+DualMeshTclWriter::errorMsg(const char *msg)
+{
+    fprintf(stderr, "error: %s\n", msg);
+}
+
+
+void
+DualMeshTclWriter::warningMsg(const char *msg)
+{
+    fprintf(stderr, "warning: %s\n", msg);
+}
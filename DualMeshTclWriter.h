@@ -0,0 +1,57 @@
+/****************************************************************************
+ *
+ * class DualMeshTclWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALMESHTCLWRITER_H_
+#define _DUALMESHTCLWRITER_H_
+
+#include <cstdio>
+
+#include "DualMeshSink.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Writes the dual mesh as a Tcl script to a stdio FILE. The script has the
+    same form as the one written by the CaeUnsDualMesh plugin and can be
+    loaded with importDualMesh.glf.
+*/
+class DualMeshTclWriter : public DualMeshSink {
+public:
+
+    DualMeshTclWriter(std::FILE *fp, bool singlePrecision = false);
+    virtual ~DualMeshTclWriter();
+
+    virtual bool    writeGceVertex(UInt32 gceVertNdx, const Vec3 &v);
+    virtual bool    beginCentroids(UInt32 count);
+    virtual bool    beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids);
+    virtual bool    writeVertex(UInt32 dualNdx, const Vec3 &v,
+                        VertType vType);
+    virtual bool    writePoly(UInt32 gceVertNdx, bool isBndry,
+                        const UInt32Array1 &dualVerts);
+    virtual bool    writePolyEdges(UInt32 polyNdx,
+                        const UInt32Array1 &dualEdges);
+    virtual bool    beginDualEdges(UInt32 count);
+    virtual bool    writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+                        UInt32 leftPoly, UInt32 rightPoly);
+    virtual bool    writeAggLevel(UInt32 level, UInt32 numCoarse,
+                        const UInt32Array1 &fineToCoarse);
+
+    virtual void    errorMsg(const char *msg);
+    virtual void    warningMsg(const char *msg);
+
+private:
+
+    std::FILE * fp_;
+    int         digits_;
+};
+
+#endif // _DUALMESHTCLWRITER_H_
@@ -0,0 +1,328 @@
+/****************************************************************************
+ *
+ * class DualMeshVtuWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+#include "DualMeshVtuWriter.h"
+
+// The appended block headers hold the block byte count as a UInt64
+typedef unsigned long long  BlockHeader;
+
+// VTK_POLYGON cell type
+static const unsigned char VtkPolygon = 7;
+
+// Number of points converted per fwrite() in single precision mode
+static const size_t PointChunk = 4096;
+
+
+static const char *
+byteOrder()
+{
+    const UInt32 one = 1;
+    return (1 == *reinterpret_cast<const unsigned char*>(&one)) ?
+        "LittleEndian" : "BigEndian";
+}
+
+
+// Writes one appended DataArray element and advances offset past its block.
+// numTuples is only written for FieldData arrays.
+static bool
+writeArrayTag(std::FILE *fp, const char *type, const char *name,
+    int numComponents, size_t numBytes, BlockHeader &offset,
+    size_t numTuples = 0)
+{
+    bool ret = (0 < fprintf(fp, "        <DataArray type=\"%s\"", type));
+    if (ret && (0 != name)) {
+        ret = (0 < fprintf(fp, " Name=\"%s\"", name));
+    }
+    if (ret && (1 != numComponents)) {
+        ret = (0 < fprintf(fp, " NumberOfComponents=\"%d\"", numComponents));
+    }
+    if (ret && (0 != numTuples)) {
+        ret = (0 < fprintf(fp, " NumberOfTuples=\"%llu\"",
+            (unsigned long long)numTuples));
+    }
+    ret = ret && (0 < fprintf(fp, " format=\"appended\" offset=\"%llu\"/>\n",
+        offset));
+    offset += sizeof(BlockHeader) + numBytes;
+    return ret;
+}
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualMeshVtuWriter::DualMeshVtuWriter(std::FILE *fp, bool singlePrecision) :
+    fp_(fp),
+    singlePrecision_(singlePrecision),
+    xyz_(),
+    vertTypes_(),
+    polyVerts_(),
+    polyOffsets_(),
+    polyBndry_(),
+    polyGceVerts_(),
+    hasDualEdges_(false),
+    polyEdges_(),
+    edgeVerts_(),
+    edgePolys_(),
+    aggLevels_()
+{
+}
+
+
+DualMeshVtuWriter::~DualMeshVtuWriter()
+{
+}
+
+
+bool
+DualMeshVtuWriter::writeGceVertex(UInt32 gceVertNdx, const Vec3 &v)
+{
+    // primal vertices are not part of the dual grid
+    (void)gceVertNdx;
+    (void)v;
+    return true;
+}
+
+
+bool
+DualMeshVtuWriter::beginCentroids(UInt32 count)
+{
+    xyz_.reserve(3 * size_t(count));
+    vertTypes_.reserve(count);
+    return true;
+}
+
+
+bool
+DualMeshVtuWriter::beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids)
+{
+    const size_t numVerts = vertTypes_.size() + numBndryMids + numCnxnMids;
+    xyz_.reserve(3 * numVerts);
+    vertTypes_.reserve(numVerts);
+    return true;
+}
+
+
+bool
+DualMeshVtuWriter::writeVertex(UInt32 dualNdx, const Vec3 &v, VertType vType)
+{
+    if (dualNdx >= vertTypes_.size()) {
+        xyz_.resize(3 * (size_t(dualNdx) + 1));
+        vertTypes_.resize(size_t(dualNdx) + 1);
+    }
+    double *p = &xyz_[3 * size_t(dualNdx)];
+    p[0] = v[0];
+    p[1] = v[1];
+    p[2] = v[2];
+    vertTypes_[dualNdx] = (unsigned char)vType;
+    return true;
+}
+
+
+bool
+DualMeshVtuWriter::writePoly(UInt32 gceVertNdx, bool isBndry,
+    const UInt32Array1 &dualVerts)
+{
+    polyVerts_.insert(polyVerts_.end(), dualVerts.begin(), dualVerts.end());
+    polyOffsets_.push_back(UInt32(polyVerts_.size()));
+    polyBndry_.push_back(isBndry ? 1 : 0);
+    polyGceVerts_.push_back(gceVertNdx);
+    return true;
+}
+
+
+bool
+DualMeshVtuWriter::writePolyEdges(UInt32 polyNdx,
+    const UInt32Array1 &dualEdges)
+{
+    (void)polyNdx;
+    polyEdges_.insert(polyEdges_.end(), dualEdges.begin(), dualEdges.end());
+    return true;
+}
+
+
+bool
+DualMeshVtuWriter::beginDualEdges(UInt32 count)
+{
+    hasDualEdges_ = true;
+    edgeVerts_.reserve(2 * size_t(count));
+    edgePolys_.reserve(2 * size_t(count));
+    return true;
+}
+
+
+bool
+DualMeshVtuWriter::writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+    UInt32 leftPoly, UInt32 rightPoly)
+{
+    (void)edgeNdx;
+    edgeVerts_.push_back(dualVerts[0]);
+    edgeVerts_.push_back(dualVerts[1]);
+    edgePolys_.push_back(leftPoly);
+    edgePolys_.push_back(rightPoly);
+    return true;
+}
+
+
+bool
+DualMeshVtuWriter::writeAggLevel(UInt32 level, UInt32 numCoarse,
+    const UInt32Array1 &fineToCoarse)
+{
+    (void)numCoarse;
+    if (level > aggLevels_.size()) {
+        aggLevels_.resize(level);
+    }
+    aggLevels_[level - 1] = fineToCoarse;
+    return true;
+}
+
+
+bool
+DualMeshVtuWriter::endMesh()
+{
+    const size_t numPoints = vertTypes_.size();
+    const size_t numCells = polyOffsets_.size();
+    const size_t numEdges = edgeVerts_.size() / 2;
+    const UInt8Array1 cellTypes(numCells, VtkPolygon);
+    const size_t xyzBytes = 3 * numPoints *
+        (singlePrecision_ ? sizeof(float) : sizeof(double));
+    BlockHeader offset = 0;
+    bool ret = (0 < fprintf(fp_, "<?xml version=\"1.0\"?>\n"
+        "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" "
+        "byte_order=\"%s\" header_type=\"UInt64\">\n"
+        "  <UnstructuredGrid>\n", byteOrder()));
+    const bool hasFieldData = hasDualEdges_ || !aggLevels_.empty();
+    if (ret && hasFieldData) {
+        ret = (EOF != fputs("    <FieldData>\n", fp_));
+    }
+    if (ret && hasDualEdges_) {
+        ret = writeArrayTag(fp_, "UInt32", "DualEdgeVerts", 2,
+                edgeVerts_.size() * sizeof(UInt32), offset, numEdges) &&
+            writeArrayTag(fp_, "UInt32", "DualEdgePolys", 2,
+                edgePolys_.size() * sizeof(UInt32), offset, numEdges) &&
+            writeArrayTag(fp_, "UInt32", "PolyEdges", 1,
+                polyEdges_.size() * sizeof(UInt32), offset,
+                polyEdges_.size());
+    }
+    for (size_t ii = 0; ret && (ii < aggLevels_.size()); ++ii) {
+        char name[32];
+        sprintf(name, "AggLevel%u", UInt32(ii + 1));
+        ret = writeArrayTag(fp_, "UInt32", name, 1,
+            aggLevels_[ii].size() * sizeof(UInt32), offset,
+            aggLevels_[ii].size());
+    }
+    if (ret && hasFieldData) {
+        ret = (EOF != fputs("    </FieldData>\n", fp_));
+    }
+    ret = ret && (0 < fprintf(fp_,
+        "    <Piece NumberOfPoints=\"%llu\" NumberOfCells=\"%llu\">\n"
+        "      <PointData Scalars=\"VertType\">\n",
+        (unsigned long long)numPoints, (unsigned long long)numCells)) &&
+        writeArrayTag(fp_, "UInt8", "VertType", 1, numPoints, offset) &&
+        (EOF != fputs("      </PointData>\n"
+            "      <CellData Scalars=\"BndryPoly\">\n", fp_)) &&
+        writeArrayTag(fp_, "UInt8", "BndryPoly", 1, numCells, offset) &&
+        writeArrayTag(fp_, "UInt32", "GceVertex", 1, numCells * sizeof(UInt32),
+            offset) &&
+        (EOF != fputs("      </CellData>\n      <Points>\n", fp_)) &&
+        writeArrayTag(fp_, singlePrecision_ ? "Float32" : "Float64", 0, 3,
+            xyzBytes, offset) &&
+        (EOF != fputs("      </Points>\n      <Cells>\n", fp_)) &&
+        writeArrayTag(fp_, "UInt32", "connectivity", 1,
+            polyVerts_.size() * sizeof(UInt32), offset) &&
+        writeArrayTag(fp_, "UInt32", "offsets", 1, numCells * sizeof(UInt32),
+            offset) &&
+        writeArrayTag(fp_, "UInt8", "types", 1, numCells, offset) &&
+        (EOF != fputs("      </Cells>\n    </Piece>\n  </UnstructuredGrid>\n"
+            "  <AppendedData encoding=\"raw\">\n   _", fp_));
+
+    // blocks must be written in the same order as the DataArray tags above
+    if (ret && hasDualEdges_) {
+        ret = writeBlock(edgeVerts_.empty() ? 0 : &edgeVerts_[0],
+                edgeVerts_.size() * sizeof(UInt32)) &&
+            writeBlock(edgePolys_.empty() ? 0 : &edgePolys_[0],
+                edgePolys_.size() * sizeof(UInt32)) &&
+            writeBlock(polyEdges_.empty() ? 0 : &polyEdges_[0],
+                polyEdges_.size() * sizeof(UInt32));
+    }
+    for (size_t ii = 0; ret && (ii < aggLevels_.size()); ++ii) {
+        ret = writeBlock(aggLevels_[ii].empty() ? 0 : &aggLevels_[ii][0],
+            aggLevels_[ii].size() * sizeof(UInt32));
+    }
+    ret = ret && writeBlock(vertTypes_.empty() ? 0 : &vertTypes_[0],
+            numPoints) &&
+        writeBlock(polyBndry_.empty() ? 0 : &polyBndry_[0], numCells) &&
+        writeBlock(polyGceVerts_.empty() ? 0 : &polyGceVerts_[0],
+            numCells * sizeof(UInt32)) &&
+        writePointsBlock() &&
+        writeBlock(polyVerts_.empty() ? 0 : &polyVerts_[0],
+            polyVerts_.size() * sizeof(UInt32)) &&
+        writeBlock(polyOffsets_.empty() ? 0 : &polyOffsets_[0],
+            numCells * sizeof(UInt32)) &&
+        writeBlock(cellTypes.empty() ? 0 : &cellTypes[0], numCells) &&
+        (EOF != fputs("\n  </AppendedData>\n</VTKFile>\n", fp_));
+    return ret;
+}
+
+
+bool
+DualMeshVtuWriter::writeBlock(const void *data, size_t numBytes)
+{
+    const BlockHeader header = numBytes;
+    return (1 == fwrite(&header, sizeof(header), 1, fp_)) &&
+        ((0 == numBytes) || (1 == fwrite(data, numBytes, 1, fp_)));
+}
+
+
+bool
+DualMeshVtuWriter::writePointsBlock()
+{
+    if (!singlePrecision_) {
+        return writeBlock(xyz_.empty() ? 0 : &xyz_[0],
+            xyz_.size() * sizeof(double));
+    }
+    const BlockHeader header = xyz_.size() * sizeof(float);
+    bool ret = (1 == fwrite(&header, sizeof(header), 1, fp_));
+    float buf[3 * PointChunk];
+    for (size_t ii = 0; ret && (ii < xyz_.size()); ii += 3 * PointChunk) {
+        const size_t num = (xyz_.size() - ii < 3 * PointChunk) ?
+            xyz_.size() - ii : 3 * PointChunk;
+        for (size_t jj = 0; jj < num; ++jj) {
+            buf[jj] = float(xyz_[ii + jj]);
+        }
+        ret = (num == fwrite(buf, sizeof(float), num, fp_));
+    }
+    return ret;
+}
+
+
+void
+DualMeshVtuWriter::errorMsg(const char *msg)
+{
+    fprintf(stderr, "error: %s\n", msg);
+}
+
+
+void
+DualMeshVtuWriter::warningMsg(const char *msg)
+{
+    fprintf(stderr, "warning: %s\n", msg);
+}
+
+
+bool
+DualMeshVtuWriter::isVtuFileName(const char *filename)
+{
+    return hasFileExt(filename, ".vtu");
+}
@@ -0,0 +1,115 @@
+/****************************************************************************
+ *
+ * class DualMeshVtuWriter
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALMESHVTUWRITER_H_
+#define _DUALMESHVTUWRITER_H_
+
+#include <cstdio>
+
+#include "DualMeshSink.h"
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Writes the dual mesh as a VTK XML unstructured grid (.vtu) to a stdio
+    FILE opened in binary mode.
+
+    The dual vertices become the grid points and the dual polygons become
+    VTK_POLYGON cells. All arrays are stored as appended raw binary data in
+    the native byte order. Besides the points and cells, the file has:
+      PointData VertType   UInt8, the DualMeshSink::VertType of the point
+                           (0=Bndry 1=Elem 2=Cnxn 3=Gce)
+      CellData  BndryPoly  UInt8, 1 for a boundary (B) polygon, 0 for an
+                           interior (I) polygon
+      CellData  GceVertex  UInt32, the primal vertex of the polygon
+
+    If the dual edges are written, the grid also has these FieldData arrays:
+      DualEdgeVerts   UInt32[2] per dual edge, the dual vertices
+      DualEdgePolys   UInt32[2] per dual edge, the left and right polygons.
+                      The right polygon is 4294967295 for boundary edges.
+      PolyEdges       UInt32, the dual edge of each polygon side. Uses the
+                      same offsets as the cell connectivity.
+
+    Agglomeration level k is written as the FieldData array AggLevel<k>
+    that maps each node of level k-1 (the cells for k = 1) to its level k
+    node.
+
+    The points and polygons are buffered and written by endMesh().
+*/
+class DualMeshVtuWriter : public DualMeshSink {
+public:
+
+    DualMeshVtuWriter(std::FILE *fp, bool singlePrecision = false);
+    virtual ~DualMeshVtuWriter();
+
+    virtual bool    writeGceVertex(UInt32 gceVertNdx, const Vec3 &v);
+    virtual bool    beginCentroids(UInt32 count);
+    virtual bool    beginHardMids(UInt32 numBndryMids, UInt32 numCnxnMids);
+    virtual bool    writeVertex(UInt32 dualNdx, const Vec3 &v,
+                        VertType vType);
+    virtual bool    writePoly(UInt32 gceVertNdx, bool isBndry,
+                        const UInt32Array1 &dualVerts);
+    virtual bool    writePolyEdges(UInt32 polyNdx,
+                        const UInt32Array1 &dualEdges);
+    virtual bool    beginDualEdges(UInt32 count);
+    virtual bool    writeDualEdge(UInt32 edgeNdx, const Edge &dualVerts,
+                        UInt32 leftPoly, UInt32 rightPoly);
+    virtual bool    writeAggLevel(UInt32 level, UInt32 numCoarse,
+                        const UInt32Array1 &fineToCoarse);
+    virtual bool    endMesh();
+
+    virtual void    errorMsg(const char *msg);
+    virtual void    warningMsg(const char *msg);
+
+    //! Returns true if filename ends with ".vtu" (case insensitive)
+    static bool     isVtuFileName(const char *filename);
+
+private:
+
+    bool    writeBlock(const void *data, size_t numBytes);
+    bool    writePointsBlock();
+
+private:
+
+    std::FILE *     fp_;
+    bool            singlePrecision_;
+
+    //! The dual vertex xyz values. 3 per vertex.
+    DoubleArray1    xyz_;
+
+    //! The dual vertex VertType values
+    UInt8Array1     vertTypes_;
+
+    //! The polygon dual vertices and end offsets into polyVerts_
+    UInt32Array1    polyVerts_;
+    UInt32Array1    polyOffsets_;
+
+    //! Per polygon BndryPoly flag and primal vertex
+    UInt8Array1     polyBndry_;
+    UInt32Array1    polyGceVerts_;
+
+    //! True if the dual edges were written
+    bool            hasDualEdges_;
+
+    //! The dual edge of each polygon side. Parallel to polyVerts_.
+    UInt32Array1    polyEdges_;
+
+    //! Per dual edge, 2 dual vertices and the left/right polygons
+    UInt32Array1    edgeVerts_;
+    UInt32Array1    edgePolys_;
+
+    //! The fine-to-coarse map of each agglomeration level
+    UInt32Array2    aggLevels_;
+};
+
+#endif // _DUALMESHVTUWRITER_H_
@@ -0,0 +1,92 @@
+/****************************************************************************
+ *
+ * class DualPartitioner
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+
+#include "DualPartitioner.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+namespace {
+
+//! Orders point indices by one coordinate, then by index
+struct AxisLess {
+    const double *  xyz_;
+    int             axis_;
+
+    bool operator()(UInt32 lhs, UInt32 rhs) const {
+        const double a = xyz_[3 * size_t(lhs) + axis_];
+        const double b = xyz_[3 * size_t(rhs) + axis_];
+        return (a < b) || ((a == b) && (lhs < rhs));
+    }
+};
+
+} // namespace
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+void
+DualPartitioner::rcb(const double *xyz, UInt32 numPoints, UInt32 numParts,
+    UInt32Array1 &parts)
+{
+    parts.assign(numPoints, 0);
+    if ((numParts < 2) || (0 == numPoints)) {
+        return;
+    }
+    UInt32Array1 points(numPoints);
+    for (UInt32 ii = 0; ii < numPoints; ++ii) {
+        points[ii] = ii;
+    }
+    split(xyz, &points[0], numPoints, 0, numParts, parts);
+}
+
+
+void
+DualPartitioner::split(const double *xyz, UInt32 *points, UInt32 numPoints,
+    UInt32 firstPart, UInt32 numParts, UInt32Array1 &parts)
+{
+    if ((1 == numParts) || (0 == numPoints)) {
+        for (UInt32 ii = 0; ii < numPoints; ++ii) {
+            parts[points[ii]] = firstPart;
+        }
+        return;
+    }
+    double box[6] = { xyz[3 * size_t(points[0])],
+        xyz[3 * size_t(points[0]) + 1], xyz[3 * size_t(points[0]) + 2] };
+    box[3] = box[0];
+    box[4] = box[1];
+    box[5] = box[2];
+    for (UInt32 ii = 1; ii < numPoints; ++ii) {
+        const double *p = &xyz[3 * size_t(points[ii])];
+        for (int jj = 0; jj < 3; ++jj) {
+            box[jj] = std::min(box[jj], p[jj]);
+            box[jj + 3] = std::max(box[jj + 3], p[jj]);
+        }
+    }
+    AxisLess less = { xyz, 0 };
+    for (int jj = 1; jj < 3; ++jj) {
+        if (box[jj + 3] - box[jj] > box[less.axis_ + 3] - box[less.axis_]) {
+            less.axis_ = jj;
+        }
+    }
+    const UInt32 numLoParts = numParts / 2;
+    const UInt32 numLo = UInt32((unsigned long long)numPoints * numLoParts /
+        numParts);
+    std::nth_element(points, points + numLo, points + numPoints, less);
+    split(xyz, points, numLo, firstPart, numLoParts, parts);
+    split(xyz, points + numLo, numPoints - numLo, firstPart + numLoParts,
+        numParts - numLoParts, parts);
+}
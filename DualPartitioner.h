@@ -0,0 +1,44 @@
+/****************************************************************************
+ *
+ * class DualPartitioner
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALPARTITIONER_H_
+#define _DUALPARTITIONER_H_
+
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Splits points into parts by recursive coordinate bisection.
+
+    Each level splits the points of a range of parts at the median of the
+    longest axis of their bounding box. The number of parts does not have to
+    be a power of 2. A range of k parts is split into k/2 and k - k/2 parts
+    with the points split in the same ratio, so all parts end up with the
+    same number of points, give or take one. Ties are broken by point index
+    so the result does not depend on the std::nth_element implementation.
+*/
+class DualPartitioner {
+public:
+
+    //! Sets parts[ii] to the part of point ii for the numPoints xyz (3 per
+    //! point).
+    static void rcb(const double *xyz, UInt32 numPoints, UInt32 numParts,
+                    UInt32Array1 &parts);
+
+private:
+
+    static void split(const double *xyz, UInt32 *points, UInt32 numPoints,
+                    UInt32 firstPart, UInt32 numParts, UInt32Array1 &parts);
+};
+
+#endif // _DUALPARTITIONER_H_
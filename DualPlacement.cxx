@@ -0,0 +1,523 @@
+/****************************************************************************
+ *
+ * class DualPlacement
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <cmath>
+#include <cstring>
+
+#include "DualPlacement.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+namespace {
+
+//! Number of tris or hard mids processed per kernel batch. Sized so a
+//! batch's scratch arrays stay in L1/L2 cache.
+enum { BatchSize = 256 };
+
+/*! Structure-of-arrays scratch storage for BatchSize points. The kernels are
+    specialized on Dim. A Dim 2 batch is for a planar mesh. It has no z
+    storage and its points get the mesh's plane z when stored.
+*/
+template<int Dim>
+struct PtBatch {
+    double x[BatchSize];
+    double y[BatchSize];
+    double z[BatchSize];
+};
+
+template<>
+struct PtBatch<2> {
+    double x[BatchSize];
+    double y[BatchSize];
+};
+
+
+template<int Dim>
+inline void
+loadPt(const double *xyz, PtBatch<Dim> &b, UInt32 ii)
+{
+    b.x[ii] = xyz[0];
+    b.y[ii] = xyz[1];
+    b.z[ii] = xyz[2];
+}
+
+
+template<>
+inline void
+loadPt(const double *xyz, PtBatch<2> &b, UInt32 ii)
+{
+    b.x[ii] = xyz[0];
+    b.y[ii] = xyz[1];
+}
+
+
+template<int Dim>
+inline void
+zeroPt(PtBatch<Dim> &b, UInt32 ii)
+{
+    b.x[ii] = b.y[ii] = b.z[ii] = 0.0;
+}
+
+
+template<>
+inline void
+zeroPt(PtBatch<2> &b, UInt32 ii)
+{
+    b.x[ii] = b.y[ii] = 0.0;
+}
+
+
+template<int Dim>
+void
+storePts(const PtBatch<Dim> &b, UInt32 cnt, double, double *out)
+{
+    for (UInt32 ii = 0; ii < cnt; ++ii) {
+        out[3 * ii + 0] = b.x[ii];
+        out[3 * ii + 1] = b.y[ii];
+        out[3 * ii + 2] = b.z[ii];
+    }
+}
+
+
+template<>
+void
+storePts(const PtBatch<2> &b, UInt32 cnt, double planeZ, double *out)
+{
+    for (UInt32 ii = 0; ii < cnt; ++ii) {
+        out[3 * ii + 0] = b.x[ii];
+        out[3 * ii + 1] = b.y[ii];
+        out[3 * ii + 2] = planeZ;
+    }
+}
+
+
+//! Gathers the corners of tris [first, first+cnt) into p[0..2].
+template<int Dim>
+bool
+gatherTris(const TriMesh &mesh, UInt32 first, UInt32 cnt, PtBatch<Dim> p[3])
+{
+    bool ret = true;
+    const UInt32 numVerts = mesh.vertexCount();
+    for (UInt32 ii = 0; ii < cnt; ++ii) {
+        const UInt32 *tri = mesh.tri(first + ii);
+        for (UInt32 k = 0; k < 3; ++k) {
+            if (tri[k] < numVerts) {
+                loadPt(mesh.xyz(tri[k]), p[k], ii);
+            }
+            else {
+                zeroPt(p[k], ii);
+                ret = false;
+            }
+        }
+    }
+    return ret;
+}
+
+
+template<int Dim>
+void
+centroidKernel(const PtBatch<Dim> p[3], UInt32 cnt, PtBatch<Dim> &out)
+{
+    for (UInt32 ii = 0; ii < cnt; ++ii) {
+        out.x[ii] = (p[0].x[ii] + p[1].x[ii] + p[2].x[ii]) / 3.0;
+        out.y[ii] = (p[0].y[ii] + p[1].y[ii] + p[2].y[ii]) / 3.0;
+        out.z[ii] = (p[0].z[ii] + p[1].z[ii] + p[2].z[ii]) / 3.0;
+    }
+}
+
+
+template<>
+void
+centroidKernel(const PtBatch<2> p[3], UInt32 cnt, PtBatch<2> &out)
+{
+    for (UInt32 ii = 0; ii < cnt; ++ii) {
+        out.x[ii] = (p[0].x[ii] + p[1].x[ii] + p[2].x[ii]) / 3.0;
+        out.y[ii] = (p[0].y[ii] + p[1].y[ii] + p[2].y[ii]) / 3.0;
+    }
+}
+
+
+template<int Dim>
+void
+clippedCircumcenterKernel(const PtBatch<Dim> p[3], UInt32 cnt,
+    PtBatch<Dim> &out)
+{
+    const PtBatch<Dim> &a = p[0];
+    const PtBatch<Dim> &b = p[1];
+    const PtBatch<Dim> &c = p[2];
+    for (UInt32 ii = 0; ii < cnt; ++ii) {
+        // u = b - a, v = c - a, e = c - b, w = u x v
+        const double ux = b.x[ii] - a.x[ii];
+        const double uy = b.y[ii] - a.y[ii];
+        const double uz = b.z[ii] - a.z[ii];
+        const double vx = c.x[ii] - a.x[ii];
+        const double vy = c.y[ii] - a.y[ii];
+        const double vz = c.z[ii] - a.z[ii];
+        const double ex = c.x[ii] - b.x[ii];
+        const double ey = c.y[ii] - b.y[ii];
+        const double ez = c.z[ii] - b.z[ii];
+        const double wx = uy * vz - uz * vy;
+        const double wy = uz * vx - ux * vz;
+        const double wz = ux * vy - uy * vx;
+        const double uu = ux * ux + uy * uy + uz * uz;
+        const double vv = vx * vx + vy * vy + vz * vz;
+        const double ww = wx * wx + wy * wy + wz * wz;
+        // circumcenter = a + ((uu v - vv u) x w) / (2 ww)
+        const bool degen = (ww <= 1.0e-12 * uu * vv);
+        const double s = degen ? 0.0 : 0.5 / ww;
+        const double tx = uu * vx - vv * ux;
+        const double ty = uu * vy - vv * uy;
+        const double tz = uu * vz - vv * uz;
+        double x = a.x[ii] + (ty * wz - tz * wy) * s;
+        double y = a.y[ii] + (tz * wx - tx * wz) * s;
+        double z = a.z[ii] + (tx * wy - ty * wx) * s;
+        // An obtuse tri's circumcenter is outside the tri. Clip it to the
+        // mid point of the edge opposite the obtuse corner.
+        const bool obtuseA = (ux * vx + uy * vy + uz * vz) < 0.0;
+        const bool obtuseB = (ux * ex + uy * ey + uz * ez) > 0.0;
+        const bool obtuseC = (vx * ex + vy * ey + vz * ez) < 0.0;
+        x = obtuseA ? 0.5 * (b.x[ii] + c.x[ii]) : x;
+        y = obtuseA ? 0.5 * (b.y[ii] + c.y[ii]) : y;
+        z = obtuseA ? 0.5 * (b.z[ii] + c.z[ii]) : z;
+        x = obtuseB ? 0.5 * (a.x[ii] + c.x[ii]) : x;
+        y = obtuseB ? 0.5 * (a.y[ii] + c.y[ii]) : y;
+        z = obtuseB ? 0.5 * (a.z[ii] + c.z[ii]) : z;
+        x = obtuseC ? 0.5 * (a.x[ii] + b.x[ii]) : x;
+        y = obtuseC ? 0.5 * (a.y[ii] + b.y[ii]) : y;
+        z = obtuseC ? 0.5 * (a.z[ii] + b.z[ii]) : z;
+        // A degenerate tri has no circumcenter. Use its centroid.
+        out.x[ii] = degen ? (a.x[ii] + b.x[ii] + c.x[ii]) / 3.0 : x;
+        out.y[ii] = degen ? (a.y[ii] + b.y[ii] + c.y[ii]) / 3.0 : y;
+        out.z[ii] = degen ? (a.z[ii] + b.z[ii] + c.z[ii]) / 3.0 : z;
+    }
+}
+
+
+template<>
+void
+clippedCircumcenterKernel(const PtBatch<2> p[3], UInt32 cnt, PtBatch<2> &out)
+{
+    const PtBatch<2> &a = p[0];
+    const PtBatch<2> &b = p[1];
+    const PtBatch<2> &c = p[2];
+    for (UInt32 ii = 0; ii < cnt; ++ii) {
+        // As the 3D kernel with w = (0, 0, wz)
+        const double ux = b.x[ii] - a.x[ii];
+        const double uy = b.y[ii] - a.y[ii];
+        const double vx = c.x[ii] - a.x[ii];
+        const double vy = c.y[ii] - a.y[ii];
+        const double ex = c.x[ii] - b.x[ii];
+        const double ey = c.y[ii] - b.y[ii];
+        const double wz = ux * vy - uy * vx;
+        const double uu = ux * ux + uy * uy;
+        const double vv = vx * vx + vy * vy;
+        const double ww = wz * wz;
+        const bool degen = (ww <= 1.0e-12 * uu * vv);
+        const double s = degen ? 0.0 : 0.5 / ww;
+        const double tx = uu * vx - vv * ux;
+        const double ty = uu * vy - vv * uy;
+        double x = a.x[ii] + (ty * wz) * s;
+        double y = a.y[ii] + (-tx * wz) * s;
+        const bool obtuseA = (ux * vx + uy * vy) < 0.0;
+        const bool obtuseB = (ux * ex + uy * ey) > 0.0;
+        const bool obtuseC = (vx * ex + vy * ey) < 0.0;
+        x = obtuseA ? 0.5 * (b.x[ii] + c.x[ii]) : x;
+        y = obtuseA ? 0.5 * (b.y[ii] + c.y[ii]) : y;
+        x = obtuseB ? 0.5 * (a.x[ii] + c.x[ii]) : x;
+        y = obtuseB ? 0.5 * (a.y[ii] + c.y[ii]) : y;
+        x = obtuseC ? 0.5 * (a.x[ii] + b.x[ii]) : x;
+        y = obtuseC ? 0.5 * (a.y[ii] + b.y[ii]) : y;
+        out.x[ii] = degen ? (a.x[ii] + b.x[ii] + c.x[ii]) / 3.0 : x;
+        out.y[ii] = degen ? (a.y[ii] + b.y[ii] + c.y[ii]) / 3.0 : y;
+    }
+}
+
+
+double
+triArea(const TriMesh &mesh, UInt32 cellNdx)
+{
+    Vec3 a;
+    Vec3 b;
+    Vec3 c;
+    double ret = 0.0;
+    if (cellNdx < mesh.triCount()) {
+        const UInt32 *tri = mesh.tri(cellNdx);
+        if (mesh.getCoord(tri[0], a) && mesh.getCoord(tri[1], b) &&
+                mesh.getCoord(tri[2], c)) {
+            if (mesh.isPlanar()) {
+                ret = 0.5 * std::fabs((b[0] - a[0]) * (c[1] - a[1]) -
+                    (b[1] - a[1]) * (c[0] - a[0]));
+            }
+            else {
+                ret = 0.5 * cml::cross(b - a, c - a).length();
+            }
+        }
+    }
+    return ret;
+}
+
+
+/*! Projects pt onto the edge segment (v0, v1). The result is clamped to the
+    segment end points. If atMid is true, the edge mid point is used instead.
+    z is not set for Dim 2.
+*/
+template<int Dim>
+inline void
+projectToEdge(const PtBatch<Dim> &v0, const PtBatch<Dim> &v1,
+    const PtBatch<Dim> &pt, bool atMid, UInt32 ii, double &x, double &y,
+    double &z)
+{
+    const double dx = v1.x[ii] - v0.x[ii];
+    const double dy = v1.y[ii] - v0.y[ii];
+    const double dz = v1.z[ii] - v0.z[ii];
+    const double lenSq = dx * dx + dy * dy + dz * dz;
+    const double dot = (pt.x[ii] - v0.x[ii]) * dx +
+        (pt.y[ii] - v0.y[ii]) * dy + (pt.z[ii] - v0.z[ii]) * dz;
+    // v0 == v1 if lenSq is tiny
+    const bool degen = (lenSq < 1.0e-8);
+    double t = (degen ? 0.0 : dot) / (degen ? 1.0 : lenSq);
+    t = atMid ? 0.5 : t;
+    x = v0.x[ii] + t * dx;
+    y = v0.y[ii] + t * dy;
+    z = v0.z[ii] + t * dz;
+    // Beyond the 'v0' end of the segment
+    x = (t < 0.0) ? v0.x[ii] : x;
+    y = (t < 0.0) ? v0.y[ii] : y;
+    z = (t < 0.0) ? v0.z[ii] : z;
+    // Beyond the 'v1' end of the segment
+    x = (t > 1.0) ? v1.x[ii] : x;
+    y = (t > 1.0) ? v1.y[ii] : y;
+    z = (t > 1.0) ? v1.z[ii] : z;
+}
+
+
+template<>
+inline void
+projectToEdge(const PtBatch<2> &v0, const PtBatch<2> &v1, const PtBatch<2> &pt,
+    bool atMid, UInt32 ii, double &x, double &y, double &)
+{
+    const double dx = v1.x[ii] - v0.x[ii];
+    const double dy = v1.y[ii] - v0.y[ii];
+    const double lenSq = dx * dx + dy * dy;
+    const double dot = (pt.x[ii] - v0.x[ii]) * dx +
+        (pt.y[ii] - v0.y[ii]) * dy;
+    const bool degen = (lenSq < 1.0e-8);
+    double t = (degen ? 0.0 : dot) / (degen ? 1.0 : lenSq);
+    t = atMid ? 0.5 : t;
+    x = v0.x[ii] + t * dx;
+    y = v0.y[ii] + t * dy;
+    x = (t < 0.0) ? v0.x[ii] : x;
+    y = (t < 0.0) ? v0.y[ii] : y;
+    x = (t > 1.0) ? v1.x[ii] : x;
+    y = (t > 1.0) ? v1.y[ii] : y;
+}
+
+
+template<int Dim>
+inline void
+blendZ(PtBatch<Dim> &out, UInt32 ii, double wOwn, double z0, double z1)
+{
+    out.z[ii] = wOwn * z0 + (1.0 - wOwn) * z1;
+}
+
+
+//! A planar batch has no z to blend
+template<>
+inline void
+blendZ(PtBatch<2> &, UInt32, double, double, double)
+{
+}
+
+
+template<int Dim>
+bool
+placeElemVertsKernel(const TriMesh &mesh, DualPlacement::Strategy strategy,
+    double *elemXyz)
+{
+    bool ret = true;
+    PtBatch<Dim> corners[3];
+    PtBatch<Dim> out;
+    const UInt32 numTris = mesh.triCount();
+    for (UInt32 first = 0; first < numTris; first += BatchSize) {
+        const UInt32 cnt = (numTris - first < UInt32(BatchSize)) ?
+            (numTris - first) : UInt32(BatchSize);
+        if (!gatherTris(mesh, first, cnt, corners)) {
+            ret = false;
+        }
+        switch (strategy) {
+        case DualPlacement::Circumcenter:
+            clippedCircumcenterKernel(corners, cnt, out);
+            break;
+        case DualPlacement::Centroid:
+        case DualPlacement::AreaCentroid:
+        case DualPlacement::EdgeMidpoint:
+        default:
+            centroidKernel(corners, cnt, out);
+            break;
+        }
+        storePts(out, cnt, mesh.planeZ(), elemXyz + 3 * size_t(first));
+    }
+    return ret;
+}
+
+
+template<int Dim>
+bool
+placeHardMidsKernel(const TriMesh &mesh, DualPlacement::Strategy strategy,
+    const double *elemXyz, const HardMid *mids, UInt32 numMids,
+    double *midXyz)
+{
+    bool ret = true;
+    PtBatch<Dim> v0;
+    PtBatch<Dim> v1;
+    PtBatch<Dim> own;
+    PtBatch<Dim> nbr;
+    PtBatch<Dim> out;
+    double wOwn[BatchSize];
+    const bool atMid = (DualPlacement::EdgeMidpoint == strategy);
+    const UInt32 numVerts = mesh.vertexCount();
+    const UInt32 numTris = mesh.triCount();
+    for (UInt32 first = 0; first < numMids; first += BatchSize) {
+        const UInt32 cnt = (numMids - first < UInt32(BatchSize)) ?
+            (numMids - first) : UInt32(BatchSize);
+        // gather
+        for (UInt32 ii = 0; ii < cnt; ++ii) {
+            const HardMid &mid = mids[first + ii];
+            if ((mid.edge_[0] < numVerts) && (mid.edge_[1] < numVerts) &&
+                    (mid.owner_ < numTris)) {
+                loadPt(mesh.xyz(mid.edge_[0]), v0, ii);
+                loadPt(mesh.xyz(mid.edge_[1]), v1, ii);
+                loadPt(elemXyz + 3 * size_t(mid.owner_), own, ii);
+            }
+            else {
+                zeroPt(v0, ii);
+                zeroPt(v1, ii);
+                zeroPt(own, ii);
+                ret = false;
+            }
+            if (UInt32Undef == mid.neighbor_) {
+                // boundary edge, only the owner contributes
+                loadPt(elemXyz + 3 * size_t(mid.owner_ < numTris ?
+                    mid.owner_ : 0), nbr, ii);
+                wOwn[ii] = 1.0;
+            }
+            else if (mid.neighbor_ < numTris) {
+                loadPt(elemXyz + 3 * size_t(mid.neighbor_), nbr, ii);
+                wOwn[ii] = 0.5;
+                if (DualPlacement::AreaCentroid == strategy) {
+                    const double aOwn = triArea(mesh, mid.owner_);
+                    const double aNbr = triArea(mesh, mid.neighbor_);
+                    if (0.0 < aOwn + aNbr) {
+                        wOwn[ii] = aOwn / (aOwn + aNbr);
+                    }
+                }
+            }
+            else {
+                zeroPt(nbr, ii);
+                wOwn[ii] = 1.0;
+                ret = false;
+            }
+        }
+        // project and blend
+        for (UInt32 ii = 0; ii < cnt; ++ii) {
+            double x0;
+            double y0;
+            double z0 = 0.0;
+            double x1;
+            double y1;
+            double z1 = 0.0;
+            projectToEdge(v0, v1, own, atMid, ii, x0, y0, z0);
+            projectToEdge(v0, v1, nbr, atMid, ii, x1, y1, z1);
+            const double w1 = 1.0 - wOwn[ii];
+            out.x[ii] = wOwn[ii] * x0 + w1 * x1;
+            out.y[ii] = wOwn[ii] * y0 + w1 * y1;
+            blendZ(out, ii, wOwn[ii], z0, z1);
+        }
+        storePts(out, cnt, mesh.planeZ(), midXyz + 3 * size_t(first));
+    }
+    return ret;
+}
+
+} // namespace
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+static const char *strategyNames[DualPlacement::NumStrategies] = {
+    "Centroid",
+    "AreaCentroid",
+    "Circumcenter",
+    "EdgeMidpoint"
+};
+
+
+DualPlacement::DualPlacement(Strategy strategy) :
+    strategy_(strategy)
+{
+}
+
+
+DualPlacement::~DualPlacement()
+{
+}
+
+
+bool
+DualPlacement::placeElemVerts(const TriMesh &mesh, double *elemXyz) const
+{
+    return mesh.isPlanar() ? placeElemVertsKernel<2>(mesh, strategy_, elemXyz) :
+        placeElemVertsKernel<3>(mesh, strategy_, elemXyz);
+}
+
+
+bool
+DualPlacement::placeHardMids(const TriMesh &mesh, const double *elemXyz,
+    const HardMid *mids, UInt32 numMids, double *midXyz) const
+{
+    return mesh.isPlanar() ?
+        placeHardMidsKernel<2>(mesh, strategy_, elemXyz, mids, numMids,
+            midXyz) :
+        placeHardMidsKernel<3>(mesh, strategy_, elemXyz, mids, numMids,
+            midXyz);
+}
+
+
+const char *
+DualPlacement::name(Strategy strategy)
+{
+    return (strategy < NumStrategies) ? strategyNames[strategy] : "";
+}
+
+
+bool
+DualPlacement::fromName(const char *name, Strategy &strategy)
+{
+    bool ret = false;
+    for (int ii = 0; (0 != name) && (ii < NumStrategies); ++ii) {
+        if (0 == strcmp(name, strategyNames[ii])) {
+            strategy = Strategy(ii);
+            ret = true;
+            break;
+        }
+    }
+    return ret;
+}
+
+
+const char *
+DualPlacement::enumNames()
+{
+    return "Centroid|AreaCentroid|Circumcenter|EdgeMidpoint";
+}
@@ -0,0 +1,108 @@
+/****************************************************************************
+ *
+ * class DualPlacement
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALPLACEMENT_H_
+#define _DUALPLACEMENT_H_
+
+#include "PluginTypes.h"
+#include "TriMesh.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+//! A boundary or connection edge and the cells that share it.
+struct HardMid {
+    Edge    edge_;
+    UInt32  owner_;
+    UInt32  neighbor_;  // UInt32Undef if a boundary edge
+};
+typedef std::vector<HardMid, DUAL_ALLOCATOR(HardMid)> HardMidArray1;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Computes the dual vertex locations.
+
+    The placement kernels process the flat TriMesh arrays in fixed size
+    batches. Each batch is gathered into structure-of-arrays scratch storage
+    and evaluated with straight line, branch free loops the compiler can
+    vectorize. The kernels are specialized for a planar mesh
+    (TriMesh::isPlanar()). They gather and compute only x and y and store
+    the plane's z.
+
+    Strategies:
+      Centroid      Tri vertex average. Hard edge points are the owner
+                    centroid projected onto the edge, clamped to the edge
+                    end points. Connection points average the owner and
+                    neighbor projections.
+      AreaCentroid  As Centroid, but connection points weight the owner and
+                    neighbor projections by cell area. For tris the area
+                    centroid equals the vertex average.
+      Circumcenter  Tri circumcenter. If the tri is obtuse, the circumcenter
+                    is clipped to the mid point of the longest edge. Hard
+                    edge points are the clipped circumcenters projected onto
+                    the edge.
+      EdgeMidpoint  Tri vertex average. Hard edge points are the edge mid
+                    points.
+*/
+class DualPlacement {
+public:
+
+    enum Strategy {
+        Centroid,
+        AreaCentroid,
+        Circumcenter,
+        EdgeMidpoint,
+        NumStrategies
+    };
+
+    DualPlacement(Strategy strategy = Centroid);
+    ~DualPlacement();
+
+    inline Strategy
+    strategy() const
+    {
+        return strategy_;
+    }
+
+
+    inline void
+    setStrategy(Strategy strategy)
+    {
+        strategy_ = strategy;
+    }
+
+
+    //! Computes 3 doubles per tri into elemXyz. Returns false if a tri has
+    //! an invalid vertex index.
+    bool        placeElemVerts(const TriMesh &mesh, double *elemXyz) const;
+
+    //! Computes 3 doubles per hard mid into midXyz. elemXyz must hold the
+    //! values from placeElemVerts(). Returns false if a mid has an invalid
+    //! vertex or cell index.
+    bool        placeHardMids(const TriMesh &mesh, const double *elemXyz,
+                    const HardMid *mids, UInt32 numMids, double *midXyz) const;
+
+    static const char * name(Strategy strategy);
+    static bool         fromName(const char *name, Strategy &strategy);
+
+    //! The strategy names formatted as "Name1|Name2|..."
+    static const char * enumNames();
+
+private:
+
+    Strategy    strategy_;
+};
+
+#endif // _DUALPLACEMENT_H_
@@ -0,0 +1,298 @@
+/****************************************************************************
+ *
+ * class DualPolyBvh
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+
+#include "DualPolyBvh.h"
+#include "ParallelFor.h"
+
+static const char FileMagic[] = "DUALBVH1";
+static const UInt32 FileVersion = 1;
+
+// A 30 bit Morton code in the high word and the polygon index in the low
+// word. The keys are unique, so the radix tree is well defined.
+typedef unsigned long long  MortonKey;
+typedef std::vector<MortonKey, DUAL_ALLOCATOR(MortonKey)> MortonKeyArray1;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+namespace {
+
+//! Spreads the low 10 bits of v to every third bit
+inline UInt32
+spreadBits(UInt32 v)
+{
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+
+//! Number of leading bits a and b have in common. 64 if equal.
+inline int
+commonPrefix(MortonKey a, MortonKey b)
+{
+    MortonKey x = a ^ b;
+    if (0 == x) {
+        return 64;
+    }
+    int ret = 0;
+    for (int shift = 32; 0 < shift; shift /= 2) {
+        if (0 == (x >> (64 - shift))) {
+            // the top shift bits are all 0
+            ret += shift;
+            x <<= shift;
+        }
+    }
+    return ret;
+}
+
+
+//! commonPrefix() of keys ii and jj. -1 if jj is out of range.
+inline int
+delta(const MortonKeyArray1 &keys, UInt32 ii, long long jj)
+{
+    return ((jj < 0) || (jj >= (long long)keys.size())) ? -1 :
+        commonPrefix(keys[ii], keys[size_t(jj)]);
+}
+
+
+//! Extends the node bounds by box (min xyz, max xyz)
+inline void
+addBox(DualPolyBvh::Node &node, const float *box)
+{
+    for (int ii = 0; ii < 3; ++ii) {
+        node.lo_[ii] = std::min(node.lo_[ii], box[ii]);
+        node.hi_[ii] = std::max(node.hi_[ii], box[ii + 3]);
+    }
+}
+
+} // namespace
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualPolyBvh::DualPolyBvh() :
+    nodes_(),
+    polys_()
+{
+}
+
+
+DualPolyBvh::~DualPolyBvh()
+{
+}
+
+
+void
+DualPolyBvh::build(const float *boxes, UInt32 numPolys)
+{
+    nodes_.clear();
+    polys_.clear();
+    if (0 == numPolys) {
+        return;
+    }
+
+    // The bounds of the box centers
+    double lo[3] = { boxes[0], boxes[1], boxes[2] };
+    double hi[3] = { boxes[0], boxes[1], boxes[2] };
+    for (UInt32 poly = 0; poly < numPolys; ++poly) {
+        const float *box = &boxes[6 * size_t(poly)];
+        for (int ii = 0; ii < 3; ++ii) {
+            const double c = 0.5 * (double(box[ii]) + double(box[ii + 3]));
+            lo[ii] = std::min(lo[ii], c);
+            hi[ii] = std::max(hi[ii], c);
+        }
+    }
+    double scale[3];
+    for (int ii = 0; ii < 3; ++ii) {
+        // a flat axis (z of a 2D grid) gets code 0
+        scale[ii] = (hi[ii] > lo[ii]) ? 1023.0 / (hi[ii] - lo[ii]) : 0.0;
+    }
+
+    const UInt32 numWorkers = parallelWorkerCount(numPolys);
+    MortonKeyArray1 keys(numPolys);
+    parallelFor(numPolys, numWorkers,
+        [&](UInt32 begin, UInt32 end, UInt32 worker) {
+            (void)worker;
+            for (UInt32 poly = begin; poly < end; ++poly) {
+                const float *box = &boxes[6 * size_t(poly)];
+                UInt32 code = 0;
+                for (int ii = 0; ii < 3; ++ii) {
+                    const double c = 0.5 * (double(box[ii]) +
+                        double(box[ii + 3]));
+                    const UInt32 cell = UInt32((c - lo[ii]) * scale[ii]);
+                    code |= spreadBits(std::min(cell, UInt32(1023))) <<
+                        (2 - ii);
+                }
+                keys[poly] = (MortonKey(code) << 32) | poly;
+            }
+        });
+    std::sort(keys.begin(), keys.end());
+    polys_.resize(numPolys);
+    for (UInt32 ii = 0; ii < numPolys; ++ii) {
+        polys_[ii] = UInt32(keys[ii]);
+    }
+
+    // Internal node ii of the radix tree (Karras 2012) covers a range of
+    // sorted keys that starts or ends at ii. splits[ii] is the last key of
+    // its left child. The child covering [first, split] is internal node
+    // split and the one covering [split + 1, last] is internal node
+    // split + 1.
+    UInt32Array1 splits(numPolys - 1);
+    const UInt32 numInternal = numPolys - 1;
+    parallelFor(numInternal, parallelWorkerCount(numInternal),
+        [&](UInt32 begin, UInt32 end, UInt32 worker) {
+            (void)worker;
+            for (UInt32 node = begin; node < end; ++node) {
+                const long long ii = node;
+                const long long dir = (delta(keys, node, ii + 1) -
+                    delta(keys, node, ii - 1) > 0) ? 1 : -1;
+                const int minPrefix = delta(keys, node, ii - dir);
+                long long maxLen = 2;
+                while (delta(keys, node, ii + maxLen * dir) > minPrefix) {
+                    maxLen *= 2;
+                }
+                long long len = 0;
+                for (long long step = maxLen / 2; 0 < step; step /= 2) {
+                    if (delta(keys, node, ii + (len + step) * dir) >
+                            minPrefix) {
+                        len += step;
+                    }
+                }
+                const long long jj = ii + len * dir;
+                const int nodePrefix = delta(keys, node, jj);
+                long long split = 0;
+                long long step = len;
+                do {
+                    step = (step + 1) / 2;
+                    if (delta(keys, node, ii + (split + step) * dir) >
+                            nodePrefix) {
+                        split += step;
+                    }
+                } while (1 < step);
+                splits[node] = UInt32(ii + split * dir + std::min(dir,
+                    0LL));
+            }
+        });
+
+    flatten(boxes, splits, 0, 0, numPolys - 1);
+}
+
+
+void
+DualPolyBvh::findPolys(const double *pt, UInt32Array1 &polys) const
+{
+    if (nodes_.empty()) {
+        return;
+    }
+    // holds at most one pending right child per tree level
+    UInt32 stack[128];
+    UInt32 top = 0;
+    stack[top++] = 0;
+    while (0 != top) {
+        const Node &node = nodes_[stack[--top]];
+        if ((pt[0] < node.lo_[0]) || (pt[0] > node.hi_[0]) ||
+                (pt[1] < node.lo_[1]) || (pt[1] > node.hi_[1]) ||
+                (pt[2] < node.lo_[2]) || (pt[2] > node.hi_[2])) {
+            continue;
+        }
+        if (0 != node.count_) {
+            polys.insert(polys.end(), polys_.begin() + node.offset_,
+                polys_.begin() + node.offset_ + node.count_);
+        }
+        else {
+            stack[top++] = node.offset_;
+            stack[top++] = UInt32(&node - &nodes_[0]) + 1;
+        }
+    }
+}
+
+
+bool
+DualPolyBvh::save(const char *fileName) const
+{
+    std::FILE *fp = fopen(fileName, "wb");
+    if (0 == fp) {
+        return false;
+    }
+    const UInt32 header[4] = { FileVersion, UInt32(nodes_.size()),
+        UInt32(polys_.size()), MaxLeafPolys };
+    static const char zeros[8] = { 0 };
+    const size_t pad = (polys_.size() % 2) * sizeof(UInt32);
+    bool ret = (1 == fwrite(FileMagic, sizeof(FileMagic) - 1, 1, fp)) &&
+        (1 == fwrite(header, sizeof(header), 1, fp)) &&
+        (nodes_.empty() ||
+            (nodes_.size() == fwrite(&nodes_[0], sizeof(Node), nodes_.size(),
+                fp))) &&
+        (polys_.empty() ||
+            (polys_.size() == fwrite(&polys_[0], sizeof(UInt32),
+                polys_.size(), fp))) &&
+        ((0 == pad) || (1 == fwrite(zeros, pad, 1, fp)));
+    ret = (0 == fclose(fp)) && ret;
+    if (!ret) {
+        remove(fileName);
+    }
+    return ret;
+}
+
+
+const char *
+DualPolyBvh::fileMagic()
+{
+    return FileMagic;
+}
+
+
+UInt32
+DualPolyBvh::flatten(const float *boxes, const UInt32Array1 &splits,
+    UInt32 internal, UInt32 first, UInt32 last)
+{
+    // The recursion depth is bounded by the 64 key bits
+    const UInt32 nodeNdx = UInt32(nodes_.size());
+    nodes_.push_back(Node());
+    Node node;
+    if (last - first < MaxLeafPolys) {
+        const float *box = &boxes[6 * size_t(polys_[first])];
+        std::copy(box, box + 3, node.lo_);
+        std::copy(box + 3, box + 6, node.hi_);
+        for (UInt32 ii = first + 1; ii <= last; ++ii) {
+            addBox(node, &boxes[6 * size_t(polys_[ii])]);
+        }
+        node.offset_ = first;
+        node.count_ = last - first + 1;
+    }
+    else {
+        // internal covers more than MaxLeafPolys keys, so both child ranges
+        // have at least one key. A child with more than one key is an
+        // internal node.
+        const UInt32 split = splits[internal];
+        flatten(boxes, splits, split, first, split);
+        node.offset_ = flatten(boxes, splits, split + 1, split + 1, last);
+        node.count_ = 0;
+        const Node &left = nodes_[nodeNdx + 1];
+        std::copy(left.lo_, left.lo_ + 3, node.lo_);
+        std::copy(left.hi_, left.hi_ + 3, node.hi_);
+        const Node &right = nodes_[node.offset_];
+        const float rightBox[6] = { right.lo_[0], right.lo_[1], right.lo_[2],
+            right.hi_[0], right.hi_[1], right.hi_[2] };
+        addBox(node, rightBox);
+    }
+    nodes_[nodeNdx] = node;
+    return nodeNdx;
+}
@@ -0,0 +1,96 @@
+/****************************************************************************
+ *
+ * class DualPolyBvh
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALPOLYBVH_H_
+#define _DUALPOLYBVH_H_
+
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! A bounding volume hierarchy over the dual polygon bounding boxes.
+
+    The tree is built as a linear BVH. The box centers are sorted by their
+    30 bit Morton code (ties broken by polygon index) and the internal nodes
+    of the binary radix tree over the sorted codes are found in parallel.
+    Subtrees of at most MaxLeafPolys polygons become leaves.
+
+    The nodes are stored flat in depth first order. An internal node's left
+    child is the next node and offset_ is the index of its right child. A
+    leaf's polygons are polys()[offset_ .. offset_ + count_). The node
+    bounds are float and rounded outward, so they contain the double boxes
+    they were built from.
+*/
+class DualPolyBvh {
+public:
+
+    //! 32 bytes. count_ is 0 for an internal node.
+    struct Node {
+        float           lo_[3];
+        float           hi_[3];
+        UInt32          offset_;
+        UInt32          count_;
+    };
+    typedef std::vector<Node, DUAL_ALLOCATOR(Node)> NodeArray1;
+
+    enum {
+        MaxLeafPolys = 4
+    };
+
+    DualPolyBvh();
+    ~DualPolyBvh();
+
+    //! Builds the tree over numPolys boxes. boxes holds 6 floats per
+    //! polygon (min xyz, max xyz).
+    void            build(const float *boxes, UInt32 numPolys);
+
+    //! Appends the polygons of every leaf whose bounds contain pt to polys.
+    //! They include all polygons whose box contains pt. The caller does the
+    //! exact polygon test.
+    void            findPolys(const double *pt, UInt32Array1 &polys) const;
+
+    //! Writes the tree to fileName. See README.md for the layout.
+    bool            save(const char *fileName) const;
+
+    inline const NodeArray1 &
+    nodes() const
+    {
+        return nodes_;
+    }
+
+
+    inline const UInt32Array1 &
+    polys() const
+    {
+        return polys_;
+    }
+
+
+    static const char * fileMagic();
+
+private:
+
+    //! Appends the subtree of the sorted polygons [first, last] and returns
+    //! its root node. internal is the radix tree node of the range.
+    UInt32          flatten(const float *boxes, const UInt32Array1 &splits,
+                        UInt32 internal, UInt32 first, UInt32 last);
+
+private:
+
+    NodeArray1      nodes_;
+
+    //! The polygon indices in Morton order
+    UInt32Array1    polys_;
+};
+
+#endif // _DUALPOLYBVH_H_
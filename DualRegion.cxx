@@ -0,0 +1,173 @@
+/****************************************************************************
+ *
+ * class DualRegion
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <cstdio>
+
+#include "DualMeshBuilder.h"
+#include "DualRegion.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualRegion::DualRegion() :
+    hasBox_(false),
+    boxLo_(),
+    boxHi_(),
+    numBandLayers_(0),
+    verts_()
+{
+}
+
+
+DualRegion::~DualRegion()
+{
+}
+
+
+void
+DualRegion::clear()
+{
+    hasBox_ = false;
+    numBandLayers_ = 0;
+    verts_.clear();
+}
+
+
+bool
+DualRegion::isSet() const
+{
+    return hasBox_ || (0 != numBandLayers_) || !verts_.empty();
+}
+
+
+void
+DualRegion::setBox(const Vec3 &lo, const Vec3 &hi)
+{
+    hasBox_ = true;
+    boxLo_ = lo;
+    boxHi_ = hi;
+}
+
+
+void
+DualRegion::setHardBand(UInt32 numLayers)
+{
+    numBandLayers_ = numLayers;
+}
+
+
+void
+DualRegion::addVerts(const UInt32 *verts, UInt32 count)
+{
+    verts_.insert(verts_.end(), verts, verts + count);
+}
+
+
+void
+DualRegion::select(const TriMesh &mesh, const HardMidArray1 &bndryMids,
+    const HardMidArray1 &cnxnMids, UInt32Array1 &verts) const
+{
+    const UInt32 numVerts = mesh.vertexCount();
+    UInt8Array1 selected(numVerts, 0);
+    UInt32Array1::const_iterator it = verts_.begin();
+    for (; it != verts_.end(); ++it) {
+        if (*it < numVerts) {
+            selected[*it] = 1;
+        }
+    }
+    if (hasBox_) {
+        for (UInt32 ii = 0; ii < numVerts; ++ii) {
+            const double *p = mesh.xyz(ii);
+            if ((p[0] >= boxLo_[0]) && (p[0] <= boxHi_[0]) &&
+                    (p[1] >= boxLo_[1]) && (p[1] <= boxHi_[1]) &&
+                    (p[2] >= boxLo_[2]) && (p[2] <= boxHi_[2])) {
+                selected[ii] = 1;
+            }
+        }
+    }
+    if (0 != numBandLayers_) {
+        selectBand(mesh, bndryMids, cnxnMids, selected);
+    }
+    verts.clear();
+    for (UInt32 ii = 0; ii < numVerts; ++ii) {
+        if (selected[ii]) {
+            verts.push_back(ii);
+        }
+    }
+}
+
+
+bool
+DualRegion::parseBox(const char *str, Vec3 &lo, Vec3 &hi)
+{
+    double v[6];
+    char extra;
+    bool ret = (0 != str) && (6 == sscanf(str, "%lf %lf %lf %lf %lf %lf %c",
+        &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &extra));
+    if (ret) {
+        lo.set(v[0], v[1], v[2]);
+        hi.set(v[3], v[4], v[5]);
+    }
+    return ret;
+}
+
+
+void
+DualRegion::selectBand(const TriMesh &mesh, const HardMidArray1 &bndryMids,
+    const HardMidArray1 &cnxnMids, UInt8Array1 &selected) const
+{
+    // Breadth first search from the hard vertices. front holds the vertices
+    // of the current layer. band marks the vertices already reached.
+    const UInt32 numVerts = mesh.vertexCount();
+    UInt8Array1 band(numVerts, 0);
+    UInt32Array1 front;
+    const HardMidArray1 *mids[2] = { &bndryMids, &cnxnMids };
+    for (int ii = 0; ii < 2; ++ii) {
+        HardMidArray1::const_iterator it = mids[ii]->begin();
+        for (; it != mids[ii]->end(); ++it) {
+            for (int jj = 0; jj < 2; ++jj) {
+                const UInt32 v = it->edge_[jj];
+                if ((v < numVerts) && !band[v]) {
+                    band[v] = 1;
+                    front.push_back(v);
+                }
+            }
+        }
+    }
+    UInt32Array1 offsets;
+    UInt32Array1 cells;
+    if (1 < numBandLayers_) {
+        DualMeshBuilder::buildVertCells(mesh, offsets, cells);
+    }
+    UInt32Array1 next;
+    for (UInt32 layer = 1; layer < numBandLayers_; ++layer) {
+        next.clear();
+        UInt32Array1::const_iterator it = front.begin();
+        for (; it != front.end(); ++it) {
+            for (UInt32 ii = offsets[*it]; ii < offsets[*it + 1]; ++ii) {
+                const UInt32 *tri = mesh.tri(cells[ii]);
+                for (int jj = 0; jj < 3; ++jj) {
+                    if ((tri[jj] < numVerts) && !band[tri[jj]]) {
+                        band[tri[jj]] = 1;
+                        next.push_back(tri[jj]);
+                    }
+                }
+            }
+        }
+        front.swap(next);
+    }
+    for (UInt32 ii = 0; ii < numVerts; ++ii) {
+        if (band[ii]) {
+            selected[ii] = 1;
+        }
+    }
+}
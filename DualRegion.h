@@ -0,0 +1,77 @@
+/****************************************************************************
+ *
+ * class DualRegion
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALREGION_H_
+#define _DUALREGION_H_
+
+#include "PluginTypes.h"
+#include "TriMesh.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Selects the primal vertices of a region of interest.
+
+    A vertex is selected if it passes any of the set criteria:
+      - It lies inside the axis-aligned box (bounds included).
+      - It was added by addVerts(). The plugin adds the vertices of the
+        boundary conditions named by the user.
+      - It is within the hard edge band. Layer 1 of the band is the
+        vertices of the boundary and connection edges. Each further layer
+        adds the vertices that share a tri with the previous layer.
+    A region with no criteria set selects nothing.
+*/
+class DualRegion {
+public:
+
+    DualRegion();
+    ~DualRegion();
+
+    //! Removes all criteria
+    void        clear();
+
+    //! True if any criteria is set
+    bool        isSet() const;
+
+    void        setBox(const Vec3 &lo, const Vec3 &hi);
+
+    //! Number of hard edge band layers to select. 0 turns the band off.
+    void        setHardBand(UInt32 numLayers);
+
+    //! Selects the count verts. Invalid indices are ignored by select().
+    void        addVerts(const UInt32 *verts, UInt32 count);
+
+    //! Sets verts to the selected vertices of mesh in ascending order.
+    //! Hard edges that reference an invalid vertex are ignored.
+    void        select(const TriMesh &mesh, const HardMidArray1 &bndryMids,
+                    const HardMidArray1 &cnxnMids, UInt32Array1 &verts) const;
+
+    //! Parses the 6 numbers "xmin ymin zmin xmax ymax zmax" of a box.
+    //! Returns false if str is not 6 numbers.
+    static bool parseBox(const char *str, Vec3 &lo, Vec3 &hi);
+
+private:
+
+    void        selectBand(const TriMesh &mesh, const HardMidArray1 &bndryMids,
+                    const HardMidArray1 &cnxnMids, UInt8Array1 &selected)
+                    const;
+
+private:
+
+    bool            hasBox_;
+    Vec3            boxLo_;
+    Vec3            boxHi_;
+    UInt32          numBandLayers_;
+    UInt32Array1    verts_;
+};
+
+#endif // _DUALREGION_H_
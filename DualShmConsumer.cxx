@@ -0,0 +1,184 @@
+/****************************************************************************
+ *
+ * dualshm command line tool
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "DualMeshShmWriter.h"
+
+typedef DualMeshShmWriter::Header ShmHeader;
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+//! Returns true if the array [offset, offset + numBytes) is in the segment
+static bool
+inSegment(const ShmHeader &hdr, unsigned long long offset, size_t numBytes)
+{
+    return (0 == (offset % 8)) && (offset >= sizeof(ShmHeader)) &&
+        (offset <= hdr.totalBytes_) && (numBytes <= hdr.totalBytes_ - offset);
+}
+
+
+//! Checks the header and that every polygon references valid dual vertices
+static bool
+validate(const char *base, size_t size)
+{
+    const ShmHeader &hdr = *reinterpret_cast<const ShmHeader*>(base);
+    if ((0 != memcmp(hdr.magic_, DualMeshShmWriter::segmentMagic(), 8)) ||
+            (DualMeshShmWriter::Version != hdr.version_) ||
+            (hdr.totalBytes_ > size) ||
+            !inSegment(hdr, hdr.gceXyzOffset_,
+                3 * sizeof(double) * size_t(hdr.numGceVerts_)) ||
+            !inSegment(hdr, hdr.xyzOffset_,
+                3 * sizeof(double) * size_t(hdr.numVerts_)) ||
+            !inSegment(hdr, hdr.polyGceVertOffset_,
+                sizeof(UInt32) * size_t(hdr.numPolys_)) ||
+            !inSegment(hdr, hdr.polyOffsetsOffset_,
+                sizeof(UInt32) * (size_t(hdr.numPolys_) + 1)) ||
+            !inSegment(hdr, hdr.polyVertsOffset_,
+                sizeof(UInt32) * size_t(hdr.numPolyVerts_)) ||
+            !inSegment(hdr, hdr.vertTypeOffset_, size_t(hdr.numVerts_)) ||
+            !inSegment(hdr, hdr.polyBndryOffset_, size_t(hdr.numPolys_))) {
+        return false;
+    }
+    const UInt32 *gceVerts = reinterpret_cast<const UInt32*>(base +
+        hdr.polyGceVertOffset_);
+    const UInt32 *offsets = reinterpret_cast<const UInt32*>(base +
+        hdr.polyOffsetsOffset_);
+    const UInt32 *verts = reinterpret_cast<const UInt32*>(base +
+        hdr.polyVertsOffset_);
+    if ((0 != offsets[0]) || (hdr.numPolyVerts_ != offsets[hdr.numPolys_])) {
+        return false;
+    }
+    for (UInt32 ii = 0; ii < hdr.numPolys_; ++ii) {
+        if ((offsets[ii] > offsets[ii + 1]) ||
+                (gceVerts[ii] >= hdr.numGceVerts_)) {
+            return false;
+        }
+    }
+    for (UInt32 ii = 0; ii < hdr.numPolyVerts_; ++ii) {
+        if (verts[ii] >= hdr.numVerts_) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    int arg = 1;
+    const bool doUnlink = (arg < argc) && (0 == strcmp(argv[arg], "-u"));
+    if (doUnlink) {
+        ++arg;
+    }
+    if ((arg + 1 != argc) && (arg + 2 != argc)) {
+        fprintf(stderr, "usage: %s [-u] name [waitSeconds]\n"
+            "  -u   unlink the segment after reading it\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::string name = ('/' == argv[arg][0]) ? "" : "/";
+    name += argv[arg];
+    const int waitMs = 1000 * ((arg + 2 == argc) ? atoi(argv[arg + 1]) : 0);
+
+    // Wait for the segment to appear and its ready flag to be set
+    const char *base = 0;
+    size_t size = 0;
+    bool ready = false;
+    for (int waited = 0; !ready; waited += 10) {
+        const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        struct stat st;
+        if ((fd >= 0) && (0 == fstat(fd, &st)) &&
+                (size_t(st.st_size) >= sizeof(ShmHeader))) {
+            size = size_t(st.st_size);
+            void *addr = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+            base = (MAP_FAILED == addr) ? 0 : static_cast<const char*>(addr);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        if (0 != base) {
+            const volatile UInt32 *flag =
+                &reinterpret_cast<const ShmHeader*>(base)->ready_;
+            ready = (1 == *flag);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        if (!ready) {
+            if (0 != base) {
+                munmap(const_cast<char*>(base), size);
+                base = 0;
+            }
+            if (waited >= waitMs) {
+                fprintf(stderr, "error: %s: no ready segment\n",
+                    name.c_str());
+                return EXIT_FAILURE;
+            }
+            usleep(10000);
+        }
+    }
+
+    if (!validate(base, size)) {
+        fprintf(stderr, "error: %s: not a valid dual mesh segment\n",
+            name.c_str());
+        munmap(const_cast<char*>(base), size);
+        return EXIT_FAILURE;
+    }
+    const ShmHeader &hdr = *reinterpret_cast<const ShmHeader*>(base);
+    const double *xyz = reinterpret_cast<const double*>(base + hdr.xyzOffset_);
+    const UInt8 *types = reinterpret_cast<const UInt8*>(base +
+        hdr.vertTypeOffset_);
+    const UInt8 *bndry = reinterpret_cast<const UInt8*>(base +
+        hdr.polyBndryOffset_);
+    UInt32 typeCounts[4] = { 0, 0, 0, 0 };
+    double lo[3] = { 0.0, 0.0, 0.0 };
+    double hi[3] = { 0.0, 0.0, 0.0 };
+    for (UInt32 ii = 0; ii < hdr.numVerts_; ++ii) {
+        if (types[ii] < 4) {
+            ++typeCounts[types[ii]];
+        }
+        for (int k = 0; k < 3; ++k) {
+            const double v = xyz[3 * size_t(ii) + k];
+            lo[k] = ((0 == ii) || (v < lo[k])) ? v : lo[k];
+            hi[k] = ((0 == ii) || (v > hi[k])) ? v : hi[k];
+        }
+    }
+    UInt32 numBndryPolys = 0;
+    for (UInt32 ii = 0; ii < hdr.numPolys_; ++ii) {
+        numBndryPolys += bndry[ii];
+    }
+    printf("segment %s: %llu bytes, version %u\n", name.c_str(),
+        hdr.totalBytes_, hdr.version_);
+    printf("gce vertices %u\n", hdr.numGceVerts_);
+    printf("dual vertices %u (elem %u, bndry %u, cnxn %u, gce %u)\n",
+        hdr.numVerts_, typeCounts[DualMeshSink::ElemVert],
+        typeCounts[DualMeshSink::BndryVert], typeCounts[DualMeshSink::CnxnVert],
+        typeCounts[DualMeshSink::GceVert]);
+    printf("polygons %u (bndry %u), polygon vertices %u\n", hdr.numPolys_,
+        numBndryPolys, hdr.numPolyVerts_);
+    printf("bounds %g %g %g .. %g %g %g\n", lo[0], lo[1], lo[2], hi[0], hi[1],
+        hi[2]);
+    munmap(const_cast<char*>(base), size);
+    if (doUnlink) {
+        shm_unlink(name.c_str());
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+/****************************************************************************
+ *
+ * class DualTrace
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <atomic>
+#include <cstdio>
+
+#include "DualTrace.h"
+
+#if defined(_MSC_VER)
+#   define DUALTRACE_TLS __declspec(thread)
+#else
+#   define DUALTRACE_TLS __thread
+#endif
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+namespace {
+
+/*! One thread's event ring. Only the owning thread writes records. head_ is
+    the total number of records written and is published with release
+    semantics so save() never sees a partially written record.
+*/
+struct TraceRing {
+    std::atomic<unsigned long long> head_;
+    unsigned short                  thread_;
+    TraceRing *                     next_;
+    DualTrace::Record               recs_[DualTrace::RingSize];
+};
+
+struct EventInfo {
+    const char *    name_;
+    const char *    args_[4];   // arg names. 0 if unused.
+};
+
+// Must match the DualTrace::Event order
+const EventInfo eventInfo[DualTrace::NumEvents] = {
+    { "FanBegin",       { "gceVertNdx", "numFanCells", 0, 0 } },
+    { "FanCell",        { "cellNdx", "v0", "v1", "v2" } },
+    { "FanSorted",      { "gceVertNdx", "numRuns", "isClosed", 0 } },
+    { "HardEdgeHit",    { "v0", "v1", "dualNdx", 0 } },
+    { "HardEdgeMiss",   { "v0", "v1", "isLeft", 0 } },
+    { "BadFanCell",     { "gceVertNdx", "cellNdx", 0, 0 } },
+    { "HardEdgeAdd",    { "v0", "v1", "dualNdx", 0 } },
+    { "GceVertExport",  { "gceVertNdx", "dualNdx", "numHardEdges", 0 } },
+    { "BadHardVert",    { "gceVertNdx", "numHardEdges", 0, 0 } },
+};
+
+//! Lock-free list of all rings. A ring outlives its thread so its events can
+//! still be saved. clear() frees the rings and bumps generation. A thread
+//! whose threadGeneration is stale must not touch its freed threadRing.
+std::atomic<TraceRing*>         rings(0);
+std::atomic<unsigned short>     numThreads(0);
+std::atomic<UInt32>             generation(0);
+DUALTRACE_TLS TraceRing *       threadRing = 0;
+DUALTRACE_TLS UInt32            threadGeneration = 0;
+
+
+TraceRing *
+getThreadRing()
+{
+    TraceRing *ring = threadRing;
+    const UInt32 gen = generation.load(std::memory_order_relaxed);
+    if ((0 == ring) || (gen != threadGeneration)) {
+        ring = new TraceRing;
+        ring->head_.store(0, std::memory_order_relaxed);
+        ring->thread_ = numThreads.fetch_add(1, std::memory_order_relaxed);
+        TraceRing *head = rings.load(std::memory_order_relaxed);
+        do {
+            ring->next_ = head;
+        } while (!rings.compare_exchange_weak(head, ring,
+                    std::memory_order_release, std::memory_order_relaxed));
+        threadRing = ring;
+        threadGeneration = gen;
+    }
+    return ring;
+}
+
+} // namespace
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+std::atomic<bool> DualTrace::enabled_(false);
+
+
+void
+DualTrace::enable(bool enable)
+{
+    enabled_.store(enable, std::memory_order_relaxed);
+}
+
+
+void
+DualTrace::record(Event event, UInt32 a0, UInt32 a1, UInt32 a2, UInt32 a3)
+{
+    TraceRing *ring = getThreadRing();
+    const unsigned long long n = ring->head_.load(std::memory_order_relaxed);
+    Record &r = ring->recs_[n & (RingSize - 1)];
+    r.seq_ = UInt32(n);
+    r.event_ = (unsigned short)event;
+    r.thread_ = ring->thread_;
+    r.args_[0] = a0;
+    r.args_[1] = a1;
+    r.args_[2] = a2;
+    r.args_[3] = a3;
+    ring->head_.store(n + 1, std::memory_order_release);
+}
+
+
+bool
+DualTrace::save(const char *filename)
+{
+    std::FILE *fp = fopen(filename, "wb");
+    if (0 == fp) {
+        return false;
+    }
+    const unsigned long long ringSize = RingSize;
+    // count the records first so the header is complete
+    UInt32 numRecs = 0;
+    TraceRing *ring = rings.load(std::memory_order_acquire);
+    for (; 0 != ring; ring = ring->next_) {
+        const unsigned long long head =
+            ring->head_.load(std::memory_order_acquire);
+        numRecs += UInt32(head < ringSize ? head : ringSize);
+    }
+    const UInt32 recSize = UInt32(sizeof(Record));
+    bool ret = (1 == fwrite(fileMagic(), 8, 1, fp)) &&
+        (1 == fwrite(&recSize, sizeof(recSize), 1, fp)) &&
+        (1 == fwrite(&numRecs, sizeof(numRecs), 1, fp));
+    // Write each ring oldest to newest. The decoder orders the threads.
+    ring = rings.load(std::memory_order_acquire);
+    for (; ret && (0 != ring); ring = ring->next_) {
+        const unsigned long long head =
+            ring->head_.load(std::memory_order_acquire);
+        const unsigned long long cnt = (head < ringSize ? head : ringSize);
+        for (unsigned long long ii = head - cnt; ret && (ii < head); ++ii) {
+            ret = (1 == fwrite(&ring->recs_[ii & (RingSize - 1)],
+                sizeof(Record), 1, fp));
+        }
+    }
+    return (0 == fclose(fp)) && ret;
+}
+
+
+void
+DualTrace::clear()
+{
+    TraceRing *ring = rings.exchange(0, std::memory_order_acq_rel);
+    while (0 != ring) {
+        TraceRing *next = ring->next_;
+        delete ring;
+        ring = next;
+    }
+    numThreads.store(0, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+const char *
+DualTrace::eventName(UInt32 event)
+{
+    return (event < NumEvents) ? eventInfo[event].name_ : "Unknown";
+}
+
+
+const char *
+DualTrace::eventArgName(UInt32 event, UInt32 arg)
+{
+    static const char *unknown[4] = { "a0", "a1", "a2", "a3" };
+    const char *ret = 0;
+    if (arg < 4) {
+        ret = (event < NumEvents) ? eventInfo[event].args_[arg] : unknown[arg];
+    }
+    return ret;
+}
+
+
+const char *
+DualTrace::fileMagic()
+{
+    return "DUALTRC1";
+}
@@ -0,0 +1,113 @@
+/****************************************************************************
+ *
+ * class DualTrace
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALTRACE_H_
+#define _DUALTRACE_H_
+
+#include <atomic>
+
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Low overhead structured event tracing.
+
+    Each thread records fixed size binary events into its own ring buffer.
+    Recording never locks and never formats text. When a ring is full, the
+    oldest events are overwritten. Call save() after the traced work is done
+    to write the rings to a file. Use the dualtrace tool to decode a trace
+    file to text.
+
+    Use the DUAL_TRACE macros to add trace points. They compile to nothing
+    when DUALMESH_NO_TRACE is defined. Otherwise, a disabled trace point costs
+    one relaxed load of a global flag.
+*/
+class DualTrace {
+public:
+
+    //! Trace event ids. Append new events to the end. Existing ids are stored
+    //! in trace files.
+    enum Event {
+        FanBegin,       // gceVertNdx, numFanCells
+        FanCell,        // cellNdx, v0, v1, v2
+        FanSorted,      // gceVertNdx, numRuns, isClosed
+        HardEdgeHit,    // v0, v1, dualNdx
+        HardEdgeMiss,   // v0, v1, isLeft
+        BadFanCell,     // gceVertNdx, cellNdx
+        HardEdgeAdd,    // v0, v1, dualNdx
+        GceVertExport,  // gceVertNdx, dualNdx, numHardEdges
+        BadHardVert,    // gceVertNdx, numHardEdges
+        NumEvents
+    };
+
+    //! A single trace event. 24 bytes.
+    struct Record {
+        UInt32          seq_;       // per thread sequence number
+        unsigned short  event_;     // Event
+        unsigned short  thread_;    // trace thread id
+        UInt32          args_[4];
+    };
+
+    //! Number of records in each thread's ring. Must be a power of 2. A
+    //! thread allocates its ring (RingSize * 24 bytes = 1.5 MB) on its first
+    //! record. The ring is kept after the thread exits until clear().
+    enum { RingSize = 1 << 16 };
+
+    static void         enable(bool enable = true);
+
+    static inline bool
+    isEnabled()
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+
+    static void         record(Event event, UInt32 a0 = 0, UInt32 a1 = 0,
+                            UInt32 a2 = 0, UInt32 a3 = 0);
+
+    //! Writes all rings to filename. Should be called when no thread is
+    //! recording.
+    static bool         save(const char *filename);
+
+    //! Discards all recorded events and frees the rings. Should be called
+    //! when no thread is recording.
+    static void         clear();
+
+    static const char * eventName(UInt32 event);
+    //! Returns 0 if arg is not used by event.
+    static const char * eventArgName(UInt32 event, UInt32 arg);
+    static const char * fileMagic();
+
+private:
+
+    static std::atomic<bool>    enabled_;
+};
+
+
+#if defined(DUALMESH_NO_TRACE)
+#   define DUAL_TRACE(ev, a0, a1, a2, a3)   ((void)0)
+#else
+#   define DUAL_TRACE(ev, a0, a1, a2, a3) \
+        do { \
+            if (DualTrace::isEnabled()) { \
+                DualTrace::record(DualTrace::ev, a0, a1, a2, a3); \
+            } \
+        } while (0)
+#endif
+
+#define DUAL_TRACE1(ev, a0)             DUAL_TRACE(ev, a0, 0, 0, 0)
+#define DUAL_TRACE2(ev, a0, a1)         DUAL_TRACE(ev, a0, a1, 0, 0)
+#define DUAL_TRACE3(ev, a0, a1, a2)     DUAL_TRACE(ev, a0, a1, a2, 0)
+#define DUAL_TRACE4(ev, a0, a1, a2, a3) DUAL_TRACE(ev, a0, a1, a2, a3)
+
+#endif // _DUALTRACE_H_
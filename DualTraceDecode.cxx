@@ -0,0 +1,79 @@
+/****************************************************************************
+ *
+ * dualtrace command line tool
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "DualTrace.h"
+#include "MappedFile.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+static bool
+recordLess(const DualTrace::Record &lhs, const DualTrace::Record &rhs)
+{
+    return (lhs.thread_ < rhs.thread_) ||
+        ((lhs.thread_ == rhs.thread_) && (lhs.seq_ < rhs.seq_));
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    if (2 != argc) {
+        fprintf(stderr, "usage: %s file.trace\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    MappedFile file;
+    if (!file.open(argv[1])) {
+        fprintf(stderr, "error: %s: could not map file\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    const char *base = static_cast<const char*>(file.data());
+    const size_t hdrSize = 8 + 2 * sizeof(UInt32);
+    UInt32 recSize = 0;
+    UInt32 numRecs = 0;
+    if (file.size() >= hdrSize) {
+        memcpy(&recSize, base + 8, sizeof(recSize));
+        memcpy(&numRecs, base + 8 + sizeof(recSize), sizeof(numRecs));
+    }
+    if ((file.size() < hdrSize) ||
+            (0 != memcmp(base, DualTrace::fileMagic(), 8)) ||
+            (sizeof(DualTrace::Record) != recSize) ||
+            (file.size() < hdrSize + size_t(numRecs) * recSize)) {
+        fprintf(stderr, "error: %s: not a dual mesh trace file\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    std::vector<DualTrace::Record> recs(numRecs);
+    if (0 < numRecs) {
+        memcpy(&recs[0], base + hdrSize, size_t(numRecs) * recSize);
+    }
+    std::stable_sort(recs.begin(), recs.end(), recordLess);
+
+    std::vector<DualTrace::Record>::const_iterator it = recs.begin();
+    for (; it != recs.end(); ++it) {
+        printf("%u:%u %s", unsigned(it->thread_), it->seq_,
+            DualTrace::eventName(it->event_));
+        for (UInt32 ii = 0; ii < 4; ++ii) {
+            const char *argName = DualTrace::eventArgName(it->event_, ii);
+            if (0 != argName) {
+                printf(" %s=%u", argName, it->args_[ii]);
+            }
+        }
+        printf("\n");
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+/****************************************************************************
+ *
+ * class DualVariant
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "DualVariant.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+DualVariant::DualVariant(double maxTurnAngle,
+        DualPlacement::Strategy placement) :
+    maxTurnAngle_(maxTurnAngle),
+    placement_(placement)
+{
+}
+
+
+bool
+DualVariant::parseList(const char *str, const DualVariant &defaults,
+    Array1 &variants, std::string &badToken)
+{
+    static const char *Separators = " \t,";
+    variants.clear();
+    while ((0 != str) && ('\0' != *str)) {
+        const size_t setLen = strcspn(str, ";");
+        const std::string set(str, setLen);
+        str += setLen + ((';' == str[setLen]) ? 1 : 0);
+        DualVariant variant = defaults;
+        bool isEmpty = true;
+        const char *p = set.c_str();
+        while ('\0' != *(p += strspn(p, Separators))) {
+            const size_t len = strcspn(p, Separators);
+            const std::string token(p, len);
+            p += len;
+            char *end = 0;
+            const double angle = strtod(token.c_str(), &end);
+            if ('\0' == *end) {
+                // the range of the MaxTurnAngle attribute. Rejects nan.
+                if (!((angle >= 0.0) && (angle <= 180.0))) {
+                    badToken = token;
+                    return false;
+                }
+                variant.maxTurnAngle_ = angle;
+            }
+            else if (!DualPlacement::fromName(token.c_str(),
+                    variant.placement_)) {
+                badToken = token;
+                return false;
+            }
+            isEmpty = false;
+        }
+        if (!isEmpty) {
+            variants.push_back(variant);
+        }
+    }
+    return true;
+}
+
+
+std::string
+DualVariant::fileName(const char *fileName, UInt32 num)
+{
+    const std::string name(fileName);
+    const size_t slash = name.find_last_of("/\\");
+    size_t dot = name.rfind('.');
+    if ((std::string::npos == dot) ||
+            ((std::string::npos != slash) && (dot < slash))) {
+        dot = name.size();
+    }
+    char tag[32];
+    sprintf(tag, ".v%u", num);
+    return name.substr(0, dot) + tag + name.substr(dot);
+}
@@ -0,0 +1,57 @@
+/****************************************************************************
+ *
+ * class DualVariant
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _DUALVARIANT_H_
+#define _DUALVARIANT_H_
+
+#include <string>
+#include <vector>
+
+#include "DualPlacement.h"
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! The turning angle and placement of one extra export in a batch.
+
+    A batch writes the main export and then one file per variant from the
+    same loaded grid and hard edges. The builder is given a DualFanCache,
+    so each variant only sorts the fans of the vertices whose hard vertex
+    export state differs from the previous run.
+*/
+class DualVariant {
+public:
+
+    typedef std::vector<DualVariant> Array1;
+
+    DualVariant(double maxTurnAngle = 30.0,
+        DualPlacement::Strategy placement = DualPlacement::Centroid);
+
+    //! Parses a ';' separated list of option sets. Each set holds a
+    //! turning angle in degrees and/or a placement name separated by
+    //! spaces or commas. Options that are not given use the defaults.
+    //! Empty sets are skipped. Returns false and sets badToken to the first
+    //! option that is neither or to a turning angle outside [0, 180].
+    static bool parseList(const char *str, const DualVariant &defaults,
+                    Array1 &variants, std::string &badToken);
+
+    //! Inserts ".v<num>" before the extension of fileName
+    static std::string fileName(const char *fileName, UInt32 num);
+
+public:
+
+    double                  maxTurnAngle_;
+    DualPlacement::Strategy placement_;
+};
+
+#endif // _DUALVARIANT_H_
@@ -8,20 +8,17 @@
  *
  ***************************************************************************/
 
-//#include <algorithm>
+#include <algorithm>
 
-#include "apiPWP.h"
-#include "CaeUnsGridModel.h"
+#include "DualTrace.h"
 #include "FanSorter.h"
 #include "PluginTypes.h"
-#include "PwpFile.h"
+#include "TriMesh.h"
 
 
-FanSorter::FanSorter(PwpFile &dumpFile,
-        const EdgeToUInt32Map &hardGceEdgeToDualVert,
+FanSorter::FanSorter(const HardEdgeIndex &hardEdges,
         const UInt32ToUInt32Map &hardGceVertToDualVert) :
-    dumpFile_(dumpFile),
-    hardGceEdgeToDualVert_(hardGceEdgeToDualVert),
+    hardEdges_(hardEdges),
     hardGceVertToDualVert_(hardGceVertToDualVert)
 {
 }
@@ -32,13 +29,11 @@ FanSorter::~FanSorter()
 }
 
 
-void
-FanSorter::run(CaeUnsGridModel &model, PWP_UINT32 gceVertNdx,
-    const UInt32Array1 &fanCells, UInt32Array2 &fans)
+bool
+FanSorter::run(const TriMesh &mesh, UInt32 gceVertNdx, const UInt32 *fanCells,
+    UInt32 numFanCells, UInt32Array2 &fans)
 {
-    if (dumpFile_.isOpen()) {
-        dumpFile_.write(gceVertNdx, "\n", "\n# FanSorter::run gceVertNdx=");
-    }
+    DUAL_TRACE2(FanBegin, gceVertNdx, numFanCells);
     /*  fanCells is in an unspecified order. Each cell has a right-handed
         winding order that contains gceVertNdx. For example, cellD = (5,4,0).
         We need to arrange cells around gceVertNdx into a right-handed
@@ -53,47 +48,44 @@ FanSorter::run(CaeUnsGridModel &model, PWP_UINT32 gceVertNdx,
             /       \|/       \    cellA     = (0,5,4)
            1---------0---------5   
     */
-    PWGM_ELEMDATA ed;
+    UInt32 indices[3];
     FanCellArray1 fanCellArr;
-    fanCellArr.reserve(fanCells.size());
-    UInt32Array1::const_iterator itNdx = fanCells.begin();
-    for (; itNdx != fanCells.end(); ++itNdx) {
-        const PWP_UINT32 cellNdx = *itNdx;
-        if (!CaeUnsElement(model, cellNdx).data(ed)) {
+    fanCellArr.reserve(numFanCells);
+    for (UInt32 nn = 0; nn < numFanCells; ++nn) {
+        const UInt32 cellNdx = fanCells[nn];
+        if (cellNdx >= mesh.triCount()) {
             // very bad! exception?
             continue;
         }
+        const UInt32 *tri = mesh.tri(cellNdx);
         // Load fanCellArr for processing below
-        for (PWP_UINT32 ii = 0; ii < ed.vertCnt; ++ii) {
-            if (ed.index[ii] == gceVertNdx) {
+        for (UInt32 ii = 0; ii < 3; ++ii) {
+            if (tri[ii] == gceVertNdx) {
                 // rotate cell vertices to make gceVertNdx first
-                std::rotate(ed.index, ed.index + ii, ed.index + ed.vertCnt);
-                fanCellArr.push_back(FanCell(cellNdx, ed.index));
+                indices[0] = tri[ii];
+                indices[1] = tri[(ii + 1) % 3];
+                indices[2] = tri[(ii + 2) % 3];
+                fanCellArr.push_back(FanCell(cellNdx, indices));
+                DUAL_TRACE4(FanCell, cellNdx, indices[0], indices[1],
+                    indices[2]);
                 // all done with this fan cell
                 break;
             }
-        }
-        if (dumpFile_.isOpen()) {
-            const FanCell &c = fanCellArr.back();
-            dumpFile_.write(c.cellNdx_, " { ", "#    cell ndx=");
-            for (PWP_UINT32 ii = 0; ii < 3; ++ii) {
-                dumpFile_.write(c.indices_[ii], " ");
+            else if (2 == ii) {
+                // very bad! cell does not touch gceVertNdx
+                DUAL_TRACE2(BadFanCell, gceVertNdx, cellNdx);
             }
-            Edge e = c.leftEdge();
-            dumpFile_.write(e[0], " ", " } / leftEdge { ");
-            dumpFile_.write(e[1], " }  rightEdge { ");
-            e = c.rightEdge();
-            dumpFile_.write(e[0], " ");
-            dumpFile_.write(e[1], " }\n");
         }
     }
 
     // Sort the cells by walking their right edges.
     UInt32Array1 runLength;
     bool isClosed = run2(fanCellArr, runLength);
+    DUAL_TRACE3(FanSorted, gceVertNdx, UInt32(runLength.size()),
+        UInt32(isClosed));
 
     // If gceVertNdx was exported, we need to include it in the polygon 
-    PWP_UINT32 gceVertDualNdx = 0;
+    UInt32 gceVertDualNdx = 0;
     bool includeGceVertNdx = false;
     UInt32ToUInt32Map::const_iterator it =
         hardGceVertToDualVert_.find(gceVertNdx);
@@ -103,55 +95,63 @@ FanSorter::run(CaeUnsGridModel &model, PWP_UINT32 gceVertNdx,
     }
 
     // build return array
-    EdgeToUInt32Map::const_iterator itEdgeVert;
+    bool ret = true;
+    UInt32 edgeDualNdx;
     FanCellArray1::const_iterator itFanCell = fanCellArr.begin();
     FanCellArray1::const_iterator itLastFanCell;
     UInt32Array1::iterator itRunLength = runLength.begin();
-    for (; itRunLength != runLength.end(); ++itRunLength) {
+    for (; ret && (itRunLength != runLength.end()); ++itRunLength) {
         UInt32Array1 fan;
         if (!isClosed) {
             // cacheThis for below
             itLastFanCell = itFanCell + (*itRunLength - 1);
             // add right hard edge vertex
-            if (findHardEdge(itFanCell->rightEdge(), itEdgeVert)) {
-                fan.push_back(itEdgeVert->second);
+            const Edge rightEdge = itFanCell->rightEdge();
+            if (findHardEdge(rightEdge, edgeDualNdx)) {
+                DUAL_TRACE3(HardEdgeHit, rightEdge[0], rightEdge[1],
+                    edgeDualNdx);
+                fan.push_back(edgeDualNdx);
             }
             else {
-                fail("Could not find right hard edge");
+                // bad orientation or non-manifold topology
+                DUAL_TRACE3(HardEdgeMiss, rightEdge[0], rightEdge[1], 0);
+                ret = false;
+                break;
             }
         }
         // Add cell centroid indices
-        for (PWP_UINT32 n = 0; n < *itRunLength; ++n) {
+        for (UInt32 n = 0; n < *itRunLength; ++n) {
             fan.push_back(itFanCell->cellNdx_);
             ++itFanCell;
         }
         if (!isClosed) {
             // add left hard edge vertex
-            if (findHardEdge(itLastFanCell->leftEdge(), itEdgeVert)) {
-                fan.push_back(itEdgeVert->second);
+            const Edge leftEdge = itLastFanCell->leftEdge();
+            if (findHardEdge(leftEdge, edgeDualNdx)) {
+                DUAL_TRACE3(HardEdgeHit, leftEdge[0], leftEdge[1],
+                    edgeDualNdx);
+                fan.push_back(edgeDualNdx);
             }
             else {
-                fail("Could not find left hard edge");
+                DUAL_TRACE3(HardEdgeMiss, leftEdge[0], leftEdge[1], 1);
+                ret = false;
+                break;
             }
             if (includeGceVertNdx) {
                 fan.push_back(gceVertDualNdx);
             }
-            *itRunLength = PWP_UINT32(fan.size());
+            *itRunLength = UInt32(fan.size());
         }
         fans.push_back(fan);
     }
+    return ret;
 }
 
 
 bool
-FanSorter::findHardEdge(Edge edge, EdgeToUInt32Map::const_iterator &it)
+FanSorter::findHardEdge(const Edge &edge, UInt32 &dualNdx) const
 {
-    it = hardGceEdgeToDualVert_.find(edge);
-    if (hardGceEdgeToDualVert_.end() == it) {
-        std::swap(edge[0], edge[1]);
-        it = hardGceEdgeToDualVert_.find(edge);
-    }
-    return hardGceEdgeToDualVert_.end() != it;
+    return hardEdges_.findEdge(edge, dualNdx);
 }
 
 
@@ -165,7 +165,7 @@ FanSorter::run2(FanCellArray1 &fanCells, UInt32Array1 &runLength)
     FanCellArray1::iterator itBegin = fanCells.begin();
     while (fanCells.end() != itBegin) {
         ret = sortFanCellRange(fanCells, itBegin, itRngRight, itRngLeft);
-        runLength.push_back(PWP_UINT32(std::distance(itRngRight, itRngLeft)));
+        runLength.push_back(UInt32(std::distance(itRngRight, itRngLeft)));
         itBegin = itRngLeft;
     }
     return ret;
@@ -184,12 +184,13 @@ FanSorter::sortFanCellRange(FanCellArray1 &fanCells,
     FanCellArray1::iterator itPivot = itRngRight;
     bool foundNext = true;
     FanCellArray1::iterator itCandidate = itRngLeft;
-    EdgeToUInt32Map::const_iterator itHardEdges = hardGceEdgeToDualVert_.end();
+    // A connection edge is shared by 2 cells and is walked in both
+    // directions. Hence, hard edges must be matched in either direction.
+    UInt32 hardEdgeNdx;
     while ((fanCells.end() != itCandidate) && foundNext) {
         foundNext = false;
         while (fanCells.end() != itCandidate) {
-            if (itHardEdges !=
-                    hardGceEdgeToDualVert_.find(itPivot->leftEdge())) {
+            if (findHardEdge(itPivot->leftEdge(), hardEdgeNdx)) {
                 // left edge is hard, can't walk across it!
                 break;
             }
@@ -223,7 +224,7 @@ FanSorter::sortFanCellRange(FanCellArray1 &fanCells,
         foundNext = false;
         while (fanCells.end() != itCandidate) {
             Edge pivotRightEdge(itPivot->rightEdge());
-            if (itHardEdges != hardGceEdgeToDualVert_.find(pivotRightEdge)) {
+            if (findHardEdge(pivotRightEdge, hardEdgeNdx)) {
                 // right edge is hard, can't walk across it!
                 break;
             }
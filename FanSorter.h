@@ -11,8 +11,9 @@
 #ifndef _FANSORTER_H_
 #define _FANSORTER_H_
 
+#include "HardEdgeIndex.h"
 #include "PluginTypes.h"
-#include "PwpFile.h"
+#include "TriMesh.h"
 
 
 //***************************************************************************
@@ -21,7 +22,7 @@
 
 class FanCell {
 public:
-    FanCell(PWP_UINT32 cellNdx = PWP_UINT32_UNDEF, PWP_UINT32 *indices = 0) :
+    FanCell(UInt32 cellNdx = UInt32Undef, const UInt32 *indices = 0) :
         cellNdx_(cellNdx)
     {
         setIndices(indices);
@@ -32,7 +33,7 @@ public:
 
 
     void
-    setIndices(PWP_UINT32 *indices)
+    setIndices(const UInt32 *indices)
     {
         if (0 != indices) {
             indices_[0] = indices[0];
@@ -40,13 +41,13 @@ public:
             indices_[2] = indices[2];
         }
         else {
-            indices_[0] = indices_[1] = indices_[2] = PWP_UINT32_UNDEF;
+            indices_[0] = indices_[1] = indices_[2] = UInt32Undef;
         }
     }
 
 
     inline Edge
-    edge(PWP_UINT32 ndx, bool fwd = true) const
+    edge(UInt32 ndx, bool fwd = true) const
     {
         Edge ret;
         switch(ndx) {
@@ -80,10 +81,10 @@ public:
         return edge(0, fwd);
     }
 
-    PWP_UINT32 cellNdx_;
-    PWP_UINT32 indices_[3];
+    UInt32 cellNdx_;
+    UInt32 indices_[3];
 };
-typedef std::vector<FanCell>    FanCellArray1;
+typedef std::vector<FanCell, DUAL_ALLOCATOR(FanCell)> FanCellArray1;
 
 
 //***************************************************************************
@@ -93,17 +94,21 @@ typedef std::vector<FanCell>    FanCellArray1;
 class FanSorter {
 public:
 
-    FanSorter(PwpFile &dumpFile, const EdgeToUInt32Map &hardGceEdgeToDualVert,
+    FanSorter(const HardEdgeIndex &hardEdges,
         const UInt32ToUInt32Map &hardGceVertToDualVert);
     ~FanSorter();
 
-    void        run(CaeUnsGridModel &model, PWP_UINT32 gceVertNdx,
-                    const UInt32Array1 &fanCells, UInt32Array2 &fans);
+    //! Returns false if an open fan does not end at a hard edge. That
+    //! happens for tris with inconsistent orientation or non-manifold edges.
+    //! fans is incomplete then.
+    bool        run(const TriMesh &mesh, UInt32 gceVertNdx,
+                    const UInt32 *fanCells, UInt32 numFanCells,
+                    UInt32Array2 &fans);
 
 
 private:
 
-    bool    findHardEdge(Edge edge, EdgeToUInt32Map::const_iterator &it);
+    bool    findHardEdge(const Edge &edge, UInt32 &dualNdx) const;
 
     bool    run2(FanCellArray1 &fanCells, UInt32Array1 &runLength);
 
@@ -114,8 +119,7 @@ private:
 
 
 private:
-    PwpFile &                   dumpFile_;
-    const EdgeToUInt32Map &     hardGceEdgeToDualVert_;
+    const HardEdgeIndex &       hardEdges_;
     const UInt32ToUInt32Map &   hardGceVertToDualVert_;
 };
 
@@ -0,0 +1,258 @@
+/****************************************************************************
+ *
+ * class HardEdgeIndex
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include "HardEdgeIndex.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+namespace {
+
+inline bool
+getCoord(const TriMesh &mesh, UInt32 vertNdx, Vec3 &v)
+{
+    return mesh.getCoord(vertNdx, v);
+}
+
+
+//! The xy of a vertex of a planar mesh
+inline bool
+getCoord(const TriMesh &mesh, UInt32 vertNdx, Vec2 &v)
+{
+    bool ret = (vertNdx < mesh.vertexCount());
+    if (ret) {
+        const double *p = mesh.xyz(vertNdx);
+        v.set(p[0], p[1]);
+    }
+    return ret;
+}
+
+} // namespace
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+HardEdgeIndex::HardEdgeIndex() :
+    edges_(),
+    firstDualNdx_(0),
+    offsets_(),
+    nbrs_(),
+    slotEdges_(),
+    twins_(),
+    hardVerts_()
+{
+}
+
+
+HardEdgeIndex::~HardEdgeIndex()
+{
+}
+
+
+bool
+HardEdgeIndex::build(UInt32 numVerts, const HardMidArray1 &bndryMids,
+    const HardMidArray1 &cnxnMids, UInt32 firstDualNdx)
+{
+    clear();
+    firstDualNdx_ = firstDualNdx;
+    edges_.reserve(bndryMids.size() + cnxnMids.size());
+    HardMidArray1::const_iterator it = bndryMids.begin();
+    for (; it != bndryMids.end(); ++it) {
+        edges_.push_back(it->edge_);
+    }
+    for (it = cnxnMids.begin(); it != cnxnMids.end(); ++it) {
+        edges_.push_back(it->edge_);
+    }
+
+    // Counting sort of the edge ends into CSR form
+    offsets_.assign(size_t(numVerts) + 1, 0);
+    EdgeArray1::const_iterator itEdge = edges_.begin();
+    for (; itEdge != edges_.end(); ++itEdge) {
+        if (((*itEdge)[0] >= numVerts) || ((*itEdge)[1] >= numVerts)) {
+            clear();
+            return false;
+        }
+        ++offsets_[(*itEdge)[0] + 1];
+        ++offsets_[(*itEdge)[1] + 1];
+    }
+    for (UInt32 ii = 0; ii < numVerts; ++ii) {
+        // offsets_[ii + 1] is still the edge count of vertex ii
+        if (0 != offsets_[ii + 1]) {
+            hardVerts_.push_back(ii);
+        }
+        offsets_[ii + 1] += offsets_[ii];
+    }
+    const size_t numSlots = 2 * edges_.size();
+    nbrs_.resize(numSlots);
+    slotEdges_.resize(numSlots);
+    twins_.resize(numSlots);
+    UInt32Array1 fill(offsets_.begin(), offsets_.end() - 1);
+    for (UInt32 ii = 0; ii < edges_.size(); ++ii) {
+        const Edge &edge = edges_[ii];
+        const UInt32 slot0 = fill[edge[0]]++;
+        const UInt32 slot1 = fill[edge[1]]++;
+        nbrs_[slot0] = edge[1];
+        nbrs_[slot1] = edge[0];
+        slotEdges_[slot0] = slotEdges_[slot1] = ii;
+        twins_[slot0] = slot1;
+        twins_[slot1] = slot0;
+    }
+    return true;
+}
+
+
+void
+HardEdgeIndex::clear()
+{
+    edges_.clear();
+    firstDualNdx_ = 0;
+    offsets_.clear();
+    nbrs_.clear();
+    slotEdges_.clear();
+    twins_.clear();
+    hardVerts_.clear();
+}
+
+
+bool
+HardEdgeIndex::classify(const TriMesh &mesh, double cosMaxTurnAngle,
+    UInt8Array1 &exportFlags) const
+{
+    exportFlags.assign(mesh.vertexCount(), 0);
+    UInt8Array1 visited(nbrs_.size(), 0);
+    const bool isPlanar = mesh.isPlanar();
+    bool ret = true;
+    // Junctions are always exported. Walk the open chains out of them.
+    UInt32Array1::const_iterator it = hardVerts_.begin();
+    for (; ret && (it != hardVerts_.end()); ++it) {
+        const UInt32 numHardEdges = degree(*it);
+        if (2 < numHardEdges) {
+            exportFlags[*it] = 1;
+        }
+        if (2 != numHardEdges) {
+            for (UInt32 slot = offsets_[*it]; ret && (slot < offsets_[*it + 1]);
+                    ++slot) {
+                if (visited[slot]) {
+                    continue;
+                }
+                if (isPlanar) {
+                    walkChain<Vec2>(mesh, slot, cosMaxTurnAngle, visited,
+                        exportFlags, ret);
+                }
+                else {
+                    walkChain<Vec3>(mesh, slot, cosMaxTurnAngle, visited,
+                        exportFlags, ret);
+                }
+            }
+        }
+    }
+    // Anything left is a closed loop
+    for (it = hardVerts_.begin(); ret && (it != hardVerts_.end()); ++it) {
+        if ((2 != degree(*it)) || visited[offsets_[*it]]) {
+            continue;
+        }
+        if (isPlanar) {
+            walkChain<Vec2>(mesh, offsets_[*it], cosMaxTurnAngle, visited,
+                exportFlags, ret);
+        }
+        else {
+            walkChain<Vec3>(mesh, offsets_[*it], cosMaxTurnAngle, visited,
+                exportFlags, ret);
+        }
+    }
+    return ret;
+}
+
+
+bool
+HardEdgeIndex::findEdge(const Edge &edge, UInt32 &dualNdx) const
+{
+    if (edge[0] + 1 >= offsets_.size()) {
+        return false;
+    }
+    UInt32 revSlot = UInt32Undef;
+    for (UInt32 slot = offsets_[edge[0]]; slot < offsets_[edge[0] + 1];
+            ++slot) {
+        if (edge[1] != nbrs_[slot]) {
+            continue;
+        }
+        if (edges_[slotEdges_[slot]][0] == edge[0]) {
+            dualNdx = firstDualNdx_ + slotEdges_[slot];
+            return true;
+        }
+        if (UInt32Undef == revSlot) {
+            revSlot = slot;
+        }
+    }
+    if (UInt32Undef != revSlot) {
+        dualNdx = firstDualNdx_ + slotEdges_[revSlot];
+    }
+    return UInt32Undef != revSlot;
+}
+
+
+template<typename VecT>
+void
+HardEdgeIndex::walkChain(const TriMesh &mesh, UInt32 slot,
+    double cosMaxTurnAngle, UInt8Array1 &visited, UInt8Array1 &exportFlags,
+    bool &ret) const
+{
+    // Walks from the vertex of slot along the chain until a junction or back
+    // to the start. The turn at vertex v with chain neighbors p and n is
+    // dot(unit(v - p), unit(n - v)).
+    const UInt32 start = nbrs_[twins_[slot]];
+    VecT p0;
+    VecT p1;
+    if (!getCoord(mesh, start, p0)) {
+        ret = false;
+        return;
+    }
+    VecT firstDir;
+    VecT dirIn;
+    bool isFirst = true;
+    UInt32 vert = start;
+    while (true) {
+        visited[slot] = visited[twins_[slot]] = 1;
+        const UInt32 next = nbrs_[slot];
+        if (!getCoord(mesh, next, p1)) {
+            ret = false;
+            return;
+        }
+        const VecT dirOut = (p1 - p0).normalize();
+        if (isFirst) {
+            firstDir = dirOut;
+            isFirst = false;
+        }
+        else if (cml::dot(dirIn, dirOut) < cosMaxTurnAngle) {
+            exportFlags[vert] = 1;
+        }
+        vert = next;
+        if (2 != degree(vert)) {
+            break; // reached a junction
+        }
+        dirIn = dirOut;
+        p0 = p1;
+        // leave vert through its other slot
+        const UInt32 inSlot = twins_[slot];
+        slot = (inSlot == offsets_[vert]) ? inSlot + 1 : inSlot - 1;
+        if (vert == start) {
+            // closed loop. The start vertex turns from the last edge into
+            // the first.
+            if (cml::dot(dirIn, firstDir) < cosMaxTurnAngle) {
+                exportFlags[vert] = 1;
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,131 @@
+/****************************************************************************
+ *
+ * class HardEdgeIndex
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _HARDEDGEINDEX_H_
+#define _HARDEDGEINDEX_H_
+
+#include "DualPlacement.h"
+#include "PluginTypes.h"
+#include "TriMesh.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Flat index of the boundary and connection (hard) edges.
+
+    The hard edges of each gce vertex are stored in CSR form. Each entry
+    (a slot) holds the other end of the edge, the edge's dual vertex index
+    and the slot of the same edge at the other end. A vertex with exactly 2
+    hard edges links them, so the slots form the boundary loops and the
+    open chains between junction vertices.
+
+    The index is built once from the hard edges in dual vertex order and
+    replaces the per-vertex edge multimap and the edge to dual vertex map.
+*/
+class HardEdgeIndex {
+public:
+
+    HardEdgeIndex();
+    ~HardEdgeIndex();
+
+    //! Indexes the boundary mids then the connection mids. The dual vertex
+    //! of mid k is firstDualNdx + k. Returns false if an edge has an invalid
+    //! vertex index.
+    bool        build(UInt32 numVerts, const HardMidArray1 &bndryMids,
+                    const HardMidArray1 &cnxnMids, UInt32 firstDualNdx);
+
+    void        clear();
+
+    //! Sets exportFlags[v] to 1 for every hard vertex v touched by more than
+    //! 2 hard edges or whose 2 hard edges turn more than the angle with
+    //! cosine cosMaxTurnAngle. The chains and loops are swept once and each
+    //! hard edge direction is computed once. Returns false if a hard vertex
+    //! has an invalid coordinate.
+    bool        classify(const TriMesh &mesh, double cosMaxTurnAngle,
+                    UInt8Array1 &exportFlags) const;
+
+    //! Finds the dual vertex of a hard edge given in either direction.
+    //! Edges in the given direction are preferred.
+    bool        findEdge(const Edge &edge, UInt32 &dualNdx) const;
+
+    //! The hard vertices in ascending order
+    inline const UInt32Array1 &
+    hardVerts() const
+    {
+        return hardVerts_;
+    }
+
+
+    //! Number of hard edges touching gceVertNdx
+    inline UInt32
+    degree(UInt32 gceVertNdx) const
+    {
+        return (gceVertNdx + 1 < offsets_.size()) ?
+            offsets_[gceVertNdx + 1] - offsets_[gceVertNdx] : 0;
+    }
+
+
+    //! Number of indexed hard edges
+    inline UInt32
+    edgeCount() const
+    {
+        return UInt32(edges_.size());
+    }
+
+
+    //! Hard edge k in dual vertex order
+    inline const Edge &
+    edge(UInt32 ndx) const
+    {
+        return edges_[ndx];
+    }
+
+
+    //! The dual vertex of hard edge 0
+    inline UInt32
+    firstDualNdx() const
+    {
+        return firstDualNdx_;
+    }
+
+
+private:
+
+    //! VecT is Vec2 for a planar mesh and Vec3 otherwise
+    template<typename VecT>
+    void        walkChain(const TriMesh &mesh, UInt32 slot,
+                    double cosMaxTurnAngle, UInt8Array1 &visited,
+                    UInt8Array1 &exportFlags, bool &ret) const;
+
+private:
+
+    //! The hard edges in dual vertex order
+    EdgeArray1          edges_;
+    UInt32              firstDualNdx_;
+
+    //! CSR slots of each vertex. The slots of vertex v are
+    //! [offsets_[v] .. offsets_[v+1]) in edge order.
+    UInt32Array1        offsets_;
+
+    //! The other end of each slot's edge
+    UInt32Array1        nbrs_;
+
+    //! The hard edge of each slot
+    UInt32Array1        slotEdges_;
+
+    //! The slot of the same edge at the other end
+    UInt32Array1        twins_;
+
+    UInt32Array1        hardVerts_;
+};
+
+#endif // _HARDEDGEINDEX_H_
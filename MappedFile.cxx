@@ -0,0 +1,119 @@
+/****************************************************************************
+ *
+ * class MappedFile
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#if defined(WINDOWS)
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+
+
+MappedFile::MappedFile() :
+    data_(0),
+    size_(0)
+#if defined(WINDOWS)
+    , hFile_(INVALID_HANDLE_VALUE),
+    hMapping_(0)
+#endif
+{
+}
+
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+
+#if defined(WINDOWS)
+
+bool
+MappedFile::open(const char *filename)
+{
+    close();
+    hFile_ = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if (INVALID_HANDLE_VALUE != hFile_) {
+        LARGE_INTEGER sz;
+        if (GetFileSizeEx(hFile_, &sz) && (0 < sz.QuadPart)) {
+            hMapping_ = CreateFileMappingA(hFile_, 0, PAGE_READONLY, 0, 0, 0);
+            if (0 != hMapping_) {
+                data_ = MapViewOfFile(hMapping_, FILE_MAP_READ, 0, 0, 0);
+                size_ = size_t(sz.QuadPart);
+            }
+        }
+    }
+    if (0 == data_) {
+        close();
+    }
+    return isOpen();
+}
+
+
+void
+MappedFile::close()
+{
+    if (0 != data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (0 != hMapping_) {
+        CloseHandle(hMapping_);
+    }
+    if (INVALID_HANDLE_VALUE != hFile_) {
+        CloseHandle(hFile_);
+    }
+    data_ = 0;
+    size_ = 0;
+    hMapping_ = 0;
+    hFile_ = INVALID_HANDLE_VALUE;
+}
+
+#else // POSIX
+
+bool
+MappedFile::open(const char *filename)
+{
+    close();
+    const int fd = ::open(filename, O_RDONLY);
+    if (-1 != fd) {
+        struct stat st;
+        if ((0 == fstat(fd, &st)) && (0 < st.st_size)) {
+            void *p = mmap(0, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd,
+                0);
+            if (MAP_FAILED != p) {
+                // The whole file is read front to back.
+                madvise(p, size_t(st.st_size), MADV_SEQUENTIAL);
+                data_ = p;
+                size_ = size_t(st.st_size);
+            }
+        }
+        // the mapping stays valid after the descriptor is closed
+        ::close(fd);
+    }
+    return isOpen();
+}
+
+
+void
+MappedFile::close()
+{
+    if (0 != data_) {
+        munmap(const_cast<void*>(data_), size_);
+    }
+    data_ = 0;
+    size_ = 0;
+}
+
+#endif
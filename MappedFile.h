@@ -0,0 +1,69 @@
+/****************************************************************************
+ *
+ * class MappedFile
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _MAPPEDFILE_H_
+#define _MAPPEDFILE_H_
+
+#include <cstddef>
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! A read-only memory mapping of an entire file.
+*/
+class MappedFile {
+public:
+
+    MappedFile();
+    ~MappedFile();
+
+    bool        open(const char *filename);
+    void        close();
+
+    inline bool
+    isOpen() const
+    {
+        return 0 != data_;
+    }
+
+
+    inline const void *
+    data() const
+    {
+        return data_;
+    }
+
+
+    inline size_t
+    size() const
+    {
+        return size_;
+    }
+
+
+private:
+
+    // not copyable
+    MappedFile(const MappedFile &);
+    MappedFile & operator=(const MappedFile &);
+
+private:
+
+    const void *    data_;
+    size_t          size_;
+#if defined(WINDOWS)
+    void *          hFile_;
+    void *          hMapping_;
+#endif
+};
+
+#endif // _MAPPEDFILE_H_
@@ -0,0 +1,147 @@
+/****************************************************************************
+ *
+ * class MemoryStats
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <atomic>
+#include <cstdio>
+
+#include "MemoryStats.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+namespace {
+
+std::atomic<size_t> catBytes[MemoryStats::NumCategories];
+std::atomic<size_t> catPeaks[MemoryStats::NumCategories];
+std::atomic<size_t> curTotal(0);
+std::atomic<size_t> peakTotal(0);
+
+
+inline void
+raisePeak(std::atomic<size_t> &peak, size_t val)
+{
+    size_t old = peak.load(std::memory_order_relaxed);
+    while ((old < val) &&
+            !peak.compare_exchange_weak(old, val, std::memory_order_relaxed)) {
+    }
+}
+
+
+inline double
+toMB(size_t numBytes)
+{
+    return double(numBytes) / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+std::atomic<int> MemoryStats::category_(MemoryStats::Other);
+
+
+void
+MemoryStats::allocated(Category cat, size_t numBytes)
+{
+    const size_t n = catBytes[cat].fetch_add(numBytes,
+        std::memory_order_relaxed) + numBytes;
+    raisePeak(catPeaks[cat], n);
+    const size_t total = curTotal.fetch_add(numBytes,
+        std::memory_order_relaxed) + numBytes;
+    raisePeak(peakTotal, total);
+}
+
+
+void
+MemoryStats::freed(Category cat, size_t numBytes)
+{
+    catBytes[cat].fetch_sub(numBytes, std::memory_order_relaxed);
+    curTotal.fetch_sub(numBytes, std::memory_order_relaxed);
+}
+
+
+size_t
+MemoryStats::bytes(Category cat)
+{
+    return catBytes[cat].load(std::memory_order_relaxed);
+}
+
+
+size_t
+MemoryStats::peakBytes(Category cat)
+{
+    return catPeaks[cat].load(std::memory_order_relaxed);
+}
+
+
+size_t
+MemoryStats::totalBytes()
+{
+    return curTotal.load(std::memory_order_relaxed);
+}
+
+
+size_t
+MemoryStats::peakTotalBytes()
+{
+    return peakTotal.load(std::memory_order_relaxed);
+}
+
+
+void
+MemoryStats::resetPeaks()
+{
+    for (int ii = 0; ii < NumCategories; ++ii) {
+        catPeaks[ii].store(catBytes[ii].load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+    }
+    peakTotal.store(curTotal.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+}
+
+
+const char *
+MemoryStats::categoryName(Category cat)
+{
+    static const char *names[NumCategories] = {
+        "Mesh",         // Mesh
+        "Topology",     // Topology
+        "Placement",    // Placement
+        "Fans",         // Fans
+        "DualEdges",    // DualEdges
+        "Output",       // Output
+        "Other"         // Other
+    };
+    return (cat < NumCategories) ? names[cat] : "?";
+}
+
+
+void
+MemoryStats::format(char *buf, size_t bufSize)
+{
+    if (0 == bufSize) {
+        return;
+    }
+    int len = snprintf(buf, bufSize, "%.1f/%.1f MB", toMB(totalBytes()),
+        toMB(peakTotalBytes()));
+    for (int ii = 0; (ii < NumCategories) && (0 <= len) &&
+            (size_t(len) < bufSize); ++ii) {
+        const Category cat = Category(ii);
+        if (0 != peakBytes(cat)) {
+            len += snprintf(buf + len, bufSize - len, ", %s %.1f/%.1f",
+                categoryName(cat), toMB(bytes(cat)), toMB(peakBytes(cat)));
+        }
+    }
+}
@@ -0,0 +1,251 @@
+/****************************************************************************
+ *
+ * class MemoryStats
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _MEMORYSTATS_H_
+#define _MEMORYSTATS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Process wide byte counts of the dual mesh containers.
+
+    The container typedefs in PluginTypes.h allocate through
+    CountingAllocator. Each allocation is charged to the category that is
+    current when it is made and is credited back to the same category when
+    it is freed. Code that builds a data structure sets its category with a
+    Scope. Allocations made outside of any Scope are charged to Other.
+
+    The current category is global, not per thread, so the parallelFor()
+    workers of a step are charged to the category of the step. The counters
+    are relaxed atomics.
+
+    Define DUALMESH_NO_MEMSTATS to use std::allocator and compile the
+    counting out.
+*/
+class MemoryStats {
+public:
+
+    //! Memory categories. Append new categories before NumCategories.
+    enum Category {
+        Mesh,       // gce vertices, tris and hard edges as loaded
+        Topology,   // validation, vertex cell lists and hard edge index
+        Placement,  // dual vertex locations
+        Fans,       // fan sorting and the incremental fan cache
+        DualEdges,  // dual edges and agglomeration levels
+        Output,     // buffers of the output writers
+        Other,
+        NumCategories
+    };
+
+    //! Makes cat the current category until the Scope is destroyed
+    class Scope {
+    public:
+        explicit Scope(Category cat) :
+            prev_(MemoryStats::category())
+        {
+            MemoryStats::setCategory(cat);
+        }
+
+        ~Scope()
+        {
+            MemoryStats::setCategory(prev_);
+        }
+
+    private:
+        Scope(const Scope &);
+        Scope & operator=(const Scope &);
+
+        Category    prev_;
+    };
+
+    static inline Category
+    category()
+    {
+        return Category(category_.load(std::memory_order_relaxed));
+    }
+
+
+    static inline void
+    setCategory(Category cat)
+    {
+        category_.store(cat, std::memory_order_relaxed);
+    }
+
+
+    static void         allocated(Category cat, size_t numBytes);
+    static void         freed(Category cat, size_t numBytes);
+
+    //! Bytes currently allocated in cat
+    static size_t       bytes(Category cat);
+
+    //! Most bytes allocated in cat since the last resetPeaks()
+    static size_t       peakBytes(Category cat);
+
+    //! Bytes currently allocated in all categories
+    static size_t       totalBytes();
+
+    //! Most bytes allocated in all categories at the same time since the
+    //! last resetPeaks()
+    static size_t       peakTotalBytes();
+
+    //! Sets every peak to the current byte count. The current byte counts
+    //! are never reset, since live containers will still free their memory.
+    static void         resetPeaks();
+
+    static const char * categoryName(Category cat);
+
+    //! Writes "total now/peak MB" and the now/peak MB of each non-empty
+    //! category to buf.
+    static void         format(char *buf, size_t bufSize);
+
+private:
+
+    static std::atomic<int>     category_;
+};
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Allocator that charges its blocks to the current MemoryStats category.
+
+    Each block has a small header in front of it that holds the category it
+    was charged to, so a block is always credited back to the right category
+    even if the container was swapped or the current category changed. The
+    allocator is stateless and all instances compare equal.
+*/
+template<typename T>
+class CountingAllocator {
+public:
+
+    typedef T                   value_type;
+    typedef T *                 pointer;
+    typedef const T *           const_pointer;
+    typedef T &                 reference;
+    typedef const T &           const_reference;
+    typedef size_t              size_type;
+    typedef std::ptrdiff_t      difference_type;
+
+    template<typename U>
+    struct rebind {
+        typedef CountingAllocator<U> other;
+    };
+
+    //! Header bytes in front of each block. Keeps the block aligned for any
+    //! type the containers hold.
+    enum { HeaderSize = 16 };
+
+    CountingAllocator() {}
+    CountingAllocator(const CountingAllocator &) {}
+
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U> &) {}
+
+    pointer
+    address(reference x) const
+    {
+        return &x;
+    }
+
+
+    const_pointer
+    address(const_reference x) const
+    {
+        return &x;
+    }
+
+
+    pointer
+    allocate(size_type n, const void * = 0)
+    {
+        if (n > max_size()) {
+            throw std::bad_alloc();
+        }
+        const size_t numBytes = n * sizeof(T);
+        char *block =
+            static_cast<char*>(::operator new(HeaderSize + numBytes));
+        const MemoryStats::Category cat = MemoryStats::category();
+        *reinterpret_cast<int*>(block) = cat;
+        MemoryStats::allocated(cat, numBytes);
+        return reinterpret_cast<pointer>(block + HeaderSize);
+    }
+
+
+    void
+    deallocate(pointer p, size_type n)
+    {
+        if (0 != p) {
+            char *block = reinterpret_cast<char*>(p) - HeaderSize;
+            MemoryStats::freed(
+                MemoryStats::Category(*reinterpret_cast<int*>(block)),
+                n * sizeof(T));
+            ::operator delete(block);
+        }
+    }
+
+
+    size_type
+    max_size() const
+    {
+        return (std::numeric_limits<size_type>::max() - HeaderSize) /
+            sizeof(T);
+    }
+
+
+    template<typename U, typename... Args>
+    void
+    construct(U *p, Args&&... args)
+    {
+        ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+
+    template<typename U>
+    void
+    destroy(U *p)
+    {
+        p->~U();
+    }
+};
+
+
+template<typename T, typename U>
+inline bool
+operator==(const CountingAllocator<T> &, const CountingAllocator<U> &)
+{
+    return true;
+}
+
+
+template<typename T, typename U>
+inline bool
+operator!=(const CountingAllocator<T> &, const CountingAllocator<U> &)
+{
+    return false;
+}
+
+
+#if defined(DUALMESH_NO_MEMSTATS)
+#   define DUAL_ALLOCATOR(T)    std::allocator<T >
+#else
+#   define DUAL_ALLOCATOR(T)    CountingAllocator<T >
+#endif
+
+#endif // _MEMORYSTATS_H_
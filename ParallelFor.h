@@ -0,0 +1,67 @@
+/****************************************************************************
+ *
+ * parallelFor
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _PARALLELFOR_H_
+#define _PARALLELFOR_H_
+
+#include <thread>
+#include <vector>
+
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+//! Returns the number of workers parallelFor() will use for numItems.
+inline UInt32
+parallelWorkerCount(UInt32 numItems, UInt32 minChunk = 4096)
+{
+    UInt32 hw = UInt32(std::thread::hardware_concurrency());
+    if (0 == hw) {
+        hw = 1;
+    }
+    const UInt32 maxWorkers = (numItems + minChunk - 1) / minChunk;
+    return (0 == maxWorkers) ? 1 : ((hw < maxWorkers) ? hw : maxWorkers);
+}
+
+
+/*! Splits [0, numItems) into one contiguous range per worker and calls
+    func(begin, end, worker) for each range. The last range runs on the
+    calling thread. Returns after all ranges are done.
+
+    func must be safe to call concurrently for different workers.
+*/
+template<typename Func>
+void
+parallelFor(UInt32 numItems, UInt32 numWorkers, Func func)
+{
+    if (numWorkers <= 1) {
+        func(UInt32(0), numItems, UInt32(0));
+        return;
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(numWorkers - 1);
+    const UInt32 chunk = (numItems + numWorkers - 1) / numWorkers;
+    UInt32 begin = 0;
+    for (UInt32 worker = 0; worker + 1 < numWorkers; ++worker) {
+        const UInt32 end = (numItems - begin < chunk) ? numItems :
+            begin + chunk;
+        threads.push_back(std::thread(func, begin, end, worker));
+        begin = end;
+    }
+    func(begin, numItems, numWorkers - 1);
+    for (size_t ii = 0; ii < threads.size(); ++ii) {
+        threads[ii].join();
+    }
+}
+
+#endif // _PARALLELFOR_H_
@@ -12,29 +12,41 @@
 #define _PLUGINTYPES_H_
 
 #include <cassert>
+#include <functional>
 #include <map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#if !defined(_MSC_VER) || _MSC_VER >= 1600
+#   include <stdint.h>  // intptr_t
+#endif
+
 #include "cml.h"
+#include "MemoryStats.h"
 
-#if defined(WINDOWS) && _MSC_VER < 1600
-#   define STDTR1 std::tr1
-#else
-#   define STDTR1 std
-#endif
+// These types are shared by the plugin and the host-independent dual mesh
+// library. They must NOT depend on any Pointwise SDK header. UInt32 is layout
+// compatible with PWP_UINT32.
+typedef unsigned char                               UInt8;
+typedef unsigned int                                UInt32;
+static const UInt32                                 UInt32Undef = ~UInt32(0);
 
 typedef cml::vector3d                               Vec3;
-typedef cml::vector<PWP_UINT32, cml::fixed<2> >     Edge;
-
-typedef std::vector<PWP_UINT32>                     UInt32Array1;
-typedef std::vector<UInt32Array1>                   UInt32Array2;
-typedef std::vector<Edge>                           EdgeArray1;
-typedef std::map<Edge, PWP_UINT32>                  EdgeToUInt32Map;
-typedef std::map<PWP_UINT32, PWP_UINT32>            UInt32ToUInt32Map;
-typedef STDTR1::unordered_set<PWP_UINT32>           UInt32Set;
-typedef std::multimap<PWP_UINT32, PWP_UINT32>       UInt32UInt32Array1MMap;
+typedef cml::vector2d                               Vec2;
+typedef cml::vector<UInt32, cml::fixed<2> >         Edge;
+
+// The containers allocate through CountingAllocator. See MemoryStats.
+typedef std::pair<const UInt32, UInt32>             UInt32UInt32Pair;
+
+typedef std::vector<double, DUAL_ALLOCATOR(double)> DoubleArray1;
+typedef std::vector<float, DUAL_ALLOCATOR(float)>   FloatArray1;
+typedef std::vector<UInt8, DUAL_ALLOCATOR(UInt8)>   UInt8Array1;
+typedef std::vector<UInt32, DUAL_ALLOCATOR(UInt32)> UInt32Array1;
+typedef std::vector<UInt32Array1,
+            DUAL_ALLOCATOR(UInt32Array1)>           UInt32Array2;
+typedef std::vector<Edge, DUAL_ALLOCATOR(Edge)>     EdgeArray1;
+typedef std::map<UInt32, UInt32, std::less<UInt32>,
+            DUAL_ALLOCATOR(UInt32UInt32Pair)>       UInt32ToUInt32Map;
 
 
 #define fail(str)   assert(0 == intptr_t(str))
@@ -0,0 +1,372 @@
+/****************************************************************************
+ *
+ * class TopologyValidator
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+
+#include "ParallelFor.h"
+#include "TopologyValidator.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+struct TopologyValidator::Issue {
+    enum Kind {
+        BadVertIndex,       // tri, vert
+        RepeatedVert,       // tri, v0, v1, v2
+        ZeroArea,           // tri, v0, v1, v2
+        NonManifoldEdge,    // v0, v1, numTris, tri
+        FlippedEdge,        // v0, v1, tri0, tri1
+        OpenEdge,           // v0, v1, tri
+        BadHardEdge,        // v0, v1, cell
+        DanglingHardVert    // vert
+    };
+
+    Kind    kind_;
+    UInt32  a_;
+    UInt32  b_;
+    UInt32  c_;
+    UInt32  d_;
+
+    bool operator<(const Issue &rhs) const {
+        return (kind_ < rhs.kind_) || ((kind_ == rhs.kind_) &&
+            ((a_ < rhs.a_) || ((a_ == rhs.a_) && (b_ < rhs.b_))));
+    }
+};
+
+
+namespace {
+
+//! A tri edge keyed by its sorted vertex indices.
+struct HalfEdge {
+    UInt32  lo_;
+    UInt32  hi_;
+    UInt32  tri_;
+    bool    fwd_;   // true if tri walks the edge from lo_ to hi_
+
+    bool operator<(const HalfEdge &rhs) const {
+        return (lo_ < rhs.lo_) || ((lo_ == rhs.lo_) && (hi_ < rhs.hi_));
+    }
+};
+typedef std::vector<HalfEdge, DUAL_ALLOCATOR(HalfEdge)> HalfEdgeArray1;
+typedef std::vector<HalfEdgeArray1,
+            DUAL_ALLOCATOR(HalfEdgeArray1)>             HalfEdgeArray2;
+
+
+//! Max number of issues reported individually
+const UInt32 MaxReported = 25;
+
+
+inline bool
+isZeroArea(const TriMesh &mesh, const UInt32 *tri)
+{
+    const double *a = mesh.xyz(tri[0]);
+    const double *b = mesh.xyz(tri[1]);
+    const double *c = mesh.xyz(tri[2]);
+    const double ux = b[0] - a[0];
+    const double uy = b[1] - a[1];
+    const double uz = b[2] - a[2];
+    const double vx = c[0] - a[0];
+    const double vy = c[1] - a[1];
+    const double vz = c[2] - a[2];
+    const double wx = uy * vz - uz * vy;
+    const double wy = uz * vx - ux * vz;
+    const double wz = ux * vy - uy * vx;
+    // |u x v|^2 = |u|^2 |v|^2 sin^2(angle)
+    return (wx * wx + wy * wy + wz * wz) <= 1.0e-20 *
+        (ux * ux + uy * uy + uz * uz) * (vx * vx + vy * vy + vz * vz);
+}
+
+
+//! isZeroArea() of a tri of a planar mesh. u x v is (0, 0, wz).
+inline bool
+isZeroArea2D(const TriMesh &mesh, const UInt32 *tri)
+{
+    const double *a = mesh.xyz(tri[0]);
+    const double *b = mesh.xyz(tri[1]);
+    const double *c = mesh.xyz(tri[2]);
+    const double ux = b[0] - a[0];
+    const double uy = b[1] - a[1];
+    const double vx = c[0] - a[0];
+    const double vy = c[1] - a[1];
+    const double wz = ux * vy - uy * vx;
+    return (wz * wz) <= 1.0e-20 * (ux * ux + uy * uy) * (vx * vx + vy * vy);
+}
+
+} // namespace
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+TopologyValidator::TopologyValidator(const TriMesh &mesh) :
+    mesh_(mesh),
+    vertFlags_(),
+    errorCount_(0),
+    numHardVerts_(0),
+    numMultiHardVerts_(0)
+{
+}
+
+
+TopologyValidator::~TopologyValidator()
+{
+}
+
+
+bool
+TopologyValidator::run(const HardMidArray1 &bndryMids,
+    const HardMidArray1 &cnxnMids, DualMeshSink &sink)
+{
+    IssueArray1 issues;
+    UInt32Array1 openEdges;
+    checkTris(issues, openEdges);
+    checkHardEdges(bndryMids, cnxnMids, openEdges, issues);
+    report(issues, sink);
+    return 0 == errorCount_;
+}
+
+
+void
+TopologyValidator::checkTris(IssueArray1 &issues, UInt32Array1 &openEdges)
+{
+    const UInt32 numTris = mesh_.triCount();
+    const UInt32 numVerts = mesh_.vertexCount();
+    const UInt32 numWorkers = parallelWorkerCount(numTris);
+    const bool isPlanar = mesh_.isPlanar();
+    // Pass 1: check each tri and scatter its edges into one bucket per
+    // worker. An edge's bucket depends only on its lo vertex so all uses of
+    // an edge land in the same bucket.
+    std::vector<IssueArray1> workerIssues(numWorkers);
+    std::vector<HalfEdgeArray2> buckets(numWorkers,
+        HalfEdgeArray2(numWorkers));
+    parallelFor(numTris, numWorkers,
+        [&](UInt32 begin, UInt32 end, UInt32 worker) {
+            IssueArray1 &wIssues = workerIssues[worker];
+            HalfEdgeArray2 &wBuckets = buckets[worker];
+            for (UInt32 cell = begin; cell < end; ++cell) {
+                const UInt32 *tri = mesh_.tri(cell);
+                bool ok = true;
+                for (UInt32 ii = 0; ii < 3; ++ii) {
+                    if (tri[ii] >= numVerts) {
+                        Issue issue = { Issue::BadVertIndex, cell, tri[ii],
+                            0, 0 };
+                        wIssues.push_back(issue);
+                        ok = false;
+                    }
+                }
+                if (!ok) {
+                    continue;
+                }
+                if ((tri[0] == tri[1]) || (tri[1] == tri[2]) ||
+                        (tri[2] == tri[0])) {
+                    Issue issue = { Issue::RepeatedVert, cell, tri[0], tri[1],
+                        tri[2] };
+                    wIssues.push_back(issue);
+                    continue;
+                }
+                if (isPlanar ? isZeroArea2D(mesh_, tri) :
+                        isZeroArea(mesh_, tri)) {
+                    Issue issue = { Issue::ZeroArea, cell, tri[0], tri[1],
+                        tri[2] };
+                    wIssues.push_back(issue);
+                }
+                for (UInt32 ii = 0; ii < 3; ++ii) {
+                    const UInt32 v0 = tri[ii];
+                    const UInt32 v1 = tri[(ii + 1) % 3];
+                    HalfEdge he = { std::min(v0, v1), std::max(v0, v1), cell,
+                        v0 < v1 };
+                    wBuckets[he.lo_ % numWorkers].push_back(he);
+                }
+            }
+        });
+
+    // Pass 2: each worker sorts and scans whole buckets.
+    std::vector<IssueArray1> bucketIssues(numWorkers);
+    std::vector<UInt32Array1> bucketOpenEdges(numWorkers);
+    parallelFor(numWorkers, numWorkers,
+        [&](UInt32 begin, UInt32 end, UInt32 worker) {
+            IssueArray1 &wIssues = bucketIssues[worker];
+            UInt32Array1 &wOpen = bucketOpenEdges[worker];
+            HalfEdgeArray1 edges;
+            for (UInt32 b = begin; b < end; ++b) {
+                edges.clear();
+                for (UInt32 w = 0; w < numWorkers; ++w) {
+                    edges.insert(edges.end(), buckets[w][b].begin(),
+                        buckets[w][b].end());
+                    HalfEdgeArray1().swap(buckets[w][b]);
+                }
+                std::sort(edges.begin(), edges.end());
+                size_t ii = 0;
+                while (ii < edges.size()) {
+                    size_t jj = ii + 1;
+                    while ((jj < edges.size()) && !(edges[ii] < edges[jj])) {
+                        ++jj;
+                    }
+                    const HalfEdge &e = edges[ii];
+                    const size_t cnt = jj - ii;
+                    if (1 == cnt) {
+                        wOpen.push_back(e.lo_);
+                        wOpen.push_back(e.hi_);
+                        wOpen.push_back(e.tri_);
+                    }
+                    else if (2 < cnt) {
+                        Issue issue = { Issue::NonManifoldEdge, e.lo_, e.hi_,
+                            UInt32(cnt), e.tri_ };
+                        wIssues.push_back(issue);
+                    }
+                    else if (edges[ii + 1].fwd_ == e.fwd_) {
+                        Issue issue = { Issue::FlippedEdge, e.lo_, e.hi_,
+                            e.tri_, edges[ii + 1].tri_ };
+                        wIssues.push_back(issue);
+                    }
+                    ii = jj;
+                }
+            }
+        });
+
+    for (UInt32 w = 0; w < numWorkers; ++w) {
+        issues.insert(issues.end(), workerIssues[w].begin(),
+            workerIssues[w].end());
+        issues.insert(issues.end(), bucketIssues[w].begin(),
+            bucketIssues[w].end());
+        openEdges.insert(openEdges.end(), bucketOpenEdges[w].begin(),
+            bucketOpenEdges[w].end());
+    }
+}
+
+
+void
+TopologyValidator::checkHardEdges(const HardMidArray1 &bndryMids,
+    const HardMidArray1 &cnxnMids, const UInt32Array1 &openEdges,
+    IssueArray1 &issues)
+{
+    const UInt32 numVerts = mesh_.vertexCount();
+    const UInt32 numTris = mesh_.triCount();
+    UInt32Array1 hardEdgeCnt(numVerts, 0);
+    EdgeArray1 hardEdges;
+    hardEdges.reserve(bndryMids.size() + cnxnMids.size());
+    const HardMidArray1 *mids[2] = { &bndryMids, &cnxnMids };
+    for (int m = 0; m < 2; ++m) {
+        HardMidArray1::const_iterator it = mids[m]->begin();
+        for (; it != mids[m]->end(); ++it) {
+            const UInt32 v0 = it->edge_[0];
+            const UInt32 v1 = it->edge_[1];
+            bool ok = (v0 < numVerts) && (v1 < numVerts) && (v0 != v1) &&
+                (it->owner_ < numTris);
+            if (ok) {
+                // the owner cell must contain the edge
+                const UInt32 *tri = mesh_.tri(it->owner_);
+                ok = ((v0 == tri[0]) || (v0 == tri[1]) || (v0 == tri[2])) &&
+                    ((v1 == tri[0]) || (v1 == tri[1]) || (v1 == tri[2]));
+            }
+            if (!ok) {
+                Issue issue = { Issue::BadHardEdge, v0, v1, it->owner_, 0 };
+                issues.push_back(issue);
+                continue;
+            }
+            ++hardEdgeCnt[v0];
+            ++hardEdgeCnt[v1];
+            hardEdges.push_back(Edge(std::min(v0, v1), std::max(v0, v1)));
+        }
+    }
+    std::sort(hardEdges.begin(), hardEdges.end());
+
+    // every open tri edge must be a hard edge
+    for (size_t ii = 0; ii + 2 < openEdges.size(); ii += 3) {
+        const Edge e(openEdges[ii], openEdges[ii + 1]);
+        if (!std::binary_search(hardEdges.begin(), hardEdges.end(), e)) {
+            Issue issue = { Issue::OpenEdge, e[0], e[1], openEdges[ii + 2], 0 };
+            issues.push_back(issue);
+        }
+    }
+
+    vertFlags_.assign(numVerts, 0);
+    numHardVerts_ = 0;
+    numMultiHardVerts_ = 0;
+    for (UInt32 v = 0; v < numVerts; ++v) {
+        const UInt32 cnt = hardEdgeCnt[v];
+        if (0 == cnt) {
+            continue;
+        }
+        ++numHardVerts_;
+        vertFlags_[v] = HardVertFlag;
+        if (1 == cnt) {
+            Issue issue = { Issue::DanglingHardVert, v, 0, 0, 0 };
+            issues.push_back(issue);
+        }
+        else if (2 < cnt) {
+            vertFlags_[v] |= MultiHardVertFlag;
+            ++numMultiHardVerts_;
+        }
+    }
+}
+
+
+void
+TopologyValidator::report(IssueArray1 &issues, DualMeshSink &sink)
+{
+    errorCount_ = UInt32(issues.size());
+    std::sort(issues.begin(), issues.end());
+    char msg[256];
+    IssueArray1::const_iterator it = issues.begin();
+    for (UInt32 n = 0; (it != issues.end()) && (n < MaxReported); ++it, ++n) {
+        switch (it->kind_) {
+        case Issue::BadVertIndex:
+            sprintf(msg, "topology: tri %u has invalid vertex index %u",
+                it->a_, it->b_);
+            break;
+        case Issue::RepeatedVert:
+            sprintf(msg, "topology: tri %u is degenerate { %u %u %u }",
+                it->a_, it->b_, it->c_, it->d_);
+            break;
+        case Issue::ZeroArea:
+            sprintf(msg, "topology: tri %u has zero area { %u %u %u }",
+                it->a_, it->b_, it->c_, it->d_);
+            break;
+        case Issue::NonManifoldEdge:
+            sprintf(msg, "topology: edge { %u %u } is used by %u tris "
+                "(non-manifold) including tri %u", it->a_, it->b_, it->c_,
+                it->d_);
+            break;
+        case Issue::FlippedEdge:
+            sprintf(msg, "topology: tris %u and %u have inconsistent "
+                "orientation at edge { %u %u }", it->c_, it->d_, it->a_,
+                it->b_);
+            break;
+        case Issue::OpenEdge:
+            sprintf(msg, "topology: open edge { %u %u } of tri %u is not a "
+                "boundary or connection edge", it->a_, it->b_, it->c_);
+            break;
+        case Issue::BadHardEdge:
+            sprintf(msg, "topology: hard edge { %u %u } is not an edge of "
+                "cell %u", it->a_, it->b_, it->c_);
+            break;
+        case Issue::DanglingHardVert:
+            sprintf(msg, "topology: vertex %u is touched by only one hard edge",
+                it->a_);
+            break;
+        }
+        sink.errorMsg(msg);
+    }
+    if (MaxReported < errorCount_) {
+        sprintf(msg, "topology: %u more errors not shown",
+            errorCount_ - MaxReported);
+        sink.errorMsg(msg);
+    }
+    if (0 < numMultiHardVerts_) {
+        sprintf(msg, "topology: %u vertices are touched by more than 2 hard "
+            "edges", numMultiHardVerts_);
+        sink.infoMsg(msg);
+    }
+}
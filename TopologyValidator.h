@@ -0,0 +1,102 @@
+/****************************************************************************
+ *
+ * class TopologyValidator
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _TOPOLOGYVALIDATOR_H_
+#define _TOPOLOGYVALIDATOR_H_
+
+#include "DualMeshSink.h"
+#include "DualPlacement.h"
+#include "PluginTypes.h"
+#include "TriMesh.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! Checks the tri mesh and hard edge topology before the dual is built.
+
+    The tri and edge sweeps run in parallel. Detected problems:
+      - tris with an invalid, repeated or collinear vertex
+      - tri edges used by more than 2 tris (non-manifold)
+      - tri edges used twice in the same direction (inconsistent orientation)
+      - open tri edges that are not boundary/connection edges
+      - hard vertices touched by a single hard edge
+    Vertices with more than 2 hard edges are legal. They are counted and
+    flagged so the GCE vertex classification can use them directly.
+
+    On success, vertFlags() classifies every vertex for the later stages.
+*/
+class TopologyValidator {
+public:
+
+    enum VertFlag {
+        HardVertFlag        = 0x01, //!< touched by a boundary/connection edge
+        MultiHardVertFlag   = 0x02  //!< touched by more than 2 hard edges
+    };
+
+    TopologyValidator(const TriMesh &mesh);
+    ~TopologyValidator();
+
+    //! Validates the mesh. Problems are reported with sink.errorMsg(). Returns
+    //! false if any errors were found.
+    bool                run(const HardMidArray1 &bndryMids,
+                            const HardMidArray1 &cnxnMids, DualMeshSink &sink);
+
+    inline UInt32
+    errorCount() const
+    {
+        return errorCount_;
+    }
+
+
+    inline UInt32
+    hardVertCount() const
+    {
+        return numHardVerts_;
+    }
+
+
+    inline UInt32
+    multiHardVertCount() const
+    {
+        return numMultiHardVerts_;
+    }
+
+
+    //! Per vertex VertFlag bits. Valid after a successful run().
+    inline UInt8Array1 &
+    vertFlags()
+    {
+        return vertFlags_;
+    }
+
+
+private:
+
+    struct Issue;
+    typedef std::vector<Issue>  IssueArray1;
+
+    void        checkTris(IssueArray1 &issues, UInt32Array1 &openEdges);
+    void        checkHardEdges(const HardMidArray1 &bndryMids,
+                    const HardMidArray1 &cnxnMids, const UInt32Array1 &openEdges,
+                    IssueArray1 &issues);
+    void        report(IssueArray1 &issues, DualMeshSink &sink);
+
+private:
+
+    const TriMesh & mesh_;
+    UInt8Array1     vertFlags_;
+    UInt32          errorCount_;
+    UInt32          numHardVerts_;
+    UInt32          numMultiHardVerts_;
+};
+
+#endif // _TOPOLOGYVALIDATOR_H_
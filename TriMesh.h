@@ -0,0 +1,170 @@
+/****************************************************************************
+ *
+ * class TriMesh
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _TRIMESH_H_
+#define _TRIMESH_H_
+
+#include "PluginTypes.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! A read-only view of a 2D triangle mesh stored as plain arrays.
+
+    The coordinate array holds 3 doubles (x,y,z) per vertex. The triangle
+    array holds 3 vertex indices per triangle with a right-handed winding.
+    TriMesh does NOT own the arrays. They may reside in a std::vector or in a
+    memory mapped file.
+
+    If findPlane() finds that every vertex has the same z, isPlanar() is set
+    and the placement, turning angle and validation kernels skip the z
+    component. Their results get z = planeZ().
+*/
+class TriMesh {
+public:
+    TriMesh(const double *xyz = 0, UInt32 numVerts = 0, const UInt32 *tris = 0,
+            UInt32 numTris = 0) :
+        xyz_(xyz),
+        numVerts_(numVerts),
+        tris_(tris),
+        numTris_(numTris),
+        isPlanar_(false),
+        planeZ_(0.0)
+    {
+    }
+
+
+    ~TriMesh(){}
+
+
+    inline UInt32
+    vertexCount() const
+    {
+        return numVerts_;
+    }
+
+
+    inline UInt32
+    triCount() const
+    {
+        return numTris_;
+    }
+
+
+    inline const double *
+    xyz(UInt32 vertNdx) const
+    {
+        return xyz_ + 3 * size_t(vertNdx);
+    }
+
+
+    inline const UInt32 *
+    tri(UInt32 triNdx) const
+    {
+        return tris_ + 3 * size_t(triNdx);
+    }
+
+
+    //! True if findPlane() found all vertices at z = planeZ()
+    inline bool
+    isPlanar() const
+    {
+        return isPlanar_;
+    }
+
+
+    inline double
+    planeZ() const
+    {
+        return planeZ_;
+    }
+
+
+    //! Scans the z values. Stops at the first z that differs.
+    void
+    findPlane()
+    {
+        isPlanar_ = (0 < numVerts_);
+        planeZ_ = isPlanar_ ? xyz_[2] : 0.0;
+        for (UInt32 ii = 1; isPlanar_ && (ii < numVerts_); ++ii) {
+            isPlanar_ = (xyz_[3 * size_t(ii) + 2] == planeZ_);
+        }
+    }
+
+
+    //! Sets the plane without a scan. For a mesh that shares the xyz array
+    //! of a mesh whose plane was found.
+    inline void
+    setPlane(bool isPlanar, double planeZ)
+    {
+        isPlanar_ = isPlanar;
+        planeZ_ = planeZ;
+    }
+
+
+    inline const double *
+    xyzArray() const
+    {
+        return xyz_;
+    }
+
+
+    inline const UInt32 *
+    triArray() const
+    {
+        return tris_;
+    }
+
+
+    bool
+    getCoord(UInt32 vertNdx, Vec3 &v) const
+    {
+        bool ret = (vertNdx < numVerts_);
+        if (ret) {
+            const double *p = xyz(vertNdx);
+            v.set(p[0], p[1], p[2]);
+        }
+        return ret;
+    }
+
+
+    bool
+    centroid(UInt32 triNdx, Vec3 &v) const
+    {
+        bool ret = (triNdx < numTris_);
+        if (ret) {
+            const UInt32 *t = tri(triNdx);
+            Vec3 v1;
+            Vec3 v2;
+            ret = getCoord(t[0], v) && getCoord(t[1], v1) &&
+                    getCoord(t[2], v2);
+            if (ret) {
+                ((v += v1) += v2) /= 3.0;
+            }
+            else {
+                v.zero();
+            }
+        }
+        return ret;
+    }
+
+
+private:
+    const double *  xyz_;
+    UInt32          numVerts_;
+    const UInt32 *  tris_;
+    UInt32          numTris_;
+    bool            isPlanar_;
+    double          planeZ_;
+};
+
+#endif // _TRIMESH_H_
@@ -0,0 +1,80 @@
+/****************************************************************************
+ *
+ * class TriMeshFile
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#include <cstring>
+
+#include "TriMeshFile.h"
+
+
+TriMeshFile::TriMeshFile() :
+    file_(),
+    mesh_(),
+    errMsg_(0)
+{
+}
+
+
+TriMeshFile::~TriMeshFile()
+{
+}
+
+
+const char *
+TriMeshFile::magic()
+{
+    return "DUALTRI1";
+}
+
+
+bool
+TriMeshFile::open(const char *filename)
+{
+    close();
+    if (!file_.open(filename)) {
+        errMsg_ = "could not map file";
+        return false;
+    }
+    const char *base = static_cast<const char*>(file_.data());
+    Header hdr;
+    if (file_.size() < sizeof(hdr)) {
+        errMsg_ = "file too small";
+    }
+    else {
+        memcpy(&hdr, base, sizeof(hdr));
+        const size_t xyzBytes = 3 * sizeof(double) * size_t(hdr.numVerts_);
+        const size_t triBytes = 3 * sizeof(UInt32) * size_t(hdr.numTris_);
+        if (0 != memcmp(hdr.magic_, magic(), sizeof(hdr.magic_))) {
+            errMsg_ = "bad magic";
+        }
+        else if (file_.size() < sizeof(hdr) + xyzBytes + triBytes) {
+            errMsg_ = "file truncated";
+        }
+        else {
+            const double *xyz =
+                reinterpret_cast<const double*>(base + sizeof(hdr));
+            const UInt32 *tris =
+                reinterpret_cast<const UInt32*>(base + sizeof(hdr) + xyzBytes);
+            mesh_ = TriMesh(xyz, hdr.numVerts_, tris, hdr.numTris_);
+        }
+    }
+    if (0 != errMsg_) {
+        file_.close();
+    }
+    return 0 == errMsg_;
+}
+
+
+void
+TriMeshFile::close()
+{
+    file_.close();
+    mesh_ = TriMesh();
+    errMsg_ = 0;
+}
@@ -0,0 +1,76 @@
+/****************************************************************************
+ *
+ * class TriMeshFile
+ *
+ * Proprietary software product of Pointwise, Inc.
+ * Copyright (c) 1995-2013 Pointwise, Inc.
+ * All rights reserved.
+ *
+ ***************************************************************************/
+
+#ifndef _TRIMESHFILE_H_
+#define _TRIMESHFILE_H_
+
+#include "MappedFile.h"
+#include "PluginTypes.h"
+#include "TriMesh.h"
+
+
+//***************************************************************************
+//***************************************************************************
+//***************************************************************************
+
+/*! A memory mapped binary tri mesh file.
+
+    The file layout is (native byte order):
+
+        char    magic[8]            "DUALTRI1"
+        UInt32  numVerts
+        UInt32  numTris
+        UInt32  reserved[2]         must be 0
+        double  xyz[numVerts][3]
+        UInt32  tris[numTris][3]    right-handed, 0-based vertex indices
+
+    The TriMesh returned by mesh() points directly into the mapping. No
+    coordinate or connectivity data is copied.
+*/
+class TriMeshFile {
+public:
+
+    struct Header {
+        char    magic_[8];
+        UInt32  numVerts_;
+        UInt32  numTris_;
+        UInt32  reserved_[2];
+    };
+
+    TriMeshFile();
+    ~TriMeshFile();
+
+    bool            open(const char *filename);
+    void            close();
+
+    inline const TriMesh &
+    mesh() const
+    {
+        return mesh_;
+    }
+
+
+    inline const char *
+    errorMsg() const
+    {
+        return errMsg_;
+    }
+
+
+    static const char * magic();
+
+private:
+
+    MappedFile      file_;
+    TriMesh         mesh_;
+    const char *    errMsg_;
+};
+
+#endif // _TRIMESHFILE_H_
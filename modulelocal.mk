@@ -25,7 +25,30 @@
 #    sub/myOtherFile.cxx is located in $(CaeUnsDualMesh_LOC)/sub/myOtherFile.cxx
 #
 CaeUnsDualMesh_CXXFILES_PRIVATE := \
+    DualAgglomerator.cxx \
+    DualCellQuery.cxx \
+    DualCostEstimator.cxx \
+    DualEdgeBuilder.cxx \
+    DualFanCache.cxx \
+    DualMeshBuilder.cxx \
+    DualMeshBvhWriter.cxx \
+    DualMeshChunkWriter.cxx \
+    DualMeshMemoryMonitor.cxx \
+    DualMeshMirror.cxx \
+    DualMeshPartWriter.cxx \
+    DualMeshShmWriter.cxx \
+    DualMeshTclWriter.cxx \
+    DualMeshVtuWriter.cxx \
+    DualPartitioner.cxx \
+    DualPlacement.cxx \
+    DualPolyBvh.cxx \
+    DualRegion.cxx \
+    DualTrace.cxx \
+    DualVariant.cxx \
     FanSorter.cxx \
+    HardEdgeIndex.cxx \
+    MemoryStats.cxx \
+    TopologyValidator.cxx \
     $(NULL)
 
 #-----------------------------------------------------------------------
@@ -73,6 +96,93 @@ CaeUnsDualMesh_CXXFLAGS_PRIVATE := \
 #CaeUnsDualMesh_MAINT_TARGETS_PRIVATE = \
 #	$(NULL)
 
+#-----------------------------------------------------------------------
+# Standalone dualmesh command line tool. The dual mesh library sources do not
+# use the Pointwise SDK and only need the cml headers.
+#
+#   make CaeUnsDualMesh_cli
+#
+CaeUnsDualMesh_CLI_CXXFILES := \
+    $(CaeUnsDualMesh_LOC)/DualAgglomerator.cxx \
+    $(CaeUnsDualMesh_LOC)/DualCellQuery.cxx \
+    $(CaeUnsDualMesh_LOC)/DualCostEstimator.cxx \
+    $(CaeUnsDualMesh_LOC)/DualEdgeBuilder.cxx \
+    $(CaeUnsDualMesh_LOC)/DualFanCache.cxx \
+    $(CaeUnsDualMesh_LOC)/DualMeshBuilder.cxx \
+    $(CaeUnsDualMesh_LOC)/DualMeshBvhWriter.cxx \
+    $(CaeUnsDualMesh_LOC)/DualMeshChunkWriter.cxx \
+    $(CaeUnsDualMesh_LOC)/DualMeshCli.cxx \
+    $(CaeUnsDualMesh_LOC)/DualMeshMemoryMonitor.cxx \
+    $(CaeUnsDualMesh_LOC)/DualMeshMirror.cxx \
+    $(CaeUnsDualMesh_LOC)/DualMeshPartWriter.cxx \
+    $(CaeUnsDualMesh_LOC)/DualMeshShmWriter.cxx \
+    $(CaeUnsDualMesh_LOC)/DualMeshTclWriter.cxx \
+    $(CaeUnsDualMesh_LOC)/DualMeshVtuWriter.cxx \
+    $(CaeUnsDualMesh_LOC)/DualPartitioner.cxx \
+    $(CaeUnsDualMesh_LOC)/DualPlacement.cxx \
+    $(CaeUnsDualMesh_LOC)/DualPolyBvh.cxx \
+    $(CaeUnsDualMesh_LOC)/DualRegion.cxx \
+    $(CaeUnsDualMesh_LOC)/DualTrace.cxx \
+    $(CaeUnsDualMesh_LOC)/DualVariant.cxx \
+    $(CaeUnsDualMesh_LOC)/FanSorter.cxx \
+    $(CaeUnsDualMesh_LOC)/HardEdgeIndex.cxx \
+    $(CaeUnsDualMesh_LOC)/MappedFile.cxx \
+    $(CaeUnsDualMesh_LOC)/MemoryStats.cxx \
+    $(CaeUnsDualMesh_LOC)/TopologyValidator.cxx \
+    $(CaeUnsDualMesh_LOC)/TriMeshFile.cxx \
+    $(NULL)
+
+CaeUnsDualMesh_CLI_TARGET := $(CaeUnsDualMesh_LOC)/dualmesh
+
+CaeUnsDualMesh_cli: $(CaeUnsDualMesh_CLI_CXXFILES)
+	$(CXX) -O2 -std=c++0x -pthread -I$(CaeUnsDualMesh_LOC)/../cml -o $(CaeUnsDualMesh_CLI_TARGET) $(CaeUnsDualMesh_CLI_CXXFILES)
+
+#-----------------------------------------------------------------------
+# Trace file decoder. Prints a DebugDump / dualmesh -t trace file as text.
+#
+#   make CaeUnsDualMesh_tracedecode
+#
+CaeUnsDualMesh_TRACE_CXXFILES := \
+    $(CaeUnsDualMesh_LOC)/DualTrace.cxx \
+    $(CaeUnsDualMesh_LOC)/DualTraceDecode.cxx \
+    $(CaeUnsDualMesh_LOC)/MappedFile.cxx \
+    $(NULL)
+
+CaeUnsDualMesh_tracedecode: $(CaeUnsDualMesh_TRACE_CXXFILES)
+	$(CXX) -O2 -std=c++0x -pthread -I$(CaeUnsDualMesh_LOC)/../cml -o $(CaeUnsDualMesh_LOC)/dualtrace $(CaeUnsDualMesh_TRACE_CXXFILES)
+
+#-----------------------------------------------------------------------
+# Reference shared memory consumer. Validates and summarizes a dual mesh
+# published with the SharedMemory attribute or dualmesh shm:name.
+#
+#   make CaeUnsDualMesh_shmconsumer
+#
+CaeUnsDualMesh_SHM_CXXFILES := \
+    $(CaeUnsDualMesh_LOC)/DualMeshShmWriter.cxx \
+    $(CaeUnsDualMesh_LOC)/DualShmConsumer.cxx \
+    $(CaeUnsDualMesh_LOC)/MemoryStats.cxx \
+    $(NULL)
+
+CaeUnsDualMesh_shmconsumer: $(CaeUnsDualMesh_SHM_CXXFILES)
+	$(CXX) -O2 -std=c++0x -pthread -I$(CaeUnsDualMesh_LOC)/../cml -o $(CaeUnsDualMesh_LOC)/dualshm $(CaeUnsDualMesh_SHM_CXXFILES)
+
+#-----------------------------------------------------------------------
+# DualCellQuery test. Runs queries on a small grid with and without an
+# inconsistently oriented tri. Exits with a failure status if a query
+# result is wrong.
+#
+#   make CaeUnsDualMesh_querytest
+#
+CaeUnsDualMesh_QUERYTEST_CXXFILES := \
+    $(filter-out $(CaeUnsDualMesh_LOC)/DualMeshCli.cxx, \
+        $(CaeUnsDualMesh_CLI_CXXFILES)) \
+    $(CaeUnsDualMesh_LOC)/DualCellQueryTest.cxx \
+    $(NULL)
+
+CaeUnsDualMesh_querytest: $(CaeUnsDualMesh_QUERYTEST_CXXFILES)
+	$(CXX) -O2 -std=c++0x -pthread -I$(CaeUnsDualMesh_LOC)/../cml -o $(CaeUnsDualMesh_LOC)/dualquerytest $(CaeUnsDualMesh_QUERYTEST_CXXFILES)
+	$(CaeUnsDualMesh_LOC)/dualquerytest
+
 #-----------------------------------------------------------------------
 # Sample macro. Prefix with CAE name to prevent conflicts.
 #
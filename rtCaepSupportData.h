@@ -29,7 +29,9 @@ CAEP_VCINFO CaeUnsDualMeshVCInfo[] = {
 };
 /*------------------------------------*/
 const char *CaeUnsDualMeshFileExt[] = {
-    "glf"
+    "glf",
+    "vtu",
+    "dmc"
 };
 
 /*! \endcond */